@@ -0,0 +1,37 @@
+# Writes compiled SPIR-V as constexpr array of words, run by build step of built-in shaders
+# Expects SPIRV_FILE, HEADER_FILE and VARIABLE_NAME
+file(READ "${SPIRV_FILE}" spirvHex HEX)
+string(LENGTH "${spirvHex}" hexLength)
+math(EXPR remainder "${hexLength} % 8")
+if (hexLength EQUAL 0 OR NOT remainder EQUAL 0)
+    message(FATAL_ERROR "${SPIRV_FILE} is not valid SPIR-V")
+endif()
+
+set(words "")
+set(wordsInLine 0)
+math(EXPR lastOffset "${hexLength} - 8")
+foreach(offset RANGE 0 ${lastOffset} 8)
+    # Words are stored little endian, so bytes are reversed to get their value
+    string(SUBSTRING "${spirvHex}" ${offset} 8 word)
+    string(REGEX REPLACE "(..)(..)(..)(..)" "\\4\\3\\2\\1" word "${word}")
+    if (wordsInLine EQUAL 0)
+        string(APPEND words "   ")
+    endif()
+    string(APPEND words " 0x${word},")
+    math(EXPR wordsInLine "${wordsInLine} + 1")
+    if (wordsInLine EQUAL 8)
+        string(APPEND words "\n")
+        set(wordsInLine 0)
+    endif()
+endforeach()
+if (NOT wordsInLine EQUAL 0)
+    string(APPEND words "\n")
+endif()
+
+file(WRITE "${HEADER_FILE}"
+     "#pragma once\n"
+     "// Generated at build time from ${SPIRV_FILE}, do not edit\n"
+     "\n"
+     "inline constexpr UInt32 ${VARIABLE_NAME}[] = {\n"
+     "${words}"
+     "};\n")
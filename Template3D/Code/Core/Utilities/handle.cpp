@@ -6,11 +6,13 @@
 #include "Resource/Common/mesh.hpp"
 #include "Resource/Common/model.hpp"
 #include "Resource/Common/material.hpp"
+#include "Resource/Common/bvh.hpp"
 
 #include "Render/Vulkan/vulkan_api.hpp"
 #include "Render/OpenGL/opengl_api.hpp"
 
 const Handle<DisplayManager::Window> Handle<DisplayManager::Window>::NONE = { UInt64(-1) };
+const Handle<BVHInstance>            Handle<BVHInstance>::NONE            = { UInt64(-1) };
 
 const Handle<Model<Vulkan>>          Handle<Model<Vulkan>>::NONE          = { UInt64(-1) };
 const Handle<Mesh<Vulkan>>           Handle<Mesh<Vulkan>>::NONE           = { UInt64(-1) };
@@ -21,6 +23,7 @@ const Handle<Vulkan::Buffer>         Handle<Vulkan::Buffer>::NONE         = { UI
 const Handle<Vulkan::Shader>         Handle<Vulkan::Shader>::NONE         = { UInt64(-1) };
 const Handle<Vulkan::Pipeline>       Handle<Vulkan::Pipeline>::NONE       = { UInt64(-1) };
 const Handle<Vulkan::ShaderSet>      Handle<Vulkan::ShaderSet>::NONE      = { UInt64(-1) };
+const Handle<Vulkan::ShaderPermutations> Handle<Vulkan::ShaderPermutations>::NONE = { UInt64(-1) };
 const Handle<DescriptorSetData>      Handle<DescriptorSetData>::NONE      = { UInt64(-1) };
 const Handle<DescriptorLayoutData>   Handle<DescriptorLayoutData>::NONE   = { UInt64(-1) };
 const Handle<CommandBuffer>          Handle<CommandBuffer>::NONE          = { UInt64(-1) };
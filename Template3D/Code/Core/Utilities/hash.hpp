@@ -0,0 +1,30 @@
+#pragma once
+// 64 bit FNV-1a, stable between runs and platforms so it can name files on disk
+constexpr UInt64 FNV_OFFSET_BASIS = 14695981039346656037ULL;
+constexpr UInt64 FNV_PRIME = 1099511628211ULL;
+
+inline UInt64 hash_bytes(const Void* data, UInt64 size, UInt64 seed = FNV_OFFSET_BASIS)
+{
+    const UInt8* bytes = static_cast<const UInt8*>(data);
+    UInt64 hash = seed;
+    for (UInt64 i = 0; i < size; ++i)
+    {
+        hash ^= bytes[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+inline UInt64 hash_string(const String& text, UInt64 seed = FNV_OFFSET_BASIS)
+{
+    // Size is hashed too, so concatenated strings with different splits do not collide
+    const UInt64 size = text.size();
+    return hash_bytes(text.data(), size, hash_bytes(&size, sizeof(size), seed));
+}
+
+template <typename Type>
+UInt64 hash_value(const Type& value, UInt64 seed = FNV_OFFSET_BASIS)
+{
+    static_assert(std::is_trivially_copyable_v<Type>, "Only trivially copyable types can be hashed by bytes");
+    return hash_bytes(&value, sizeof(Type), seed);
+}
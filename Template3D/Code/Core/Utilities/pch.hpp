@@ -3,6 +3,7 @@
 #include <optional>
 #include <vector>
 #include <list>
+#include <queue>
 #include <array>
 #include <unordered_map>
 #include <map>
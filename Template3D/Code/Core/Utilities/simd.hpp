@@ -0,0 +1,9 @@
+#pragma once
+// Widest instruction set enabled by compiler flags, kernels have to provide scalar fallback
+#if defined(__AVX2__)
+    #define SIMD_AVX2 1
+    #include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define SIMD_SSE 1
+    #include <emmintrin.h>
+#endif
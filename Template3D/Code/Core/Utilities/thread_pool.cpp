@@ -0,0 +1,144 @@
+#include "thread_pool.hpp"
+
+
+Void ThreadPool::startup(UInt32 threadsCount)
+{
+    if (isRunning)
+    {
+        SPDLOG_WARN("Thread pool is already running.");
+        return;
+    }
+
+    if (threadsCount == 0)
+    {
+        const UInt32 hardwareThreads = std::thread::hardware_concurrency();
+        threadsCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+    }
+
+    isRunning = true;
+    workers.reserve(threadsCount);
+    for (UInt32 i = 0; i < threadsCount; ++i)
+    {
+        workers.emplace_back(&ThreadPool::worker_loop, this);
+    }
+    backgroundWorker = std::thread(&ThreadPool::background_loop, this);
+}
+
+Void ThreadPool::parallel_for(UInt64 count, UInt64 batchSize, const std::function<Void(UInt64, UInt64)>& function)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    batchSize = std::max(batchSize, UInt64(1));
+    const UInt64 batchesCount = std::min((count + batchSize - 1) / batchSize, UInt64(workers.size()) + 1);
+    if (batchesCount <= 1)
+    {
+        function(0, count);
+        return;
+    }
+
+    const UInt64 rangeSize = (count + batchesCount - 1) / batchesCount;
+    DynamicArray<std::future<Void>> results;
+    results.reserve(batchesCount - 1);
+    for (UInt64 begin = rangeSize; begin < count; begin += rangeSize)
+    {
+        const UInt64 end = std::min(begin + rangeSize, count);
+        results.push_back(submit([&function, begin, end]() { function(begin, end); }));
+    }
+
+    function(0, std::min(rangeSize, count));
+
+    for (std::future<Void>& result : results)
+    {
+        wait(result);
+    }
+}
+
+UInt32 ThreadPool::get_threads_count() const
+{
+    return UInt32(workers.size());
+}
+
+Void ThreadPool::shutdown()
+{
+    {
+        std::scoped_lock lock(tasksMutex);
+        isRunning = false;
+    }
+    tasksCondition.notify_all();
+    backgroundCondition.notify_all();
+
+    for (std::thread& worker : workers)
+    {
+        worker.join();
+    }
+    workers.clear();
+    if (backgroundWorker.joinable())
+    {
+        backgroundWorker.join();
+    }
+}
+
+Bool ThreadPool::try_run_own_task()
+{
+    std::function<Void()> task;
+    {
+        std::scoped_lock lock(tasksMutex);
+        const std::thread::id owner = std::this_thread::get_id();
+        const auto iterator = std::find_if(tasks.begin(), tasks.end(), [owner](const Task& queued)
+        {
+            return queued.owner == owner;
+        });
+        if (iterator == tasks.end())
+        {
+            return false;
+        }
+        task = std::move(iterator->function);
+        tasks.erase(iterator);
+    }
+
+    task();
+    return true;
+}
+
+Void ThreadPool::worker_loop()
+{
+    while (true)
+    {
+        std::function<Void()> task;
+        {
+            std::unique_lock lock(tasksMutex);
+            tasksCondition.wait(lock, [this]() { return !isRunning || !tasks.empty(); });
+            if (!isRunning && tasks.empty())
+            {
+                return;
+            }
+            task = std::move(tasks.front().function);
+            tasks.pop_front();
+        }
+
+        task();
+    }
+}
+
+Void ThreadPool::background_loop()
+{
+    while (true)
+    {
+        std::function<Void()> task;
+        {
+            std::unique_lock lock(tasksMutex);
+            backgroundCondition.wait(lock, [this]() { return !isRunning || !backgroundTasks.empty(); });
+            if (!isRunning && backgroundTasks.empty())
+            {
+                return;
+            }
+            task = std::move(backgroundTasks.front());
+            backgroundTasks.pop();
+        }
+
+        task();
+    }
+}
@@ -0,0 +1,92 @@
+#pragma once
+#include <thread>
+#include <future>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+
+/** Fixed set of worker threads shared by managers for CPU side work like culling or building,
+    long work which frame does not wait for runs on separate background thread */
+class ThreadPool
+{
+private:
+    struct Task
+    {
+        std::function<Void()> function;
+        // Waiting thread runs only tasks it submitted itself
+        std::thread::id owner;
+    };
+
+    DynamicArray<std::thread> workers;
+    List<Task> tasks;
+    std::mutex tasksMutex;
+    std::condition_variable tasksCondition;
+    Bool isRunning = false;
+
+    std::thread backgroundWorker;
+    Queue<std::function<Void()>> backgroundTasks;
+    std::condition_variable backgroundCondition;
+
+public:
+    // 0 means one worker less than hardware threads, calling thread is also doing work
+    Void startup(UInt32 threadsCount = 0);
+
+    template <typename Function>
+    std::future<std::invoke_result_t<Function>> submit(Function&& function)
+    {
+        using ResultType = std::invoke_result_t<Function>;
+        auto task = std::make_shared<std::packaged_task<ResultType()>>(std::forward<Function>(function));
+        std::future<ResultType> result = task->get_future();
+        {
+            std::scoped_lock lock(tasksMutex);
+            tasks.push_back({ [task]() { (*task)(); }, std::this_thread::get_id() });
+        }
+        tasksCondition.notify_one();
+
+        return result;
+    }
+
+    // Work like pipeline creation or shader reload, it never runs on workers or on thread waiting for frame tasks,
+    // result has to be polled or waited with future itself
+    template <typename Function>
+    std::future<std::invoke_result_t<Function>> submit_background(Function&& function)
+    {
+        using ResultType = std::invoke_result_t<Function>;
+        auto task = std::make_shared<std::packaged_task<ResultType()>>(std::forward<Function>(function));
+        std::future<ResultType> result = task->get_future();
+        {
+            std::scoped_lock lock(tasksMutex);
+            backgroundTasks.emplace([task]() { (*task)(); });
+        }
+        backgroundCondition.notify_one();
+
+        return result;
+    }
+
+    // Waiting thread executes queued tasks it submitted, so it is safe to wait inside of task
+    // and it is not delayed by unrelated work of other threads
+    template <typename ResultType>
+    Void wait(std::future<ResultType>& future)
+    {
+        while (future.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        {
+            if (!try_run_own_task())
+            {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    // Splits [0, count) into ranges not smaller than batchSize and runs them on workers and calling thread
+    Void parallel_for(UInt64 count, UInt64 batchSize, const std::function<Void(UInt64, UInt64)>& function);
+
+    [[nodiscard]]
+    UInt32 get_threads_count() const;
+
+    Void shutdown();
+
+private:
+    Bool try_run_own_task();
+    Void worker_loop();
+    Void background_loop();
+};
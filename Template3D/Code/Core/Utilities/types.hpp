@@ -27,6 +27,8 @@ using Optional	   = std::optional<Type>;
 template<typename Type>
 using List		   = std::list<Type>;
 template<typename Type>
+using Queue		   = std::queue<Type>;
+template<typename Type>
 using DynamicArray = std::vector<Type>;
 template<typename Type>
 using Set		   = std::set<Type>;
@@ -1,6 +1,7 @@
 #pragma once
 #include "Render/Common/graphics_api_concept.hpp"
 #include "Display/display_manager.hpp"
+#include "Utilities/thread_pool.hpp"
 
 template <GraphicsAPI GraphicsType>
 class ResourceManager;
@@ -14,6 +15,7 @@ public:
     ResourceManager<GraphicsAPI> resourceManager;
     RenderManager<GraphicsAPI> renderManager;
     DisplayManager displayManager;
+    ThreadPool threadPool;
 
 public:
     Void startup();
@@ -7,6 +7,7 @@
 template <typename GraphicsAPI>
 Void Simulation<GraphicsAPI>::startup()
 {
+    threadPool.startup();
     resourceManager.startup();
     displayManager.startup();
     renderManager.startup();
@@ -18,4 +19,5 @@ Void Simulation<GraphicsAPI>::shutdown()
     resourceManager.shutdown();
     displayManager.shutdown();
     renderManager.shutdown();
+    threadPool.shutdown();
 }
@@ -0,0 +1,258 @@
+#include "frustum_culler.hpp"
+
+#include "Resource/Common/bounds.hpp"
+#include "Utilities/thread_pool.hpp"
+#include "Utilities/simd.hpp"
+
+
+Void FrustumCuller::set_frustum(const FMatrix4& viewProjection)
+{
+    planes = s_extract_planes(viewProjection);
+    for (UInt64 i = 0; i < planes.size(); ++i)
+    {
+        absolutePlanes[i] = glm::abs(planes[i]);
+    }
+}
+
+Void FrustumCuller::clear()
+{
+    centersX.resize(0);
+    centersY.resize(0);
+    centersZ.resize(0);
+    extentsX.resize(0);
+    extentsY.resize(0);
+    extentsZ.resize(0);
+    radiuses.resize(0);
+    visibility.resize(0);
+    objectsCount = 0;
+}
+
+UInt64 FrustumCuller::add_bounds(const BoundingBox& box, const BoundingSphere& sphere, const FMatrix4& transform)
+{
+    const UInt64 index = objectsCount++;
+    if (centersX.size() < objectsCount)
+    {
+        centersX.resize(objectsCount);
+        centersY.resize(objectsCount);
+        centersZ.resize(objectsCount);
+        extentsX.resize(objectsCount);
+        extentsY.resize(objectsCount);
+        extentsZ.resize(objectsCount);
+        radiuses.resize(objectsCount);
+    }
+
+    // Transformed box is bounded by box with extent made of absolute matrix values
+    const FVector3 localCenter = (box.minimum + box.maximum) * 0.5f;
+    const FVector3 localExtent = (box.maximum - box.minimum) * 0.5f;
+    const FVector3 center = FVector3(transform * FVector4(localCenter, 1.0f));
+    FVector3 extent{ 0.0f };
+    for (Int32 column = 0; column < 3; ++column)
+    {
+        extent += FVector3(glm::abs(transform[column])) * localExtent[column];
+    }
+
+    const Float32 scale = std::max({ glm::length(FVector3(transform[0])),
+                                     glm::length(FVector3(transform[1])),
+                                     glm::length(FVector3(transform[2])) });
+
+    centersX[index] = center.x;
+    centersY[index] = center.y;
+    centersZ[index] = center.z;
+    extentsX[index] = extent.x;
+    extentsY[index] = extent.y;
+    extentsZ[index] = extent.z;
+    // Sphere radius is measured from box center, offset covers meshes created with other sphere centers
+    radiuses[index] = (sphere.radius + glm::length(sphere.center - localCenter)) * scale;
+
+    return index;
+}
+
+Void FrustumCuller::cull(ThreadPool* threadPool)
+{
+    if (objectsCount == 0)
+    {
+        return;
+    }
+
+    // Padding lets kernels process whole lanes without tail handling
+    const UInt64 paddedCount = (objectsCount + LANES_COUNT - 1) / LANES_COUNT * LANES_COUNT;
+    centersX.resize(paddedCount, 0.0f);
+    centersY.resize(paddedCount, 0.0f);
+    centersZ.resize(paddedCount, 0.0f);
+    extentsX.resize(paddedCount, 0.0f);
+    extentsY.resize(paddedCount, 0.0f);
+    extentsZ.resize(paddedCount, 0.0f);
+    radiuses.resize(paddedCount, 0.0f);
+    visibility.resize(paddedCount);
+
+    const UInt64 blocksCount = paddedCount / LANES_COUNT;
+    if (threadPool && objectsCount > PARALLEL_BATCH_SIZE)
+    {
+        threadPool->parallel_for(blocksCount,
+                                 PARALLEL_BATCH_SIZE / LANES_COUNT,
+                                 [this](UInt64 begin, UInt64 end)
+                                 {
+                                     cull_range(begin * LANES_COUNT, end * LANES_COUNT);
+                                 });
+    } else {
+        cull_range(0, paddedCount);
+    }
+
+    UInt64 visibleCount = 0;
+    for (UInt64 i = 0; i < objectsCount; ++i)
+    {
+        visibleCount += visibility[i];
+    }
+
+    statistics.testedCount += objectsCount;
+    statistics.drawnCount  += visibleCount;
+    statistics.culledCount += objectsCount - visibleCount;
+}
+
+Bool FrustumCuller::is_visible(UInt64 index) const
+{
+    return index < objectsCount && visibility[index] != 0;
+}
+
+UInt64 FrustumCuller::get_objects_count() const
+{
+    return objectsCount;
+}
+
+const Array<FVector4, 6>& FrustumCuller::get_planes() const
+{
+    return planes;
+}
+
+const CullingStatistics& FrustumCuller::get_statistics() const
+{
+    return statistics;
+}
+
+Void FrustumCuller::reset_statistics()
+{
+    statistics = {};
+}
+
+Array<FVector4, 6> FrustumCuller::s_extract_planes(const FMatrix4& viewProjection)
+{
+    const FVector4 row0{ viewProjection[0][0], viewProjection[1][0], viewProjection[2][0], viewProjection[3][0] };
+    const FVector4 row1{ viewProjection[0][1], viewProjection[1][1], viewProjection[2][1], viewProjection[3][1] };
+    const FVector4 row2{ viewProjection[0][2], viewProjection[1][2], viewProjection[2][2], viewProjection[3][2] };
+    const FVector4 row3{ viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3] };
+
+    Array<FVector4, 6> result =
+    {
+        row3 + row0,
+        row3 - row0,
+        row3 + row1,
+        row3 - row1,
+        row3 + row2, // OpenGL depth range, for zero to one range it's just more conservative
+        row3 - row2,
+    };
+
+    for (FVector4& plane : result)
+    {
+        const Float32 length = glm::length(FVector3(plane));
+        if (length > 0.0f)
+        {
+            plane /= length;
+        }
+    }
+
+    return result;
+}
+
+Void FrustumCuller::cull_range(UInt64 begin, UInt64 end)
+{
+#if defined(SIMD_AVX2)
+    const __m256 zero = _mm256_setzero_ps();
+    for (UInt64 i = begin; i < end; i += 8)
+    {
+        const __m256 centerX = _mm256_loadu_ps(&centersX[i]);
+        const __m256 centerY = _mm256_loadu_ps(&centersY[i]);
+        const __m256 centerZ = _mm256_loadu_ps(&centersZ[i]);
+        const __m256 extentX = _mm256_loadu_ps(&extentsX[i]);
+        const __m256 extentY = _mm256_loadu_ps(&extentsY[i]);
+        const __m256 extentZ = _mm256_loadu_ps(&extentsZ[i]);
+        const __m256 sphereRadius = _mm256_loadu_ps(&radiuses[i]);
+
+        __m256 inside = _mm256_cmp_ps(zero, zero, _CMP_EQ_OQ);
+        for (UInt64 p = 0; p < planes.size(); ++p)
+        {
+            const FVector4& plane = planes[p];
+            const FVector4& absolutePlane = absolutePlanes[p];
+            const __m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(plane.x), centerX),
+                                                                _mm256_mul_ps(_mm256_set1_ps(plane.y), centerY)),
+                                                  _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(plane.z), centerZ),
+                                                                _mm256_set1_ps(plane.w)));
+            const __m256 boxRadius = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(absolutePlane.x), extentX),
+                                                                 _mm256_mul_ps(_mm256_set1_ps(absolutePlane.y), extentY)),
+                                                   _mm256_mul_ps(_mm256_set1_ps(absolutePlane.z), extentZ));
+            const __m256 radius = _mm256_min_ps(boxRadius, sphereRadius);
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(distance, radius), zero, _CMP_GE_OQ));
+        }
+
+        const Int32 mask = _mm256_movemask_ps(inside);
+        for (UInt64 lane = 0; lane < 8; ++lane)
+        {
+            visibility[i + lane] = UInt8((mask >> lane) & 1);
+        }
+    }
+#elif defined(SIMD_SSE)
+    const __m128 zero = _mm_setzero_ps();
+    for (UInt64 i = begin; i < end; i += 4)
+    {
+        const __m128 centerX = _mm_loadu_ps(&centersX[i]);
+        const __m128 centerY = _mm_loadu_ps(&centersY[i]);
+        const __m128 centerZ = _mm_loadu_ps(&centersZ[i]);
+        const __m128 extentX = _mm_loadu_ps(&extentsX[i]);
+        const __m128 extentY = _mm_loadu_ps(&extentsY[i]);
+        const __m128 extentZ = _mm_loadu_ps(&extentsZ[i]);
+        const __m128 sphereRadius = _mm_loadu_ps(&radiuses[i]);
+
+        __m128 inside = _mm_cmpeq_ps(zero, zero);
+        for (UInt64 p = 0; p < planes.size(); ++p)
+        {
+            const FVector4& plane = planes[p];
+            const FVector4& absolutePlane = absolutePlanes[p];
+            const __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.x), centerX),
+                                                          _mm_mul_ps(_mm_set1_ps(plane.y), centerY)),
+                                               _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.z), centerZ),
+                                                          _mm_set1_ps(plane.w)));
+            const __m128 boxRadius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(absolutePlane.x), extentX),
+                                                           _mm_mul_ps(_mm_set1_ps(absolutePlane.y), extentY)),
+                                                _mm_mul_ps(_mm_set1_ps(absolutePlane.z), extentZ));
+            const __m128 radius = _mm_min_ps(boxRadius, sphereRadius);
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(distance, radius), zero));
+        }
+
+        const Int32 mask = _mm_movemask_ps(inside);
+        for (UInt64 lane = 0; lane < 4; ++lane)
+        {
+            visibility[i + lane] = UInt8((mask >> lane) & 1);
+        }
+    }
+#else
+    cull_range_scalar(begin, end);
+#endif
+}
+
+Void FrustumCuller::cull_range_scalar(UInt64 begin, UInt64 end)
+{
+    for (UInt64 i = begin; i < end; ++i)
+    {
+        UInt8 isInside = 1;
+        for (UInt64 p = 0; p < planes.size() && isInside; ++p)
+        {
+            const FVector4& plane = planes[p];
+            const FVector4& absolutePlane = absolutePlanes[p];
+            const Float32 distance = plane.x * centersX[i] + plane.y * centersY[i] + plane.z * centersZ[i] + plane.w;
+            const Float32 boxRadius = absolutePlane.x * extentsX[i]
+                                    + absolutePlane.y * extentsY[i]
+                                    + absolutePlane.z * extentsZ[i];
+            isInside = distance + std::min(boxRadius, radiuses[i]) >= 0.0f;
+        }
+        visibility[i] = isInside;
+    }
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+struct BoundingBox;
+struct BoundingSphere;
+class ThreadPool;
+
+struct CullingStatistics
+{
+    UInt64 testedCount = 0;
+    UInt64 culledCount = 0;
+    UInt64 drawnCount  = 0;
+};
+
+/** Tests world bounds of many objects against view frustum, bounds are stored as structure of arrays */
+class FrustumCuller
+{
+public:
+    // Objects count after which culling is split between threads
+    static constexpr UInt64 PARALLEL_BATCH_SIZE = 4096;
+    static constexpr UInt64 LANES_COUNT = 8;
+
+private:
+    Array<FVector4, 6> planes;
+    Array<FVector4, 6> absolutePlanes;
+
+    DynamicArray<Float32> centersX;
+    DynamicArray<Float32> centersY;
+    DynamicArray<Float32> centersZ;
+    DynamicArray<Float32> extentsX;
+    DynamicArray<Float32> extentsY;
+    DynamicArray<Float32> extentsZ;
+    DynamicArray<Float32> radiuses;
+    DynamicArray<UInt8> visibility;
+    UInt64 objectsCount = 0;
+
+    CullingStatistics statistics;
+
+public:
+    Void set_frustum(const FMatrix4& viewProjection);
+
+    // Removes all bounds, call it before adding bounds for next frame
+    Void clear();
+    // Returns index of object used by is_visible
+    UInt64 add_bounds(const BoundingBox& box, const BoundingSphere& sphere, const FMatrix4& transform);
+
+    Void cull(ThreadPool* threadPool = nullptr);
+
+    [[nodiscard]]
+    Bool is_visible(UInt64 index) const;
+    [[nodiscard]]
+    UInt64 get_objects_count() const;
+    [[nodiscard]]
+    const Array<FVector4, 6>& get_planes() const;
+    [[nodiscard]]
+    const CullingStatistics& get_statistics() const;
+    Void reset_statistics();
+
+    // Planes are in left, right, bottom, top, near, far order with normals pointing inside
+    static Array<FVector4, 6> s_extract_planes(const FMatrix4& viewProjection);
+
+private:
+    Void cull_range(UInt64 begin, UInt64 end);
+    Void cull_range_scalar(UInt64 begin, UInt64 end);
+};
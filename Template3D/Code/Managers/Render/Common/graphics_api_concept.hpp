@@ -2,13 +2,16 @@
 
 template <typename GraphicsAPI>
 class Simulation;
-template <typename GraphicsAPI>
-struct Model;
+class RenderQueue;
 
 template <typename Type>
-concept GraphicsAPI = requires(Type api, Simulation<Type> &simulation, Model<Type> &model)
+concept GraphicsAPI = requires(Type api,
+                               Simulation<Type> &simulation,
+                               RenderQueue &queue)
 {
     { api.startup(simulation) } -> std::same_as<Void>;
-    { api.draw_model(simulation, model) } -> std::same_as<Void>;
+    { api.begin_frame(simulation) } -> std::same_as<Bool>;
+    { api.draw_queue(simulation, queue) } -> std::same_as<Void>;
+    { api.end_frame(simulation) } -> std::same_as<Void>;
     { api.shutdown() } -> std::same_as<Void>;
 };
@@ -0,0 +1,376 @@
+#include "occlusion_culler.hpp"
+
+#include "Resource/Common/bounds.hpp"
+#include "Resource/Common/vertex.hpp"
+#include "Utilities/thread_pool.hpp"
+#include "Utilities/simd.hpp"
+
+
+Void OcclusionCuller::set_resolution(UInt32 width, UInt32 height)
+{
+    this->width  = std::max(width, 1U);
+    this->height = std::max(height, 1U);
+    stride = (this->width + LANES_COUNT - 1) / LANES_COUNT * LANES_COUNT;
+
+    hierarchy.clear();
+    hierarchySizes.clear();
+    UVector2 size{ stride, this->height };
+    hierarchy.emplace_back(UInt64(size.x) * size.y, 1.0f);
+    hierarchySizes.push_back(size);
+    while (size.x > 1 || size.y > 1)
+    {
+        size = { (size.x + 1) / 2, (size.y + 1) / 2 };
+        hierarchy.emplace_back(UInt64(size.x) * size.y, 1.0f);
+        hierarchySizes.push_back(size);
+    }
+}
+
+Void OcclusionCuller::begin_frame(const FMatrix4& viewProjection)
+{
+    if (hierarchy.empty())
+    {
+        set_resolution(DEFAULT_WIDTH, DEFAULT_HEIGHT);
+    }
+
+    this->viewProjection = viewProjection;
+    triangles.clear();
+}
+
+Void OcclusionCuller::add_occluder(const DynamicArray<Vertex>& vertexes,
+                                   const DynamicArray<UInt32>& indexes,
+                                   const FMatrix4& transform)
+{
+    const FMatrix4 modelViewProjection = viewProjection * transform;
+    DynamicArray<FVector4> clipPositions(vertexes.size());
+    for (UInt64 i = 0; i < vertexes.size(); ++i)
+    {
+        clipPositions[i] = modelViewProjection * FVector4(vertexes[i].position, 1.0f);
+    }
+
+    for (UInt64 i = 0; i + 2 < indexes.size(); i += 3)
+    {
+        const FVector4& clip0 = clipPositions[indexes[i]];
+        const FVector4& clip1 = clipPositions[indexes[i + 1]];
+        const FVector4& clip2 = clipPositions[indexes[i + 2]];
+
+        // Near plane is z + w >= 0, only triangles crossing it need clipping
+        const Array<FVector4, 3> corners = { clip0, clip1, clip2 };
+        Array<Float32, 3> distances;
+        UInt32 insideCount = 0;
+        for (UInt32 corner = 0; corner < 3; ++corner)
+        {
+            distances[corner] = corners[corner].z + corners[corner].w;
+            insideCount += distances[corner] >= 0.0f;
+        }
+
+        if (insideCount == 0)
+        {
+            continue;
+        }
+
+        if (insideCount == 3)
+        {
+            add_triangle(clip0, clip1, clip2);
+            continue;
+        }
+
+        Array<FVector4, 4> polygon;
+        UInt32 polygonSize = 0;
+        for (UInt32 corner = 0; corner < 3; ++corner)
+        {
+            const UInt32 next = (corner + 1) % 3;
+            if (distances[corner] >= 0.0f)
+            {
+                polygon[polygonSize++] = corners[corner];
+            }
+
+            if ((distances[corner] >= 0.0f) != (distances[next] >= 0.0f))
+            {
+                const Float32 factor = distances[corner] / (distances[corner] - distances[next]);
+                polygon[polygonSize++] = corners[corner] + (corners[next] - corners[corner]) * factor;
+            }
+        }
+
+        for (UInt32 corner = 2; corner < polygonSize; ++corner)
+        {
+            add_triangle(polygon[0], polygon[corner - 1], polygon[corner]);
+        }
+    }
+}
+
+Void OcclusionCuller::rasterize(ThreadPool* threadPool)
+{
+    if (hierarchy.empty())
+    {
+        set_resolution(DEFAULT_WIDTH, DEFAULT_HEIGHT);
+    }
+
+    std::fill(hierarchy[0].begin(), hierarchy[0].end(), 1.0f);
+
+    const UInt32 bandsCount = (height + BAND_HEIGHT - 1) / BAND_HEIGHT;
+    const auto rasterizeBands = [this](UInt64 begin, UInt64 end)
+    {
+        rasterize_rows(UInt32(begin) * BAND_HEIGHT, std::min(UInt32(end) * BAND_HEIGHT, height));
+    };
+
+    if (threadPool && !triangles.empty())
+    {
+        threadPool->parallel_for(bandsCount, 1, rasterizeBands);
+    } else {
+        rasterizeBands(0, bandsCount);
+    }
+
+    build_hierarchy();
+}
+
+Bool OcclusionCuller::test_bounds(const BoundingBox& box, const FMatrix4& transform)
+{
+    const Bool isVisible = hierarchy.empty() || !is_occluded(box, transform);
+    statistics.testedCount++;
+    statistics.drawnCount  += isVisible;
+    statistics.culledCount += !isVisible;
+
+    return isVisible;
+}
+
+const DynamicArray<Float32>& OcclusionCuller::get_depth() const
+{
+    return hierarchy[0];
+}
+
+UVector2 OcclusionCuller::get_resolution() const
+{
+    return { width, height };
+}
+
+UInt32 OcclusionCuller::get_stride() const
+{
+    return stride;
+}
+
+const CullingStatistics& OcclusionCuller::get_statistics() const
+{
+    return statistics;
+}
+
+Void OcclusionCuller::reset_statistics()
+{
+    statistics = {};
+}
+
+Void OcclusionCuller::add_triangle(const FVector4& clip0, const FVector4& clip1, const FVector4& clip2)
+{
+    FVector3 vertex0 = to_screen(clip0);
+    FVector3 vertex1 = to_screen(clip1);
+    FVector3 vertex2 = to_screen(clip2);
+
+    Float32 area = (vertex1.x - vertex0.x) * (vertex2.y - vertex0.y) - (vertex1.y - vertex0.y) * (vertex2.x - vertex0.x);
+    if (std::abs(area) < 1e-6f)
+    {
+        return;
+    }
+
+    // Occluders are two sided, winding is only flipped to keep edge functions positive inside
+    if (area < 0.0f)
+    {
+        std::swap(vertex1, vertex2);
+        area = -area;
+    }
+
+    const FVector2 minimum = glm::min(glm::min(FVector2(vertex0), FVector2(vertex1)), FVector2(vertex2));
+    const FVector2 maximum = glm::max(glm::max(FVector2(vertex0), FVector2(vertex1)), FVector2(vertex2));
+    RasterTriangle triangle;
+    triangle.minimum = { std::max(Int32(std::floor(minimum.x)), 0), std::max(Int32(std::floor(minimum.y)), 0) };
+    triangle.maximum = { std::min(Int32(std::ceil(maximum.x)), Int32(width) - 1),
+                         std::min(Int32(std::ceil(maximum.y)), Int32(height) - 1) };
+    if (triangle.minimum.x > triangle.maximum.x || triangle.minimum.y > triangle.maximum.y)
+    {
+        return;
+    }
+
+    const Array<FVector3, 3> vertexes = { vertex0, vertex1, vertex2 };
+    for (Int32 i = 0; i < 3; ++i)
+    {
+        // Edge opposite to vertex i, its value is barycentric weight of that vertex multiplied by area
+        const FVector3& from = vertexes[(i + 1) % 3];
+        const FVector3& to   = vertexes[(i + 2) % 3];
+        triangle.edgeA[i] = from.y - to.y;
+        triangle.edgeB[i] = to.x - from.x;
+        triangle.edgeC[i] = -(triangle.edgeA[i] * from.x + triangle.edgeB[i] * from.y);
+    }
+
+    const FVector3 depths = FVector3(vertex0.z, vertex1.z, vertex2.z) / area;
+    triangle.depth = { glm::dot(triangle.edgeA, depths),
+                       glm::dot(triangle.edgeB, depths),
+                       glm::dot(triangle.edgeC, depths) };
+
+    triangles.push_back(triangle);
+}
+
+Void OcclusionCuller::rasterize_rows(UInt32 beginRow, UInt32 endRow)
+{
+    DynamicArray<Float32>& depthBuffer = hierarchy[0];
+    for (const RasterTriangle& triangle : triangles)
+    {
+        const Int32 firstRow = std::max(triangle.minimum.y, Int32(beginRow));
+        const Int32 lastRow  = std::min(triangle.maximum.y, Int32(endRow) - 1);
+        const Int32 firstColumn = triangle.minimum.x / Int32(LANES_COUNT) * Int32(LANES_COUNT);
+        for (Int32 row = firstRow; row <= lastRow; ++row)
+        {
+            const Float32 y = Float32(row) + 0.5f;
+            Float32* depthRow = &depthBuffer[UInt64(row) * stride];
+            const FVector3 rowEdges = triangle.edgeB * y + triangle.edgeC;
+            const Float32 rowDepth  = triangle.depth.y * y + triangle.depth.z;
+#if defined(SIMD_AVX2)
+            const __m256 laneOffsets = _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f);
+            const __m256 zero = _mm256_setzero_ps();
+            for (Int32 column = firstColumn; column <= triangle.maximum.x; column += 8)
+            {
+                const __m256 x = _mm256_add_ps(_mm256_set1_ps(Float32(column)), laneOffsets);
+                const __m256 edge0 = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(triangle.edgeA.x), x),
+                                                   _mm256_set1_ps(rowEdges.x));
+                const __m256 edge1 = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(triangle.edgeA.y), x),
+                                                   _mm256_set1_ps(rowEdges.y));
+                const __m256 edge2 = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(triangle.edgeA.z), x),
+                                                   _mm256_set1_ps(rowEdges.z));
+                const __m256 inside = _mm256_and_ps(_mm256_and_ps(_mm256_cmp_ps(edge0, zero, _CMP_GE_OQ),
+                                                                  _mm256_cmp_ps(edge1, zero, _CMP_GE_OQ)),
+                                                    _mm256_cmp_ps(edge2, zero, _CMP_GE_OQ));
+                if (_mm256_movemask_ps(inside) == 0)
+                {
+                    continue;
+                }
+
+                const __m256 depth = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(triangle.depth.x), x),
+                                                   _mm256_set1_ps(rowDepth));
+                const __m256 current = _mm256_loadu_ps(depthRow + column);
+                _mm256_storeu_ps(depthRow + column, _mm256_blendv_ps(current, _mm256_min_ps(current, depth), inside));
+            }
+#elif defined(SIMD_SSE)
+            const __m128 laneOffsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+            const __m128 zero = _mm_setzero_ps();
+            for (Int32 column = firstColumn; column <= triangle.maximum.x; column += 4)
+            {
+                const __m128 x = _mm_add_ps(_mm_set1_ps(Float32(column)), laneOffsets);
+                const __m128 edge0 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(triangle.edgeA.x), x), _mm_set1_ps(rowEdges.x));
+                const __m128 edge1 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(triangle.edgeA.y), x), _mm_set1_ps(rowEdges.y));
+                const __m128 edge2 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(triangle.edgeA.z), x), _mm_set1_ps(rowEdges.z));
+                const __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(edge0, zero), _mm_cmpge_ps(edge1, zero)),
+                                                 _mm_cmpge_ps(edge2, zero));
+                if (_mm_movemask_ps(inside) == 0)
+                {
+                    continue;
+                }
+
+                const __m128 depth = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(triangle.depth.x), x), _mm_set1_ps(rowDepth));
+                const __m128 current = _mm_loadu_ps(depthRow + column);
+                const __m128 nearest = _mm_min_ps(current, depth);
+                _mm_storeu_ps(depthRow + column, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, current)));
+            }
+#else
+            for (Int32 column = triangle.minimum.x; column <= triangle.maximum.x; ++column)
+            {
+                const Float32 x = Float32(column) + 0.5f;
+                const FVector3 edges = triangle.edgeA * x + rowEdges;
+                if (edges.x < 0.0f || edges.y < 0.0f || edges.z < 0.0f)
+                {
+                    continue;
+                }
+
+                const Float32 depth = triangle.depth.x * x + rowDepth;
+                depthRow[column] = std::min(depthRow[column], depth);
+            }
+#endif
+        }
+    }
+}
+
+Void OcclusionCuller::build_hierarchy()
+{
+    for (UInt64 level = 1; level < hierarchy.size(); ++level)
+    {
+        const DynamicArray<Float32>& source = hierarchy[level - 1];
+        DynamicArray<Float32>& destination = hierarchy[level];
+        const UVector2 sourceSize = hierarchySizes[level - 1];
+        const UVector2 size = hierarchySizes[level];
+        for (UInt32 y = 0; y < size.y; ++y)
+        {
+            const UInt32 sourceY0 = 2 * y;
+            const UInt32 sourceY1 = std::min(2 * y + 1, sourceSize.y - 1);
+            for (UInt32 x = 0; x < size.x; ++x)
+            {
+                const UInt32 sourceX0 = 2 * x;
+                const UInt32 sourceX1 = std::min(2 * x + 1, sourceSize.x - 1);
+                destination[UInt64(y) * size.x + x] = std::max({ source[UInt64(sourceY0) * sourceSize.x + sourceX0],
+                                                                 source[UInt64(sourceY0) * sourceSize.x + sourceX1],
+                                                                 source[UInt64(sourceY1) * sourceSize.x + sourceX0],
+                                                                 source[UInt64(sourceY1) * sourceSize.x + sourceX1] });
+            }
+        }
+    }
+}
+
+Bool OcclusionCuller::is_occluded(const BoundingBox& box, const FMatrix4& transform) const
+{
+    const FMatrix4 modelViewProjection = viewProjection * transform;
+    FVector2 minimum{ Limits<Float32>::max() };
+    FVector2 maximum{ Limits<Float32>::lowest() };
+    Float32 nearestDepth = Limits<Float32>::max();
+    for (UInt32 corner = 0; corner < 8; ++corner)
+    {
+        const FVector3 position{ corner & 1 ? box.maximum.x : box.minimum.x,
+                                 corner & 2 ? box.maximum.y : box.minimum.y,
+                                 corner & 4 ? box.maximum.z : box.minimum.z };
+        const FVector4 clip = modelViewProjection * FVector4(position, 1.0f);
+        // Box crossing near plane covers whole screen
+        if (clip.z + clip.w < 0.0f)
+        {
+            return false;
+        }
+
+        const FVector3 screen = to_screen(clip);
+        minimum = glm::min(minimum, FVector2(screen));
+        maximum = glm::max(maximum, FVector2(screen));
+        nearestDepth = std::min(nearestDepth, screen.z);
+    }
+
+    const Int32 minimumX = std::max(Int32(std::floor(minimum.x)), 0);
+    const Int32 minimumY = std::max(Int32(std::floor(minimum.y)), 0);
+    const Int32 maximumX = std::min(Int32(std::floor(maximum.x)), Int32(width) - 1);
+    const Int32 maximumY = std::min(Int32(std::floor(maximum.y)), Int32(height) - 1);
+    if (minimumX > maximumX || minimumY > maximumY)
+    {
+        return false;
+    }
+
+    // Level where box covers at most 2x2 texels
+    UInt64 level = 0;
+    while (level + 1 < hierarchy.size()
+        && ((maximumX >> level) - (minimumX >> level) > 1 || (maximumY >> level) - (minimumY >> level) > 1))
+    {
+        ++level;
+    }
+
+    const DynamicArray<Float32>& depths = hierarchy[level];
+    const UInt32 levelWidth = hierarchySizes[level].x;
+    for (Int32 y = minimumY >> level; y <= maximumY >> level; ++y)
+    {
+        for (Int32 x = minimumX >> level; x <= maximumX >> level; ++x)
+        {
+            if (nearestDepth <= depths[UInt64(y) * levelWidth + x])
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+FVector3 OcclusionCuller::to_screen(const FVector4& clip) const
+{
+    const FVector3 normalized = FVector3(clip) / std::max(clip.w, 1e-6f);
+    return { (normalized.x * 0.5f + 0.5f) * Float32(width),
+             (normalized.y * 0.5f + 0.5f) * Float32(height),
+             normalized.z };
+}
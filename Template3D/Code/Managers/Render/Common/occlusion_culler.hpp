@@ -0,0 +1,74 @@
+#pragma once
+#include "frustum_culler.hpp"
+
+struct Vertex;
+
+/** Rasterizes occluders into low resolution depth buffer on CPU and tests bounds against its depth hierarchy */
+class OcclusionCuller
+{
+public:
+    static constexpr UInt32 DEFAULT_WIDTH  = 320;
+    static constexpr UInt32 DEFAULT_HEIGHT = 192;
+    // Rows rasterized by one task, each task walks all triangles and skips ones outside of its rows
+    static constexpr UInt32 BAND_HEIGHT = 16;
+    static constexpr UInt32 LANES_COUNT = 8;
+
+private:
+    struct RasterTriangle
+    {
+        // Edge functions in A * x + B * y + C form, positive inside of triangle
+        FVector3 edgeA;
+        FVector3 edgeB;
+        FVector3 edgeC;
+        // Depth plane in the same form
+        FVector3 depth;
+        IVector2 minimum;
+        IVector2 maximum;
+    };
+
+    FMatrix4 viewProjection{ 1.0f };
+    UInt32 width = 0;
+    UInt32 height = 0;
+    // Row stride, width padded to whole lanes
+    UInt32 stride = 0;
+
+    DynamicArray<RasterTriangle> triangles;
+    // First level is depth buffer, every next one stores farthest depth of 2x2 texels from previous one
+    DynamicArray<DynamicArray<Float32>> hierarchy;
+    DynamicArray<UVector2> hierarchySizes;
+
+    CullingStatistics statistics;
+
+public:
+    Void set_resolution(UInt32 width, UInt32 height);
+
+    // Clears occluders, call it before adding occluders for next frame
+    Void begin_frame(const FMatrix4& viewProjection);
+    Void add_occluder(const DynamicArray<Vertex>& vertexes,
+                      const DynamicArray<UInt32>& indexes,
+                      const FMatrix4& transform);
+    // Draws all added occluders and builds depth hierarchy
+    Void rasterize(ThreadPool* threadPool = nullptr);
+
+    // Not thread safe because it counts statistics
+    Bool test_bounds(const BoundingBox& box, const FMatrix4& transform);
+
+    [[nodiscard]]
+    const DynamicArray<Float32>& get_depth() const;
+    [[nodiscard]]
+    UVector2 get_resolution() const;
+    [[nodiscard]]
+    UInt32 get_stride() const;
+    [[nodiscard]]
+    const CullingStatistics& get_statistics() const;
+    Void reset_statistics();
+
+private:
+    Void add_triangle(const FVector4& clip0, const FVector4& clip1, const FVector4& clip2);
+    Void rasterize_rows(UInt32 beginRow, UInt32 endRow);
+    Void build_hierarchy();
+    [[nodiscard]]
+    Bool is_occluded(const BoundingBox& box, const FMatrix4& transform) const;
+    [[nodiscard]]
+    FVector3 to_screen(const FVector4& clip) const;
+};
@@ -0,0 +1,125 @@
+#pragma once
+#include "Utilities/hash.hpp"
+
+struct PipelineStateStatistics
+{
+    UInt64 requestsCount = 0;
+    UInt64 hitsCount     = 0;
+    UInt64 createdCount  = 0;
+    // Sum of creation times of pipelines returned from cache, each hit saves one creation
+    Float64 avoidedMilliseconds = 0.0;
+};
+
+/** Pipelines by their full state description, identical requests get the same pipeline handle */
+template <typename Pipeline>
+class PipelineStateCache
+{
+private:
+    struct Entry
+    {
+        DynamicArray<UInt64> state;
+        Handle<Pipeline> handle;
+        UInt64 creationNanoseconds;
+    };
+
+    // Entries with colliding hashes are kept together and compared by whole state
+    HashMap<UInt64, DynamicArray<Entry>> entries;
+    UInt64 requestsCount      = 0;
+    UInt64 hitsCount          = 0;
+    UInt64 avoidedNanoseconds = 0;
+
+public:
+    // Returns NONE when pipeline with given state was not created yet
+    Handle<Pipeline> find(const DynamicArray<UInt64>& state);
+    Void insert(const DynamicArray<UInt64>& state, Handle<Pipeline> handle, UInt64 creationNanoseconds);
+    // For pipelines inserted before their creation finished
+    Void set_creation_time(const DynamicArray<UInt64>& state, UInt64 creationNanoseconds);
+
+    [[nodiscard]]
+    PipelineStateStatistics get_statistics() const;
+
+    Void clear();
+
+private:
+    static UInt64 s_hash(const DynamicArray<UInt64>& state);
+};
+
+template <typename Pipeline>
+Handle<Pipeline> PipelineStateCache<Pipeline>::find(const DynamicArray<UInt64>& state)
+{
+    requestsCount++;
+
+    const auto iterator = entries.find(s_hash(state));
+    if (iterator == entries.end())
+    {
+        return Handle<Pipeline>::NONE;
+    }
+
+    for (const Entry& entry : iterator->second)
+    {
+        if (entry.state == state)
+        {
+            hitsCount++;
+            avoidedNanoseconds += entry.creationNanoseconds;
+            return entry.handle;
+        }
+    }
+    return Handle<Pipeline>::NONE;
+}
+
+template <typename Pipeline>
+Void PipelineStateCache<Pipeline>::insert(const DynamicArray<UInt64>& state, Handle<Pipeline> handle, UInt64 creationNanoseconds)
+{
+    Entry& entry = entries[s_hash(state)].emplace_back();
+    entry.state               = state;
+    entry.handle              = handle;
+    entry.creationNanoseconds = creationNanoseconds;
+}
+
+template <typename Pipeline>
+Void PipelineStateCache<Pipeline>::set_creation_time(const DynamicArray<UInt64>& state, UInt64 creationNanoseconds)
+{
+    const auto iterator = entries.find(s_hash(state));
+    if (iterator == entries.end())
+    {
+        return;
+    }
+
+    for (Entry& entry : iterator->second)
+    {
+        if (entry.state == state)
+        {
+            entry.creationNanoseconds = creationNanoseconds;
+            return;
+        }
+    }
+}
+
+template <typename Pipeline>
+PipelineStateStatistics PipelineStateCache<Pipeline>::get_statistics() const
+{
+    PipelineStateStatistics statistics;
+    statistics.requestsCount       = requestsCount;
+    statistics.hitsCount           = hitsCount;
+    statistics.avoidedMilliseconds = Float64(avoidedNanoseconds) / 1'000'000.0;
+    for (const auto& [key, bucket] : entries)
+    {
+        statistics.createdCount += bucket.size();
+    }
+    return statistics;
+}
+
+template <typename Pipeline>
+Void PipelineStateCache<Pipeline>::clear()
+{
+    entries.clear();
+    requestsCount      = 0;
+    hitsCount          = 0;
+    avoidedNanoseconds = 0;
+}
+
+template <typename Pipeline>
+UInt64 PipelineStateCache<Pipeline>::s_hash(const DynamicArray<UInt64>& state)
+{
+    return hash_bytes(state.data(), state.size() * sizeof(UInt64));
+}
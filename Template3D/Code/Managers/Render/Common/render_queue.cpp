@@ -0,0 +1,176 @@
+#include "render_queue.hpp"
+
+
+Void RenderQueue::clear()
+{
+    items.clear();
+    transforms.clear();
+    batches.clear();
+    instanceTransforms.clear();
+}
+
+UInt32 RenderQueue::add_transform(const FMatrix4& transform)
+{
+    const UInt32 index = UInt32(transforms.size());
+    transforms.push_back(transform);
+    return index;
+}
+
+Void RenderQueue::submit(EDrawPass pass,
+                         UInt64 shaderSetId,
+                         UInt64 materialId,
+                         UInt64 meshId,
+                         UInt32 transformIndex,
+                         Float32 depth)
+{
+    DrawItem& item = items.emplace_back();
+    item.key            = s_make_key(pass, shaderSetId, materialId, meshId, depth);
+    item.meshId         = meshId;
+    item.materialId     = materialId;
+    item.shaderSetId    = shaderSetId;
+    item.transformIndex = transformIndex;
+}
+
+Void RenderQueue::sort()
+{
+    constexpr UInt32 DIGIT_BITS = 8;
+    constexpr UInt32 DIGITS_COUNT = 64 / DIGIT_BITS;
+    constexpr UInt32 BUCKETS_COUNT = 1U << DIGIT_BITS;
+
+    if (items.size() < 2)
+    {
+        return;
+    }
+
+    // All histograms are counted in one pass over items
+    Array<Array<UInt32, BUCKETS_COUNT>, DIGITS_COUNT> histograms{};
+    for (const DrawItem& item : items)
+    {
+        for (UInt32 digit = 0; digit < DIGITS_COUNT; ++digit)
+        {
+            histograms[digit][(item.key >> (digit * DIGIT_BITS)) & (BUCKETS_COUNT - 1)]++;
+        }
+    }
+
+    sortBuffer.resize(items.size());
+    for (UInt32 digit = 0; digit < DIGITS_COUNT; ++digit)
+    {
+        Array<UInt32, BUCKETS_COUNT>& histogram = histograms[digit];
+        const UInt64 firstBucket = (items[0].key >> (digit * DIGIT_BITS)) & (BUCKETS_COUNT - 1);
+        if (histogram[firstBucket] == items.size())
+        {
+            continue;
+        }
+
+        UInt32 offset = 0;
+        for (UInt32& count : histogram)
+        {
+            const UInt32 bucketSize = count;
+            count = offset;
+            offset += bucketSize;
+        }
+
+        for (const DrawItem& item : items)
+        {
+            sortBuffer[histogram[(item.key >> (digit * DIGIT_BITS)) & (BUCKETS_COUNT - 1)]++] = item;
+        }
+        items.swap(sortBuffer);
+    }
+}
+
+Void RenderQueue::build_batches()
+{
+    batches.clear();
+    instanceTransforms.clear();
+    instanceTransforms.reserve(items.size());
+
+    constexpr UInt32 PASS_SHIFT = 64 - PASS_BITS;
+    UInt64 batchPass = Limits<UInt64>::max();
+    for (const DrawItem& item : items)
+    {
+        const UInt64 pass = item.key >> PASS_SHIFT;
+        // Items are sorted by state, so items which can be instanced are next to each other.
+        // Transparent items are never instanced, it would break their back to front order
+        if (batches.empty()
+            || pass != batchPass
+            || pass == UInt64(EDrawPass::Transparent)
+            || batches.back().shaderSetId != item.shaderSetId
+            || batches.back().materialId != item.materialId
+            || batches.back().meshId != item.meshId)
+        {
+            DrawBatch& batch = batches.emplace_back();
+            batch.meshId         = item.meshId;
+            batch.materialId     = item.materialId;
+            batch.shaderSetId    = item.shaderSetId;
+            batch.firstInstance  = UInt32(instanceTransforms.size());
+            batch.instancesCount = 0;
+            batchPass = pass;
+        }
+
+        batches.back().instancesCount++;
+        instanceTransforms.push_back(transforms[item.transformIndex]);
+    }
+}
+
+const DynamicArray<DrawItem>& RenderQueue::get_items() const
+{
+    return items;
+}
+
+const FMatrix4& RenderQueue::get_transform(UInt32 index) const
+{
+    return transforms[index];
+}
+
+const DynamicArray<FMatrix4>& RenderQueue::get_transforms() const
+{
+    return transforms;
+}
+
+const DynamicArray<DrawBatch>& RenderQueue::get_batches() const
+{
+    return batches;
+}
+
+const DynamicArray<FMatrix4>& RenderQueue::get_instance_transforms() const
+{
+    return instanceTransforms;
+}
+
+const RenderQueueStatistics& RenderQueue::get_statistics() const
+{
+    return statistics;
+}
+
+RenderQueueStatistics& RenderQueue::get_statistics()
+{
+    return statistics;
+}
+
+Void RenderQueue::reset_statistics()
+{
+    statistics = {};
+}
+
+UInt64 RenderQueue::s_make_key(EDrawPass pass, UInt64 shaderSetId, UInt64 materialId, UInt64 meshId, Float32 depth)
+{
+    constexpr UInt64 DEPTH_MAX = (1ULL << DEPTH_BITS) - 1ULL;
+    const UInt64 quantizedDepth = UInt64(std::clamp(depth, 0.0f, 1.0f) * Float32(DEPTH_MAX));
+
+    UInt64 key = UInt64(pass) & ((1ULL << PASS_BITS) - 1ULL);
+    // Transparent draws are ordered from back to front before any state
+    if (pass == EDrawPass::Transparent)
+    {
+        key = (key << DEPTH_BITS) | (DEPTH_MAX - quantizedDepth);
+    }
+
+    key = (key << PIPELINE_BITS) | (shaderSetId & ((1ULL << PIPELINE_BITS) - 1ULL));
+    key = (key << MATERIAL_BITS) | (materialId & ((1ULL << MATERIAL_BITS) - 1ULL));
+    key = (key << MESH_BITS)     | (meshId & ((1ULL << MESH_BITS) - 1ULL));
+    if (pass != EDrawPass::Transparent)
+    {
+        key = (key << DEPTH_BITS) | quantizedDepth;
+    }
+
+    return key;
+}
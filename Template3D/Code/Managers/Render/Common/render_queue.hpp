@@ -0,0 +1,100 @@
+#pragma once
+
+enum class EDrawPass : UInt8
+{
+    Opaque = 0U,
+    Transparent,
+    Count
+};
+
+struct DrawItem
+{
+    UInt64 key;
+    UInt64 meshId;
+    UInt64 materialId;
+    UInt64 shaderSetId;
+    UInt32 transformIndex;
+};
+
+// Consecutive sorted items sharing whole state, drawn with one instanced draw
+struct DrawBatch
+{
+    UInt64 meshId;
+    UInt64 materialId;
+    UInt64 shaderSetId;
+    UInt32 firstInstance;
+    UInt32 instancesCount;
+};
+
+struct RenderQueueStatistics
+{
+    UInt64 drawsCount         = 0;
+    UInt64 instancesCount     = 0;
+    UInt64 pipelineBindsCount = 0;
+    UInt64 pipelineBindsSaved = 0;
+    // Texture binds on OpenGL, pushes of texture slot on Vulkan
+    UInt64 materialBindsCount = 0;
+    UInt64 materialBindsSaved = 0;
+    UInt64 meshBindsCount     = 0;
+    UInt64 meshBindsSaved     = 0;
+    // Draws of pipelines still created on worker threads
+    UInt64 fallbackDrawsCount = 0;
+    UInt64 skippedDrawsCount  = 0;
+};
+
+/** Draws submitted in any order, sorted by key so backends can skip state that did not change */
+class RenderQueue
+{
+public:
+    // Key layout from most significant bits: pass | pipeline | material | mesh | depth,
+    // transparent pass moves inverted depth right after pass: pass | depth | pipeline | material | mesh
+    static constexpr UInt32 PASS_BITS     = 4;
+    static constexpr UInt32 PIPELINE_BITS = 12;
+    static constexpr UInt32 MATERIAL_BITS = 16;
+    static constexpr UInt32 MESH_BITS     = 16;
+    static constexpr UInt32 DEPTH_BITS    = 16;
+    static_assert(PASS_BITS + PIPELINE_BITS + MATERIAL_BITS + MESH_BITS + DEPTH_BITS == 64);
+
+private:
+    DynamicArray<DrawItem> items;
+    DynamicArray<DrawItem> sortBuffer;
+    DynamicArray<FMatrix4> transforms;
+    DynamicArray<DrawBatch> batches;
+    // Transforms of batches instances in draw order, instance of batch is at firstInstance + instance index
+    DynamicArray<FMatrix4> instanceTransforms;
+    RenderQueueStatistics statistics;
+
+public:
+    Void clear();
+
+    UInt32 add_transform(const FMatrix4& transform);
+    // Depth is view distance normalized to zero to one range
+    Void submit(EDrawPass pass,
+                UInt64 shaderSetId,
+                UInt64 materialId,
+                UInt64 meshId,
+                UInt32 transformIndex,
+                Float32 depth);
+    // Stable LSD radix sort on 8 bit digits, digits equal for every item are skipped
+    Void sort();
+    // Merges sorted items into instanced batches, call it after sort
+    Void build_batches();
+
+    [[nodiscard]]
+    const DynamicArray<DrawItem>& get_items() const;
+    [[nodiscard]]
+    const FMatrix4& get_transform(UInt32 index) const;
+    [[nodiscard]]
+    const DynamicArray<FMatrix4>& get_transforms() const;
+    [[nodiscard]]
+    const DynamicArray<DrawBatch>& get_batches() const;
+    [[nodiscard]]
+    const DynamicArray<FMatrix4>& get_instance_transforms() const;
+
+    [[nodiscard]]
+    const RenderQueueStatistics& get_statistics() const;
+    RenderQueueStatistics& get_statistics();
+    Void reset_statistics();
+
+    static UInt64 s_make_key(EDrawPass pass, UInt64 shaderSetId, UInt64 materialId, UInt64 meshId, Float32 depth);
+};
@@ -0,0 +1,213 @@
+#include "shader_includes.hpp"
+
+#include "Utilities/hash.hpp"
+
+#include <filesystem>
+#include <fstream>
+
+
+Void ShaderIncludes::collect(const String& code, const String& filePath)
+{
+    clear();
+    collect_headers(code, filePath);
+}
+
+Bool ShaderIncludes::expand(const String& code, const String& filePath, String& expandedCode) const
+{
+    expandedCode.clear();
+    expandedCode.reserve(code.size());
+    return expand_headers(code, filePath, 0, expandedCode);
+}
+
+String ShaderIncludes::resolve(const String& headerName, const String& includerPath) const
+{
+    for (const String& candidate : s_get_candidates(headerName, includerPath))
+    {
+        if (contents.contains(candidate))
+        {
+            return candidate;
+        }
+    }
+    return String();
+}
+
+const String* ShaderIncludes::get_content(const String& path) const
+{
+    const auto iterator = contents.find(path);
+    if (iterator == contents.end())
+    {
+        return nullptr;
+    }
+    return &iterator->second;
+}
+
+const DynamicArray<String>& ShaderIncludes::get_paths() const
+{
+    return paths;
+}
+
+UInt64 ShaderIncludes::get_hash(UInt64 seed) const
+{
+    UInt64 hash = hash_value(UInt64(paths.size()), seed);
+    for (const String& path : paths)
+    {
+        hash = hash_string(path, hash);
+        hash = hash_string(contents.at(path), hash);
+    }
+    return hash;
+}
+
+Void ShaderIncludes::clear()
+{
+    paths.clear();
+    contents.clear();
+}
+
+String ShaderIncludes::s_normalize_path(const String& path)
+{
+    return std::filesystem::path(path).lexically_normal().generic_string();
+}
+
+Void ShaderIncludes::collect_headers(const String& code, const String& filePath)
+{
+    UInt64 lineBegin = 0;
+    while (lineBegin < code.size())
+    {
+        UInt64 lineEnd = code.find('\n', lineBegin);
+        if (lineEnd == String::npos)
+        {
+            lineEnd = code.size();
+        }
+
+        String headerName;
+        if (s_parse_include(code.substr(lineBegin, lineEnd - lineBegin), headerName))
+        {
+            for (const String& candidate : s_get_candidates(headerName, filePath))
+            {
+                // Every header is scanned once, including it again gives the same nested headers
+                if (contents.contains(candidate))
+                {
+                    break;
+                }
+
+                String content;
+                if (s_load(candidate, content))
+                {
+                    paths.push_back(candidate);
+                    const String& storedContent = contents[candidate] = std::move(content);
+                    collect_headers(storedContent, candidate);
+                    break;
+                }
+            }
+        }
+
+        lineBegin = lineEnd + 1;
+    }
+}
+
+Bool ShaderIncludes::expand_headers(const String& code, const String& filePath, UInt32 depth, String& expandedCode) const
+{
+    if (depth > MAX_INCLUDE_DEPTH)
+    {
+        SPDLOG_ERROR("Include depth of shader {} exceeds {}, headers are probably cyclic", filePath, MAX_INCLUDE_DEPTH);
+        return false;
+    }
+
+    UInt64 lineBegin = 0;
+    while (lineBegin < code.size())
+    {
+        UInt64 lineEnd = code.find('\n', lineBegin);
+        if (lineEnd == String::npos)
+        {
+            lineEnd = code.size();
+        }
+        const String line = code.substr(lineBegin, lineEnd - lineBegin);
+        lineBegin = lineEnd + 1;
+
+        String headerName;
+        if (!s_parse_include(line, headerName))
+        {
+            // Extension is needed only by glslang, other compilers could reject it
+            if (line.find("GL_GOOGLE_include_directive") == String::npos)
+            {
+                expandedCode += line;
+                expandedCode += '\n';
+            }
+            continue;
+        }
+
+        const String path = resolve(headerName, filePath);
+        if (path.empty())
+        {
+            SPDLOG_ERROR("Failed to find header {} included by {}", headerName, filePath);
+            return false;
+        }
+
+        const Bool isExpanded = expand_headers(contents.at(path), path, depth + 1, expandedCode);
+        if (!isExpanded)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+DynamicArray<String> ShaderIncludes::s_get_candidates(const String& headerName, const String& includerPath)
+{
+    DynamicArray<String> candidates;
+    const std::filesystem::path includerDirectory = std::filesystem::path(includerPath).parent_path();
+    if (!includerDirectory.empty())
+    {
+        candidates.push_back(s_normalize_path((includerDirectory / headerName).string()));
+    }
+    candidates.push_back(s_normalize_path(String(INCLUDE_DIRECTORY) + headerName));
+    return candidates;
+}
+
+Bool ShaderIncludes::s_parse_include(const String& line, String& headerName)
+{
+    UInt64 position = line.find_first_not_of(" \t");
+    if (position == String::npos || line[position] != '#')
+    {
+        return false;
+    }
+
+    position = line.find_first_not_of(" \t", position + 1);
+    if (position == String::npos || line.compare(position, 7, "include") != 0)
+    {
+        return false;
+    }
+
+    position = line.find_first_not_of(" \t", position + 7);
+    if (position == String::npos || (line[position] != '"' && line[position] != '<'))
+    {
+        return false;
+    }
+
+    const Char closing = line[position] == '"' ? '"' : '>';
+    const UInt64 end = line.find(closing, position + 1);
+    if (end == String::npos || end == position + 1)
+    {
+        return false;
+    }
+
+    headerName = line.substr(position + 1, end - position - 1);
+    return true;
+}
+
+Bool ShaderIncludes::s_load(const String& path, String& content)
+{
+    std::ifstream file(path, std::ios::ate | std::ios::binary);
+    if (!file.is_open())
+    {
+        return false;
+    }
+
+    content.resize(file.tellg());
+    file.seekg(0);
+    file.read(content.data(), Int64(content.size()));
+    file.close();
+
+    return true;
+}
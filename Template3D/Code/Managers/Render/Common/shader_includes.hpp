@@ -0,0 +1,49 @@
+#pragma once
+
+/** Header files reached by #include from shader source, names are searched next to including file and then in include directory */
+class ShaderIncludes
+{
+public:
+    static constexpr const Char* INCLUDE_DIRECTORY = "Resources/Shaders/";
+    // Headers are expanded every time they are included like in C, so only cycles can reach it
+    static constexpr UInt32 MAX_INCLUDE_DEPTH = 32;
+
+private:
+    // Resolved paths in order of first inclusion
+    DynamicArray<String> paths;
+    HashMap<String, String> contents;
+
+public:
+    // Reads every header included by code directly or through other headers, missing headers are left
+    // for compiler to report, since they can be excluded by preprocessor conditions
+    Void collect(const String& code, const String& filePath);
+    // Replaces include directives with collected headers, for compilers without include support
+    Bool expand(const String& code, const String& filePath, String& expandedCode) const;
+
+    // Returns empty path when header was not collected
+    [[nodiscard]]
+    String resolve(const String& headerName, const String& includerPath) const;
+    // Returns nullptr when header was not collected
+    [[nodiscard]]
+    const String* get_content(const String& path) const;
+    [[nodiscard]]
+    const DynamicArray<String>& get_paths() const;
+    // Covers paths and contents, so editing any header changes it
+    [[nodiscard]]
+    UInt64 get_hash(UInt64 seed) const;
+
+    Void clear();
+
+    // The same file always gets the same path, so it can be used as key of dependency graph
+    static String s_normalize_path(const String& path);
+
+private:
+    Void collect_headers(const String& code, const String& filePath);
+    Bool expand_headers(const String& code, const String& filePath, UInt32 depth, String& expandedCode) const;
+
+    // Candidates in search order, including file directory is skipped for code without file
+    static DynamicArray<String> s_get_candidates(const String& headerName, const String& includerPath);
+    // Returns false when line is not include directive
+    static Bool s_parse_include(const String& line, String& headerName);
+    static Bool s_load(const String& path, String& content);
+};
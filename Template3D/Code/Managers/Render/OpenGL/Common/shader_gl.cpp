@@ -9,6 +9,7 @@ Bool ShaderGL::create(const String& path, const EShaderType shaderType)
 {
     filePath = path;
     type = shaderType;
+    isLoadedFromFile = true;
     compose_name();
 
     const Bool isLoaded = load();
@@ -31,6 +32,7 @@ Bool ShaderGL::create(const String& name, const String& shaderCode, const EShade
     filePath = name;
     type = shaderType;
     code = shaderCode;
+    isLoadedFromFile = false;
     compose_name();
 
     const Bool isCompiled = compile();
@@ -44,20 +46,32 @@ Bool ShaderGL::create(const String& name, const String& shaderCode, const EShade
 
 Bool ShaderGL::recreate()
 {
-    clear();
+    const String oldCode = code;
+    const UInt32 oldModule = module;
 
-    const Bool isLoaded = load();
-    if (!isLoaded)
+    if (isLoadedFromFile)
     {
-        return false;
+        const Bool isLoaded = load();
+        if (!isLoaded)
+        {
+            return false;
+        }
     }
 
     const Bool isCompiled = compile();
     if (!isCompiled)
     {
+        // Expansion fails before new module is created
+        if (module != oldModule)
+        {
+            glDeleteShader(module);
+        }
+        module = oldModule;
+        code = oldCode;
         return false;
     }
 
+    glDeleteShader(oldModule);
     return true;
 }
 
@@ -80,6 +94,11 @@ EShaderType ShaderGL::get_type() const
     return type;
 }
 
+const DynamicArray<String>& ShaderGL::get_included_files() const
+{
+    return includes.get_paths();
+}
+
 Bool ShaderGL::has_compilation_errors() const
 {
     Int32 success;
@@ -148,8 +167,16 @@ Bool ShaderGL::compile()
         }
     }
 
+    includes.collect(code, filePath);
+    String expandedCode;
+    const Bool isExpanded = includes.expand(code, filePath, expandedCode);
+    if (!isExpanded)
+    {
+        return false;
+    }
+
     module = glCreateShader(shaderType);
-    const char* codeSource = code.c_str();
+    const char* codeSource = expandedCode.c_str();
     glShaderSource(module, 1, &codeSource, nullptr);
     glCompileShader(module);
     return has_compilation_errors();
@@ -200,6 +227,7 @@ Void ShaderGL::clear()
         module = 0;
     }
     code.clear();
+    includes.clear();
     name.clear();
     filePath.clear();
     type = EShaderType::None;
@@ -1,5 +1,6 @@
 #pragma once
 #include "Render/Common/shader_type.hpp"
+#include "Render/Common/shader_includes.hpp"
 
 class ShaderGL
 {
@@ -9,12 +10,16 @@ private:
     String code;
     EShaderType type;
     UInt32 module;
+    // Headers are expanded into code before compilation, driver does not resolve includes
+    ShaderIncludes includes;
+    Bool isLoadedFromFile = false;
 
 public:
     /** Create shader and give it a name as type prefix + fileName */
     Bool create(const String &path, const EShaderType shaderType);
     /** Create shader and give it a name as type prefix + shaderName, e.g. FDefault for type Fragment and shaderName Default */
     Bool create(const String &name, const String &shaderCode, const EShaderType shaderType);
+    /** Compile code again with current headers, file is read again when shader was created from it, old module is kept on failure */
     Bool recreate();
 
     [[nodiscard]]
@@ -25,6 +30,8 @@ public:
     UInt32 get_module() const;
     [[nodiscard]]
     EShaderType get_type() const;
+    [[nodiscard]]
+    const DynamicArray<String>& get_included_files() const;
 
     Void clear();
 
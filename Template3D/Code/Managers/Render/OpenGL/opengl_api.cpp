@@ -4,10 +4,12 @@
 #include "Resource/Common/mesh.hpp"
 #include "Resource/Common/texture.hpp"
 #include "Resource/Common/material.hpp"
+#include "Render/Common/render_queue.hpp"
 
 #include "simulation.hpp"
 
 #include <filesystem>
+#include <chrono>
 #include <magic_enum.hpp>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
@@ -30,7 +32,11 @@ Void OpenGL::startup(Simulation<OpenGL>& simulation)
                           "layout(location = 2) in vec2 uvs;							\n"
                           "																\n"
                           "uniform mat4 viewProjection;									\n"
-                          "uniform mat4 model;											\n"
+                          "																\n"
+                          "layout(std430, binding = 0) readonly buffer Instances		\n"
+                          "{																\n"
+                          "    mat4 transforms[];										\n"
+                          "};															\n"
                           "																\n"
                           "out vec3 worldPosition;										\n"
                           "out vec3 worldNormal;										\n"
@@ -38,6 +44,7 @@ Void OpenGL::startup(Simulation<OpenGL>& simulation)
                           "																\n"
                           "void main()													\n"
                           "{															\n"
+                          "    mat4 model = transforms[gl_BaseInstance + gl_InstanceID];\n"
                           "    uvsFragment = uvs;										\n"
                           "    worldPosition = vec3(model * vec4(position, 1.0f));		\n"
                           "    worldNormal = mat3(transpose(inverse(model))) * normal;	\n"
@@ -102,53 +109,108 @@ Void OpenGL::startup(Simulation<OpenGL>& simulation)
     glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
 }
 
-Void OpenGL::draw_model(Simulation<OpenGL>& simulation, const Model<OpenGL>& model)
+Bool OpenGL::begin_frame(Simulation<OpenGL>& simulation)
 {
     IVector2 size = simulation.displayManager.get_framebuffer_size();
     glViewport(0, 0, size.x, size.y);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-    for (Int32 i = 0; i < model.meshes.size(); i++)
-    {
-        Mesh<OpenGL>& mesh = simulation.resourceManager.get_mesh(model.meshes[i]);
-        Material<OpenGL>& material = simulation.resourceManager.get_material(model.materials[i]);
-        Buffer vao = get_array(mesh.vertexesHandle);
-        Pipeline& pipeline = get_pipeline(material.shaderSetHandle);
-        pipeline.bind();
-        static Float32 rot = 0.0f;
-        FMatrix4 modelMatrix = glm::rotate(FMatrix4(1.0f), glm::radians(rot), { 0.0f, 1.0f, 0.0f });
-        rot += 0.01f;
-        FMatrix4 projectionMatrix = glm::perspective(glm::radians(70.0f),
-                                                     simulation.displayManager.get_aspect_ratio(), 
-                                                     0.001f, 
-                                                     5000.0f);
-        FMatrix4 viewMatrix = glm::lookAt(FVector3{ 0.0f, 0.0f, -10.0f }, 
-                                          FVector3{ 0.0f, 0.0f, 0.0f }, 
-                                          FVector3{ 0.0f, 1.0f, 0.0f });
-        pipeline.set_mat4("model", modelMatrix);
-        pipeline.set_mat4("viewProjection", projectionMatrix * viewMatrix);
-        for (Int32 j = 0; j < material.textures.size(); ++j)
-        {
-            Handle<Texture<OpenGL>> handle = material.textures[j];
-            if (handle == Handle<Texture<OpenGL>>::NONE)
-            {
-                continue;
-            }
-    
-            const Texture<OpenGL>& texture = simulation.resourceManager.get_texture(handle);
-            Image image = get_image(texture.imageHandle);
-            String type(magic_enum::enum_name(texture.type));
-            if (texture.type == ETextureType::Albedo)
+    return true;
+}
+
+Void OpenGL::draw_queue(Simulation<OpenGL>& simulation, RenderQueue& queue)
+{
+    const DynamicArray<FMatrix4>& instanceTransforms = queue.get_instance_transforms();
+    if (instanceTransforms.empty())
+    {
+        return;
+    }
+
+    if (instancesBuffer == 0)
+    {
+        glGenBuffers(1, &instancesBuffer);
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, instancesBuffer);
+    const UInt64 transformsSize = instanceTransforms.size() * sizeof(FMatrix4);
+    if (instanceTransforms.size() > instancesCapacity)
+    {
+        instancesCapacity = std::max(UInt64(instanceTransforms.size()), instancesCapacity * 2);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, instancesCapacity * sizeof(FMatrix4), nullptr, GL_DYNAMIC_DRAW);
+    }
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, transformsSize, instanceTransforms.data());
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, instancesBuffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    RenderQueueStatistics& statistics = queue.get_statistics();
+    UInt64 boundShaderSet = Limits<UInt64>::max();
+    UInt64 boundMaterial  = Limits<UInt64>::max();
+    UInt64 boundMesh      = Limits<UInt64>::max();
+    Pipeline* pipeline = nullptr;
+    for (const DrawBatch& batch : queue.get_batches())
+    {
+        if (batch.shaderSetId != boundShaderSet)
+        {
+            pipeline = &get_pipeline(Handle<ShaderSet>{ batch.shaderSetId });
+            pipeline->bind();
+            pipeline->set_mat4("viewProjection", simulation.renderManager.get_view_projection());
+            boundShaderSet = batch.shaderSetId;
+            // Uniforms are stored per program, so new one needs them again
+            boundMaterial = Limits<UInt64>::max();
+            statistics.pipelineBindsCount++;
+        } else {
+            statistics.pipelineBindsSaved++;
+        }
+
+        if (batch.materialId != boundMaterial)
+        {
+            const Material<OpenGL>& material = simulation.resourceManager.get_material(Handle<Material<OpenGL>>{ batch.materialId });
+            for (Int32 j = 0; j < material.textures.size(); ++j)
             {
-                pipeline.set_int(type, j);
-                glActiveTexture(GL_TEXTURE0 + j);
-                glBindTexture(GL_TEXTURE_2D, image);
+                Handle<Texture<OpenGL>> handle = material.textures[j];
+                if (handle == Handle<Texture<OpenGL>>::NONE)
+                {
+                    continue;
+                }
+
+                const Texture<OpenGL>& texture = simulation.resourceManager.get_texture(handle);
+                Image image = get_image(texture.imageHandle);
+                String type(magic_enum::enum_name(texture.type));
+                if (texture.type == ETextureType::Albedo)
+                {
+                    pipeline->set_int(type, j);
+                    glActiveTexture(GL_TEXTURE0 + j);
+                    glBindTexture(GL_TEXTURE_2D, image);
+                }
             }
+            boundMaterial = batch.materialId;
+            statistics.materialBindsCount++;
+        } else {
+            statistics.materialBindsSaved++;
         }
-        
-        glBindVertexArray(vao);
-        glDrawElements(GL_TRIANGLES, mesh.indexes.size(), GL_UNSIGNED_INT, 0);
+
+        const Mesh<OpenGL>& mesh = simulation.resourceManager.get_mesh(Handle<Mesh<OpenGL>>{ batch.meshId });
+        if (batch.meshId != boundMesh)
+        {
+            glBindVertexArray(get_array(mesh.vertexesHandle));
+            boundMesh = batch.meshId;
+            statistics.meshBindsCount++;
+        } else {
+            statistics.meshBindsSaved++;
+        }
+
+        // Shader reads transform of instance from storage buffer with gl_BaseInstance + gl_InstanceID
+        glDrawElementsInstancedBaseInstance(GL_TRIANGLES,
+                                            GLsizei(mesh.indexes.size()),
+                                            GL_UNSIGNED_INT,
+                                            0,
+                                            GLsizei(batch.instancesCount),
+                                            batch.firstInstance);
+        statistics.drawsCount++;
+        statistics.instancesCount += batch.instancesCount;
     }
-    
+}
+
+Void OpenGL::end_frame(Simulation<OpenGL>& simulation)
+{
     glBindVertexArray(0);
     glActiveTexture(GL_TEXTURE0);
 }
@@ -220,6 +282,7 @@ Handle<OpenGL::Shader> OpenGL::create_shader(const String& filePath, EShaderType
     }
 
     shadersNameMap[name] = handle;
+    register_dependencies(handle);
     return handle;
 }
 
@@ -248,11 +311,26 @@ Handle<OpenGL::Shader> OpenGL::create_shader(const String& shaderCode, const Str
     }
 
     shadersNameMap[name] = handle;
+    register_dependencies(handle);
     return handle;
 }
 
 Handle<OpenGL::Pipeline> OpenGL::create_pipeline(const ShaderSet& shaderSet)
 {
+    // Program holds only linked shaders, fixed function state and vertex format are set outside of it
+    DynamicArray<UInt64> state;
+    state.push_back(UInt64(EPipelineType::Graphics));
+    for (const Handle<ShaderGL> handle : shaderSet.shaderHandles)
+    {
+        state.push_back(handle.id);
+    }
+
+    const Handle<Pipeline> cachedHandle = pipelineStateCache.find(state);
+    if (cachedHandle.id != Handle<Pipeline>::NONE.id)
+    {
+        return cachedHandle;
+    }
+
     const UInt64 pipelineId = pipelines.size();
     Pipeline& pipeline = pipelines.emplace_back();
     DynamicArray<Shader> shaders;
@@ -262,7 +340,9 @@ Handle<OpenGL::Pipeline> OpenGL::create_pipeline(const ShaderSet& shaderSet)
         shaders.push_back(get_shader(handle));
     }
 
+    const auto begin = std::chrono::steady_clock::now();
     Bool hasBeenCreated = pipeline.create_graphics_pipeline(shaders);
+    const auto end = std::chrono::steady_clock::now();
     if (!hasBeenCreated)
     {
         SPDLOG_WARN("Pipeline {} has failed to create.", pipelineId);
@@ -272,6 +352,9 @@ Handle<OpenGL::Pipeline> OpenGL::create_pipeline(const ShaderSet& shaderSet)
     }
 
     const Handle<Pipeline> handle{ pipelineId };
+    pipelineStateCache.insert(state,
+                              handle,
+                              UInt64(std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count()));
     return handle;
 }
 
@@ -283,6 +366,68 @@ Handle<OpenGL::ShaderSet> OpenGL::create_shader_set(const ShaderSet& shaderSet)
     return handle;
 }
 
+Void OpenGL::reload_dependents(const String& filePath)
+{
+    const auto iterator = shaderDependents.find(ShaderIncludes::s_normalize_path(filePath));
+    if (iterator == shaderDependents.end())
+    {
+        return;
+    }
+
+    // Copied, registering new headers of reloaded shaders modifies graph
+    const Set<UInt64> dependents = iterator->second;
+    Set<UInt64> failedShaders;
+    for (const UInt64 shaderId : dependents)
+    {
+        const Handle<Shader> shaderHandle{ shaderId };
+        if (!get_shader(shaderHandle).recreate())
+        {
+            SPDLOG_ERROR("Failed to reload shader {}", get_shader(shaderHandle).get_name());
+            failedShaders.insert(shaderId);
+            continue;
+        }
+        register_dependencies(shaderHandle);
+    }
+
+    Set<UInt64> relinkedPipelines;
+    for (const ShaderSet& shaderSet : shaderSets)
+    {
+        // Sets with the same shaders share pipeline, it is relinked once
+        if (relinkedPipelines.contains(shaderSet.pipelineHandle.id))
+        {
+            continue;
+        }
+
+        Bool isDependent = false;
+        Bool hasFailed = false;
+        DynamicArray<Shader> setShaders;
+        setShaders.reserve(shaderSet.shaderHandles.size());
+        for (const Handle<Shader> shaderHandle : shaderSet.shaderHandles)
+        {
+            isDependent = isDependent || dependents.contains(shaderHandle.id);
+            hasFailed = hasFailed || failedShaders.contains(shaderHandle.id);
+            setShaders.push_back(get_shader(shaderHandle));
+        }
+
+        // Program linked before keeps working, so set with failed shader stays as it was
+        if (!isDependent || hasFailed)
+        {
+            continue;
+        }
+
+        relinkedPipelines.insert(shaderSet.pipelineHandle.id);
+        if (!get_pipeline(shaderSet.pipelineHandle).recreate_pipeline(setShaders))
+        {
+            SPDLOG_ERROR("Failed to relink pipeline {}", shaderSet.pipelineHandle.id);
+        }
+    }
+
+    SPDLOG_INFO("Reloaded {} shaders and {} pipelines depending on {}",
+                dependents.size() - failedShaders.size(),
+                relinkedPipelines.size(),
+                filePath);
+}
+
 Void OpenGL::create_model_render_data(Simulation<OpenGL>& simulation, Model<OpenGL>& model)
 {
     for (UInt64 i = 0; i < model.meshes.size(); ++i)
@@ -524,6 +669,17 @@ OpenGL::Buffer& OpenGL::get_array(const Handle<Buffer> handle)
     return arrays[handle.id];
 }
 
+Void OpenGL::register_dependencies(Handle<Shader> shaderHandle)
+{
+    // Stale entries of removed headers are kept, they only cause extra recompilation
+    const Shader& shader = get_shader(shaderHandle);
+    shaderDependents[ShaderIncludes::s_normalize_path(shader.get_file_path())].insert(shaderHandle.id);
+    for (const String& includedFile : shader.get_included_files())
+    {
+        shaderDependents[includedFile].insert(shaderHandle.id);
+    }
+}
+
 Void OpenGL::gl_debug(UInt32 source, UInt32 type, UInt32 id, UInt32 severity, Int32 length, const Char* message, const Void* userParam)
 {
     // ignore non-significant error/warning codes
@@ -677,6 +833,12 @@ Void OpenGL::shutdown()
         glDeleteTextures(images.size(), images.data());
         images.clear();
     }
+    if (instancesBuffer != 0)
+    {
+        glDeleteBuffers(1, &instancesBuffer);
+        instancesBuffer = 0;
+        instancesCapacity = 0;
+    }
 
     for (ShaderGL& shader : shaders)
     {
@@ -684,11 +846,13 @@ Void OpenGL::shutdown()
     }
     shaders.clear();
     shadersNameMap.clear();
+    shaderDependents.clear();
 
     for (PipelineGL& pipeline : pipelines)
     {
         pipeline.clear();
     }
     pipelines.clear();
+    pipelineStateCache.clear();
     shaderSets.clear();
 }
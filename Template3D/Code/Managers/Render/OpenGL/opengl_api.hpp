@@ -2,6 +2,7 @@
 #include "Common/shader_gl.hpp"
 #include "Common/pipeline_gl.hpp"
 #include "Common/shader_set_gl.hpp"
+#include "Render/Common/pipeline_state_cache.hpp"
 
 enum class EShaderType : UInt8;
 template<typename API>
@@ -14,6 +15,7 @@ template<typename API>
 struct Texture;
 template<typename GraphicsAPI>
 class Simulation;
+class RenderQueue;
 
 class OpenGL
 {
@@ -32,13 +34,23 @@ private:
 
     DynamicArray<Shader> shaders;
     HashMap<String, Handle<Shader>> shadersNameMap;
+    // Shader ids by source file and headers they read, editing one file recompiles only its dependents
+    HashMap<String, Set<UInt64>> shaderDependents;
     DynamicArray<Pipeline> pipelines;
+    PipelineStateCache<Pipeline> pipelineStateCache;
     DynamicArray<ShaderSet> shaderSets;
 
+    // Shader storage buffer with transforms of instances, it grows when queue does not fit
+    Buffer instancesBuffer = 0;
+    UInt64 instancesCapacity = 0;
+
 public:
     Void startup(Simulation<OpenGL>& simulation);
 
-    Void draw_model(Simulation<OpenGL>& simulation, const Model<OpenGL>& model);
+    Bool begin_frame(Simulation<OpenGL>& simulation);
+    // Draws batches of sorted queue, binds are skipped when state did not change
+    Void draw_queue(Simulation<OpenGL>& simulation, RenderQueue& queue);
+    Void end_frame(Simulation<OpenGL>& simulation);
     Void draw_quad();
 
     Handle<Shader> create_shader(const String& filePath, EShaderType type);
@@ -46,6 +58,8 @@ public:
 
     Handle<Pipeline> create_pipeline(const ShaderSet& shaderSet);
     Handle<ShaderSet> create_shader_set(const ShaderSet& shaderSet);
+    // Recompiles shaders reading given file as source or header and relinks pipelines using them
+    Void reload_dependents(const String& filePath);
 
     Void create_model_render_data(Simulation<OpenGL>& simulation, Model<OpenGL>& model);
     Void create_mesh_buffers(Mesh<OpenGL>& mesh);
@@ -67,6 +81,8 @@ public:
     Void shutdown();
 
 private:
+    Void register_dependencies(Handle<Shader> shaderHandle);
+
     static Void gl_debug(UInt32 source,
                          UInt32 type,
                          UInt32 id,
@@ -1,36 +1,51 @@
 #include "buffer_vk.hpp"
 
 #include "logical_device.hpp"
-#include "physical_device.hpp"
 
-Void BufferVK::create(const PhysicalDevice& physicalDevice, const LogicalDevice& logicalDevice, VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, const VkAllocationCallbacks* allocator)
+Void BufferVK::create(const LogicalDevice& logicalDevice, MemoryAllocator& memoryAllocator, VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, const VkAllocationCallbacks* allocator, UInt64 userData)
 {
+    // Movable buffers are copied to new place during defragmentation
+    if (userData != 0)
+    {
+        usage |= VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    }
+
     VkBufferCreateInfo bufferInfo{};
     bufferInfo.sType       = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
     bufferInfo.size        = size;
     bufferInfo.usage       = usage;
     bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-    this->size = size;
+    this->size  = size;
+    this->usage = usage;
 
     if (vkCreateBuffer(logicalDevice.get_device(), &bufferInfo, allocator, &buffer) != VK_SUCCESS)
     {
         throw std::runtime_error("failed to create buffer!");
     }
 
-    VkMemoryRequirements memRequirements;
-    vkGetBufferMemoryRequirements(logicalDevice.get_device(), buffer, &memRequirements);
+    if (!memoryAllocator.allocate_buffer_memory(logicalDevice, buffer, properties, allocation, allocator, userData))
+    {
+        throw std::runtime_error("failed to allocate buffer memory!");
+    }
+    mappedMemory = allocation.mappedData;
+}
 
-    VkMemoryAllocateInfo allocInfo{};
-    allocInfo.sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    allocInfo.allocationSize  = memRequirements.size;
-    allocInfo.memoryTypeIndex = physicalDevice.find_memory_type(memRequirements.memoryTypeBits, properties);
+Void BufferVK::rebind(const LogicalDevice& logicalDevice, const MemoryAllocation& allocation, const VkAllocationCallbacks* allocator)
+{
+    VkBufferCreateInfo bufferInfo{};
+    bufferInfo.sType       = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.size        = size;
+    bufferInfo.usage       = usage;
+    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
-    if (vkAllocateMemory(logicalDevice.get_device(), &allocInfo, allocator, &memory) != VK_SUCCESS)
+    if (vkCreateBuffer(logicalDevice.get_device(), &bufferInfo, allocator, &buffer) != VK_SUCCESS)
     {
-        throw std::runtime_error("failed to allocate buffer memory!");
+        throw std::runtime_error("failed to create buffer!");
     }
 
-    vkBindBufferMemory(logicalDevice.get_device(), buffer, memory, 0);
+    this->allocation = allocation;
+    mappedMemory = allocation.mappedData;
+    vkBindBufferMemory(logicalDevice.get_device(), buffer, allocation.memory, allocation.offset);
 }
 
 VkBuffer BufferVK::get_buffer() const
@@ -38,9 +53,9 @@ VkBuffer BufferVK::get_buffer() const
     return buffer;
 }
 
-VkDeviceMemory BufferVK::get_memory() const
+const MemoryAllocation& BufferVK::get_allocation() const
 {
-    return memory;
+    return allocation;
 }
 
 Void** BufferVK::get_mapped_memory()
@@ -53,8 +68,14 @@ UInt64 BufferVK::get_size() const
     return size;
 }
 
-Void BufferVK::clear(const LogicalDevice& logicalDevice, const VkAllocationCallbacks* allocator)
+Void BufferVK::update_dynamic_buffer(const Void* data, UInt64 dataSize, UInt64 offset)
+{
+    memcpy(static_cast<UInt8*>(mappedMemory) + offset, data, dataSize);
+}
+
+Void BufferVK::clear(const LogicalDevice& logicalDevice, MemoryAllocator& memoryAllocator, const VkAllocationCallbacks* allocator)
 {
     vkDestroyBuffer(logicalDevice.get_device(), buffer, allocator);
-    vkFreeMemory(logicalDevice.get_device(), memory, allocator);
+    memoryAllocator.free(logicalDevice, allocation, allocator);
+    allocation = {};
 }
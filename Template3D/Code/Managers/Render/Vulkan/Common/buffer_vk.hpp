@@ -1,27 +1,35 @@
 #pragma once
 #include <vulkan/vulkan.hpp>
 
-class PhysicalDevice;
+#include "memory_allocator.hpp"
+
 class LogicalDevice;
 
 class BufferVK
 {
 private:
     VkBuffer buffer;
-    VkDeviceMemory memory;
+    MemoryAllocation allocation;
     Void* mappedMemory;
     UInt64 size;
+    VkBufferUsageFlags usage;
 
 public:
-    Void create(const PhysicalDevice& physicalDevice,
-                const LogicalDevice& logicalDevice,
+    // User data other than 0 allows memory allocator to move buffer during defragmentation
+    Void create(const LogicalDevice& logicalDevice,
+                MemoryAllocator& memoryAllocator,
                 VkDeviceSize size,
                 VkBufferUsageFlags usage,
                 VkMemoryPropertyFlags properties,
+                const VkAllocationCallbacks* allocator,
+                UInt64 userData = 0);
+    // Creates new buffer of the same size and usage bound to given allocation, old buffer is not destroyed
+    Void rebind(const LogicalDevice& logicalDevice,
+                const MemoryAllocation& allocation,
                 const VkAllocationCallbacks* allocator);
 
     VkBuffer get_buffer() const;
-    VkDeviceMemory get_memory() const;
+    const MemoryAllocation& get_allocation() const;
     Void** get_mapped_memory();
     UInt64 get_size() const;
 
@@ -30,7 +38,10 @@ public:
     {
         memcpy(mappedMemory, &data, sizeof(Type));
     }
+    Void update_dynamic_buffer(const Void* data, UInt64 dataSize, UInt64 offset = 0);
 
-    Void clear(const LogicalDevice& logicalDevice, const VkAllocationCallbacks* allocator);
+    Void clear(const LogicalDevice& logicalDevice,
+               MemoryAllocator& memoryAllocator,
+               const VkAllocationCallbacks* allocator);
 };
 
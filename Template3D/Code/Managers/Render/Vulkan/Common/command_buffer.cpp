@@ -72,7 +72,12 @@ Void CommandBuffer::dispatch(const UVector3& groupCount) const
     vkCmdDispatch(commandBuffer, groupCount.x, groupCount.y, groupCount.z);
 }
 
-Void CommandBuffer::set_constants(const PipelineVK& pipeline, VkShaderStageFlags stageFlags, UInt32 offset, UInt32 size, Void* data) const
+Void CommandBuffer::execute_commands(const DynamicArray<VkCommandBuffer>& commandBuffers) const
+{
+    vkCmdExecuteCommands(commandBuffer, UInt32(commandBuffers.size()), commandBuffers.data());
+}
+
+Void CommandBuffer::set_constants(const PipelineVK& pipeline, VkShaderStageFlags stageFlags, UInt32 offset, UInt32 size, const Void* data) const
 {
     vkCmdPushConstants(commandBuffer, pipeline.get_layout(), stageFlags, offset, size, data);
 }
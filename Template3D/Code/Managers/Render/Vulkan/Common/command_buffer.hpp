@@ -46,7 +46,10 @@ public:
 
     Void dispatch(const UVector3 &groupCount) const;
 
-    Void set_constants(const PipelineVK& pipeline, VkShaderStageFlags stageFlags, UInt32 offset, UInt32 size, Void* data) const;
+    // Secondary buffers are executed in given order
+    Void execute_commands(const DynamicArray<VkCommandBuffer> &commandBuffers) const;
+
+    Void set_constants(const PipelineVK& pipeline, VkShaderStageFlags stageFlags, UInt32 offset, UInt32 size, const Void* data) const;
 
     Void set_viewports(UInt32 firstViewport, const DynamicArray<VkViewport> &viewports) const;
     Void set_viewport(UInt32 firstViewport, 
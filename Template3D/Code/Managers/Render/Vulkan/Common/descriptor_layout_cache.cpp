@@ -0,0 +1,121 @@
+#include "descriptor_layout_cache.hpp"
+
+#include "logical_device.hpp"
+#include "Utilities/hash.hpp"
+
+#include <magic_enum.hpp>
+
+
+VkDescriptorSetLayout DescriptorLayoutCache::get_layout(const LogicalDevice& logicalDevice, const DynamicArray<VkDescriptorSetLayoutBinding>& bindings, const DynamicArray<VkDescriptorBindingFlags>& bindingFlags, VkDescriptorSetLayoutCreateFlags layoutFlags, const VkAllocationCallbacks* allocator)
+{
+    requestsCount++;
+
+    const UInt64 key = s_hash(bindings, bindingFlags, layoutFlags);
+    DynamicArray<Entry>& bucket = entries[key];
+    for (const Entry& entry : bucket)
+    {
+        if (s_is_equal(entry, bindings, bindingFlags, layoutFlags))
+        {
+            return entry.layout;
+        }
+    }
+
+    VkDescriptorSetLayoutBindingFlagsCreateInfo flagsInfo{};
+    flagsInfo.sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+    flagsInfo.pNext         = nullptr;
+    flagsInfo.bindingCount  = UInt32(bindingFlags.size());
+    flagsInfo.pBindingFlags = bindingFlags.data();
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = UInt32(bindings.size());
+    layoutInfo.pBindings    = bindings.data();
+    layoutInfo.pNext        = &flagsInfo;
+    layoutInfo.flags        = layoutFlags;
+
+    VkDescriptorSetLayout layout;
+    const VkResult result = vkCreateDescriptorSetLayout(logicalDevice.get_device(), &layoutInfo, allocator, &layout);
+    if (result != VK_SUCCESS)
+    {
+        SPDLOG_ERROR("Creating descriptor set layout failed with: {}", magic_enum::enum_name(result));
+        return VK_NULL_HANDLE;
+    }
+
+    Entry& entry = bucket.emplace_back();
+    entry.bindings     = bindings;
+    entry.bindingFlags = bindingFlags;
+    entry.layoutFlags  = layoutFlags;
+    entry.layout       = layout;
+    return layout;
+}
+
+UInt64 DescriptorLayoutCache::get_layouts_count() const
+{
+    UInt64 count = 0;
+    for (const auto& [key, bucket] : entries)
+    {
+        count += bucket.size();
+    }
+    return count;
+}
+
+UInt64 DescriptorLayoutCache::get_requests_count() const
+{
+    return requestsCount;
+}
+
+Void DescriptorLayoutCache::clear(const LogicalDevice& logicalDevice, const VkAllocationCallbacks* allocator)
+{
+    for (const auto& [key, bucket] : entries)
+    {
+        for (const Entry& entry : bucket)
+        {
+            vkDestroyDescriptorSetLayout(logicalDevice.get_device(), entry.layout, allocator);
+        }
+    }
+    entries.clear();
+    requestsCount = 0;
+}
+
+UInt64 DescriptorLayoutCache::s_hash(const DynamicArray<VkDescriptorSetLayoutBinding>& bindings, const DynamicArray<VkDescriptorBindingFlags>& bindingFlags, VkDescriptorSetLayoutCreateFlags layoutFlags)
+{
+    // Fields are hashed one by one, binding struct has padding and sampler pointer
+    UInt64 hash = hash_value(layoutFlags);
+    for (const VkDescriptorSetLayoutBinding& binding : bindings)
+    {
+        hash = hash_value(binding.binding, hash);
+        hash = hash_value(binding.descriptorType, hash);
+        hash = hash_value(binding.descriptorCount, hash);
+        hash = hash_value(binding.stageFlags, hash);
+    }
+    for (const VkDescriptorBindingFlags flags : bindingFlags)
+    {
+        hash = hash_value(flags, hash);
+    }
+    return hash;
+}
+
+Bool DescriptorLayoutCache::s_is_equal(const Entry& entry, const DynamicArray<VkDescriptorSetLayoutBinding>& bindings, const DynamicArray<VkDescriptorBindingFlags>& bindingFlags, VkDescriptorSetLayoutCreateFlags layoutFlags)
+{
+    if (entry.layoutFlags != layoutFlags
+        || entry.bindings.size() != bindings.size()
+        || entry.bindingFlags != bindingFlags)
+    {
+        return false;
+    }
+
+    for (UInt64 i = 0; i < bindings.size(); ++i)
+    {
+        const VkDescriptorSetLayoutBinding& left = entry.bindings[i];
+        const VkDescriptorSetLayoutBinding& right = bindings[i];
+        if (left.binding != right.binding
+            || left.descriptorType != right.descriptorType
+            || left.descriptorCount != right.descriptorCount
+            || left.stageFlags != right.stageFlags
+            || left.pImmutableSamplers != right.pImmutableSamplers)
+        {
+            return false;
+        }
+    }
+    return true;
+}
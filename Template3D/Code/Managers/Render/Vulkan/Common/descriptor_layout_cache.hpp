@@ -0,0 +1,45 @@
+#pragma once
+#include <vulkan/vulkan.hpp>
+
+class LogicalDevice;
+
+/** Set layouts shared by all descriptor pools, pipelines with the same layouts keep bound sets when switched */
+class DescriptorLayoutCache
+{
+private:
+    struct Entry
+    {
+        DynamicArray<VkDescriptorSetLayoutBinding> bindings;
+        DynamicArray<VkDescriptorBindingFlags> bindingFlags;
+        VkDescriptorSetLayoutCreateFlags layoutFlags;
+        VkDescriptorSetLayout layout;
+    };
+
+    // Entries with colliding hashes are kept together and compared field by field
+    HashMap<UInt64, DynamicArray<Entry>> entries;
+    UInt64 requestsCount = 0;
+
+public:
+    // Returns existing layout when the same bindings were requested before, VK_NULL_HANDLE on failure
+    VkDescriptorSetLayout get_layout(const LogicalDevice& logicalDevice,
+                                     const DynamicArray<VkDescriptorSetLayoutBinding>& bindings,
+                                     const DynamicArray<VkDescriptorBindingFlags>& bindingFlags,
+                                     VkDescriptorSetLayoutCreateFlags layoutFlags,
+                                     const VkAllocationCallbacks* allocator);
+
+    [[nodiscard]]
+    UInt64 get_layouts_count() const;
+    [[nodiscard]]
+    UInt64 get_requests_count() const;
+
+    Void clear(const LogicalDevice& logicalDevice, const VkAllocationCallbacks* allocator);
+
+private:
+    static UInt64 s_hash(const DynamicArray<VkDescriptorSetLayoutBinding>& bindings,
+                         const DynamicArray<VkDescriptorBindingFlags>& bindingFlags,
+                         VkDescriptorSetLayoutCreateFlags layoutFlags);
+    static Bool s_is_equal(const Entry& entry,
+                           const DynamicArray<VkDescriptorSetLayoutBinding>& bindings,
+                           const DynamicArray<VkDescriptorBindingFlags>& bindingFlags,
+                           VkDescriptorSetLayoutCreateFlags layoutFlags);
+};
@@ -1,6 +1,8 @@
 #include "descriptor_pool.hpp"
 
 #include "logical_device.hpp"
+#include "descriptor_layout_cache.hpp"
+#include "shader_reflection.hpp"
 
 #include <magic_enum.hpp>
 
@@ -28,10 +30,8 @@ Void DescriptorPool::add_binding(const String& layoutName, UInt32 setNumber, UIn
 
     data.layoutFlags |= layoutFlags;
     this->poolFlags  |= poolFlags;
-    if (bindingFlags != 0)
-    {
-        data.bindingFlags.push_back(bindingFlags);
-    }
+    // Flags count has to be zero or match bindings count
+    data.bindingFlags.push_back(bindingFlags);
     VkDescriptorSetLayoutBinding& layoutBinding = data.bindings.emplace_back();
     layoutBinding.binding         = binding;
     layoutBinding.descriptorType  = descriptorType;
@@ -39,9 +39,56 @@ Void DescriptorPool::add_binding(const String& layoutName, UInt32 setNumber, UIn
     layoutBinding.stageFlags      = stageFlags;
 }
 
-Void DescriptorPool::create_layouts(const LogicalDevice& logicalDevice, const VkAllocationCallbacks* allocator)
+Void DescriptorPool::add_bindings(const ShaderReflection& reflection, const DynamicArray<String>& layoutNames, VkDescriptorBindingFlags bindingFlags)
 {
-    create_empty(logicalDevice, allocator);
+    const Bool isUpdateAfterBind = (bindingFlags & VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT) != 0;
+    const VkDescriptorSetLayoutCreateFlags layoutFlags = isUpdateAfterBind
+                                                       ? VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT
+                                                       : 0;
+    const VkDescriptorPoolCreateFlags poolFlags = isUpdateAfterBind
+                                                ? VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT
+                                                : 0;
+
+    for (const ReflectedBinding& binding : reflection.get_bindings())
+    {
+        const String layoutName = binding.setNumber < layoutNames.size()
+                                ? layoutNames[binding.setNumber]
+                                : fmt::format("Set{}", binding.setNumber);
+
+        // Runtime arrays are last in set after sorting, so only they can have variable count
+        VkDescriptorBindingFlags flags = bindingFlags;
+        UInt32 descriptorCount = binding.descriptorCount;
+        if (descriptorCount == 0)
+        {
+            descriptorCount = UNBOUNDED_DESCRIPTORS_COUNT;
+            flags |= VK_DESCRIPTOR_BINDING_VARIABLE_DESCRIPTOR_COUNT_BIT;
+        }
+
+        add_binding(layoutName,
+                    binding.setNumber,
+                    binding.binding,
+                    binding.descriptorType,
+                    descriptorCount,
+                    binding.stageFlags,
+                    flags,
+                    layoutFlags,
+                    poolFlags);
+    }
+
+    const VkPushConstantRange& range = reflection.get_push_constants();
+    if (range.size > 0)
+    {
+        // Offsets of pool ranges start at zero, so range covers everything before reflected offset
+        VkPushConstantRange poolRange{};
+        poolRange.stageFlags = range.stageFlags;
+        poolRange.size       = range.offset + range.size;
+        set_push_constants({ poolRange });
+    }
+}
+
+Void DescriptorPool::create_layouts(const LogicalDevice& logicalDevice, DescriptorLayoutCache& layoutCache, const VkAllocationCallbacks* allocator)
+{
+    empty = layoutCache.get_layout(logicalDevice, {}, {}, 0, allocator);
     
     for (UInt64 i = 0; i < layoutData.size(); ++i)
     {
@@ -64,22 +111,10 @@ Void DescriptorPool::create_layouts(const LogicalDevice& logicalDevice, const Vk
         const Handle<DescriptorLayoutData> handle = { i };
         layoutDataNameMap[data.name] = handle;
 
-        VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlags{};
-        bindingFlags.sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
-        bindingFlags.pNext         = nullptr;
-        bindingFlags.bindingCount  = UInt32(data.bindingFlags.size());
-        bindingFlags.pBindingFlags = data.bindingFlags.data();
-
-        VkDescriptorSetLayoutCreateInfo layoutInfo{};
-        layoutInfo.sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-        layoutInfo.bindingCount = UInt32(data.bindings.size());
-        layoutInfo.pBindings    = data.bindings.data();
-        layoutInfo.pNext        = &bindingFlags;
-        layoutInfo.flags        = data.layoutFlags;
-
-        if (vkCreateDescriptorSetLayout(logicalDevice.get_device(), &layoutInfo, allocator, &data.layout) != VK_SUCCESS)
+        data.layout = layoutCache.get_layout(logicalDevice, data.bindings, data.bindingFlags, data.layoutFlags, allocator);
+        if (data.layout == VK_NULL_HANDLE)
         {
-            throw std::runtime_error("failed to create descriptor set layout!");
+            SPDLOG_ERROR("Failed to create descriptor layout: {}", data.name);
         }
     }
 }
@@ -108,6 +143,7 @@ Handle<DescriptorSetData> DescriptorPool::add_set(Handle<DescriptorLayoutData> l
     data.layoutHandle = layoutHandle;
     data.writes.resize(layout.bindings.size());
     data.resources = resources;
+    data.variableDescriptorsCount = 0;
 
     for (UInt64 i = 0; i < data.writes.size(); ++i)
     {
@@ -124,9 +160,17 @@ Handle<DescriptorSetData> DescriptorPool::add_set(Handle<DescriptorLayoutData> l
         write.pImageInfo       = data.resources[i].imageInfos.data();
         write.pTexelBufferView = data.resources[i].texelBufferViews.data();
 
+        // Variable count binding is allocated whole, rest of its descriptors is written later with update_set
+        const Bool isVariableCount = i < layout.bindingFlags.size()
+                                     && (layout.bindingFlags[i] & VK_DESCRIPTOR_BINDING_VARIABLE_DESCRIPTOR_COUNT_BIT) != 0;
+        if (isVariableCount)
+        {
+            data.variableDescriptorsCount = layout.bindings[i].descriptorCount;
+        }
+
         VkDescriptorPoolSize& size = sizes.emplace_back();  
         size.type            = write.descriptorType; 
-        size.descriptorCount = write.descriptorCount;
+        size.descriptorCount = isVariableCount ? data.variableDescriptorsCount : write.descriptorCount;
     }
     return handle;
 }
@@ -152,8 +196,7 @@ Void DescriptorPool::create_sets(const LogicalDevice& logicalDevice, const VkAll
     layouts.reserve(setData.size());
     for (const DescriptorSetData& set : setData)
     {
-        const UInt64 lastWriteIndex = set.writes.size() - 1;
-        counts.push_back(set.writes[lastWriteIndex].descriptorCount);
+        counts.push_back(set.variableDescriptorsCount);
         layouts.push_back(get_layout_data(set.layoutHandle).layout);
     }
 
@@ -194,6 +237,66 @@ Void DescriptorPool::create_sets(const LogicalDevice& logicalDevice, const VkAll
     }
 }
 
+Handle<DescriptorSetData> DescriptorPool::allocate_set(const LogicalDevice& logicalDevice, Handle<DescriptorLayoutData> layoutHandle, const DynamicArray<DescriptorResourceInfo>& resources, const String& name, const VkAllocationCallbacks* allocator)
+{
+    const Handle<DescriptorSetData> handle = add_set(layoutHandle, resources, name);
+    if (handle.id == Handle<DescriptorSetData>::NONE.id)
+    {
+        return handle;
+    }
+
+    DescriptorSetData& data = setData[handle.id];
+    const VkDescriptorSetLayout layout = get_layout_data(layoutHandle).layout;
+
+    VkDescriptorSetVariableDescriptorCountAllocateInfoEXT countAllocateInfo{};
+    countAllocateInfo.sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_VARIABLE_DESCRIPTOR_COUNT_ALLOCATE_INFO_EXT;
+    countAllocateInfo.pNext              = nullptr;
+    countAllocateInfo.descriptorSetCount = 1;
+    countAllocateInfo.pDescriptorCounts  = &data.variableDescriptorsCount;
+
+    VkDescriptorSetAllocateInfo allocateInfo{};
+    allocateInfo.sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocateInfo.pNext              = &countAllocateInfo;
+    allocateInfo.descriptorSetCount = 1;
+    allocateInfo.pSetLayouts        = &layout;
+
+    VkResult result = VK_ERROR_OUT_OF_POOL_MEMORY;
+    if (!growthPools.empty())
+    {
+        allocateInfo.descriptorPool = growthPools.back();
+        result = vkAllocateDescriptorSets(logicalDevice.get_device(), &allocateInfo, &data.set);
+    }
+
+    if (result == VK_ERROR_OUT_OF_POOL_MEMORY || result == VK_ERROR_FRAGMENTED_POOL)
+    {
+        if (!create_growth_pool(logicalDevice, allocator))
+        {
+            return Handle<DescriptorSetData>::NONE;
+        }
+        allocateInfo.descriptorPool = growthPools.back();
+        result = vkAllocateDescriptorSets(logicalDevice.get_device(), &allocateInfo, &data.set);
+    }
+
+    if (result != VK_SUCCESS)
+    {
+        SPDLOG_ERROR("Failed to allocate descriptor set: {}, with: {}", name, magic_enum::enum_name(result));
+        return Handle<DescriptorSetData>::NONE;
+    }
+
+    for (VkWriteDescriptorSet& write : data.writes)
+    {
+        write.dstSet = data.set;
+    }
+
+    vkUpdateDescriptorSets(logicalDevice.get_device(),
+                           UInt32(data.writes.size()),
+                           data.writes.data(),
+                           0,
+                           nullptr);
+
+    return handle;
+}
+
 Void DescriptorPool::update_set(const LogicalDevice& logicalDevice, const DescriptorResourceInfo& data, Handle<DescriptorSetData> handle, UInt32 arrayElement, UInt64 binding)
 {
     DescriptorSetData& set             = get_set_data(handle);
@@ -308,6 +411,11 @@ DescriptorSetData& DescriptorPool::get_set_data(const Handle<DescriptorSetData>
     return setData[handle.id];
 }
 
+Bool DescriptorPool::has_layouts() const
+{
+    return !layoutData.empty();
+}
+
 DynamicArray<VkDescriptorSetLayout> DescriptorPool::get_layouts() const
 {
     DynamicArray<VkDescriptorSetLayout> layouts;
@@ -392,30 +500,52 @@ const DynamicArray<VkPushConstantRange>& DescriptorPool::get_push_constants() co
     return pushConstants;
 }
 
-Void DescriptorPool::create_empty(const LogicalDevice& logicalDevice, const VkAllocationCallbacks* allocator)
+Bool DescriptorPool::create_growth_pool(const LogicalDevice& logicalDevice, const VkAllocationCallbacks* allocator)
 {
-    VkDescriptorSetLayoutCreateInfo layoutInfo{};
-    layoutInfo.sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-    layoutInfo.bindingCount = 0;
-    layoutInfo.pBindings    = nullptr;
-    layoutInfo.pNext        = nullptr;
-    layoutInfo.flags        = 0;
+    // Every layout of this pool could be allocated from it, so each binding gets space for all sets
+    DynamicArray<VkDescriptorPoolSize> growthSizes;
+    for (const DescriptorLayoutData& data : layoutData)
+    {
+        for (const VkDescriptorSetLayoutBinding& binding : data.bindings)
+        {
+            VkDescriptorPoolSize& size = growthSizes.emplace_back();
+            size.type            = binding.descriptorType;
+            size.descriptorCount = binding.descriptorCount * GROWTH_SETS_COUNT;
+        }
+    }
+
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.pNext         = nullptr;
+    poolInfo.poolSizeCount = UInt32(growthSizes.size());
+    poolInfo.pPoolSizes    = growthSizes.data();
+    poolInfo.maxSets       = GROWTH_SETS_COUNT;
+    poolInfo.flags         = poolFlags;
 
-    if (vkCreateDescriptorSetLayout(logicalDevice.get_device(), &layoutInfo, allocator, &empty) != VK_SUCCESS)
+    VkDescriptorPool growthPool;
+    const VkResult result = vkCreateDescriptorPool(logicalDevice.get_device(), &poolInfo, allocator, &growthPool);
+    if (result != VK_SUCCESS)
     {
-        throw std::runtime_error("failed to create descriptor set layout!");
+        SPDLOG_ERROR("Failed to create descriptor pool with: {}", magic_enum::enum_name(result));
+        return false;
     }
+
+    growthPools.push_back(growthPool);
+    return true;
 }
 
 Void DescriptorPool::clear(const LogicalDevice& logicalDevice, const VkAllocationCallbacks* allocator)
 {
     vkDestroyDescriptorPool(logicalDevice.get_device(), pool, allocator);
-    vkDestroyDescriptorSetLayout(logicalDevice.get_device(), empty, allocator);
-    for (const DescriptorLayoutData& data : layoutData)
+    for (const VkDescriptorPool growthPool : growthPools)
     {
-        if (data.layout != VK_NULL_HANDLE)
-        {
-            vkDestroyDescriptorSetLayout(logicalDevice.get_device(), data.layout, allocator);
-        }
+        vkDestroyDescriptorPool(logicalDevice.get_device(), growthPool, allocator);
+    }
+    growthPools.clear();
+    // Layouts belong to layout cache
+    empty = VK_NULL_HANDLE;
+    for (DescriptorLayoutData& data : layoutData)
+    {
+        data.layout = VK_NULL_HANDLE;
     }
 }
\ No newline at end of file
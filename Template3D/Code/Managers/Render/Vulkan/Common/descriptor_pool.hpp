@@ -2,6 +2,8 @@
 #include <vulkan/vulkan.hpp>
 
 class LogicalDevice;
+class DescriptorLayoutCache;
+class ShaderReflection;
 
 
 struct DescriptorLayoutData
@@ -27,21 +29,30 @@ struct DescriptorSetData
     DynamicArray<DescriptorResourceInfo> resources; //TODO: think of remove it
     DynamicArray<VkWriteDescriptorSet> writes;
     Handle<DescriptorLayoutData> layoutHandle;
+    // Allocated size of variable count binding, zero when layout has none
+    UInt32 variableDescriptorsCount;
     UInt32 setNumber;
     String name;
 };
 
 class DescriptorPool
 {
+public:
+    // Sets count that fits in each pool created after create_sets
+    static constexpr UInt32 GROWTH_SETS_COUNT = 64;
+    // Descriptor count of reflected runtime arrays, they are allocated with variable count
+    static constexpr UInt32 UNBOUNDED_DESCRIPTORS_COUNT = 1024;
+
 private:
     VkDescriptorPool pool = VK_NULL_HANDLE;
+    DynamicArray<VkDescriptorPool> growthPools;
     VkDescriptorPoolCreateFlags poolFlags = 0;
     DynamicArray<VkDescriptorPoolSize> sizes;
 
     HashMap<String, Handle<DescriptorLayoutData>> layoutDataNameMap;
     DynamicArray<DescriptorLayoutData> layoutData;
     DynamicArray<VkPushConstantRange> pushConstants;
-    VkDescriptorSetLayout empty;
+    VkDescriptorSetLayout empty = VK_NULL_HANDLE;
 
     HashMap<String, Handle<DescriptorSetData>> setDataNameMap;
     DynamicArray<DescriptorSetData> setData;
@@ -58,14 +69,28 @@ public:
                      VkDescriptorSetLayoutCreateFlags layoutFlags = 0,
                      VkDescriptorPoolCreateFlags poolFlags = 0);
 
-    // TODO: save set number in memory to get on bind
-    Void create_layouts(const LogicalDevice& logicalDevice, const VkAllocationCallbacks* allocator);
+    // Layout names are taken by set number, sets without name are called SetN,
+    // push constants of all stages are merged into one range
+    Void add_bindings(const ShaderReflection& reflection,
+                      const DynamicArray<String>& layoutNames,
+                      VkDescriptorBindingFlags bindingFlags = 0);
+
+    // Layouts are owned by cache, identical layouts of different pools are the same object
+    Void create_layouts(const LogicalDevice& logicalDevice,
+                        DescriptorLayoutCache& layoutCache,
+                        const VkAllocationCallbacks* allocator);
 
     Handle<DescriptorSetData> add_set(Handle<DescriptorLayoutData> layoutHandle,
                                       const DynamicArray<DescriptorResourceInfo>& resources, 
                                       const String &name);
 
     Void create_sets(const LogicalDevice& logicalDevice, const VkAllocationCallbacks* allocator);
+    // Adds and allocates set after create_sets, new pool is created when previous one runs out of memory
+    Handle<DescriptorSetData> allocate_set(const LogicalDevice& logicalDevice,
+                                           Handle<DescriptorLayoutData> layoutHandle,
+                                           const DynamicArray<DescriptorResourceInfo>& resources,
+                                           const String& name,
+                                           const VkAllocationCallbacks* allocator);
     Void update_set(const LogicalDevice& logicalDevice, 
                     const DescriptorResourceInfo& data, 
                     Handle<DescriptorSetData> handle, 
@@ -96,12 +121,14 @@ public:
     [[nodiscard]]
     const DynamicArray<VkPushConstantRange>& get_push_constants() const;
     DynamicArray<VkDescriptorSetLayout> get_layouts() const;
+    [[nodiscard]]
+    Bool has_layouts() const;
 
     Bool are_resources_compatible(const DescriptorLayoutData& layout, const DynamicArray<DescriptorResourceInfo>& resources) const;
 
     Void clear(const LogicalDevice& logicalDevice, const VkAllocationCallbacks* allocator);
 
 private:
-    Void create_empty(const LogicalDevice& logicalDevice, const VkAllocationCallbacks* allocator);
+    Bool create_growth_pool(const LogicalDevice& logicalDevice, const VkAllocationCallbacks* allocator);
 };
 
@@ -3,7 +3,7 @@
 #include "physical_device.hpp"
 #include "logical_device.hpp"
 
-Void ImageVK::create(const PhysicalDevice& physicalDevice, const LogicalDevice& logicalDevice, const UVector2& size, UInt32 mipLevel, VkSampleCountFlagBits samplesCount, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImageAspectFlags aspectFlags, const VkAllocationCallbacks* allocator)
+Void ImageVK::create(const PhysicalDevice& physicalDevice, const LogicalDevice& logicalDevice, MemoryAllocator& memoryAllocator, const UVector2& size, UInt32 mipLevel, VkSampleCountFlagBits samplesCount, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImageAspectFlags aspectFlags, const VkAllocationCallbacks* allocator)
 {
     if (!(physicalDevice.get_format_properties(format).optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT))
     {
@@ -41,21 +41,11 @@ Void ImageVK::create(const PhysicalDevice& physicalDevice, const LogicalDevice&
         throw std::runtime_error("failed to create image!");
     }
 
-    VkMemoryRequirements memRequirements;
-    vkGetImageMemoryRequirements(logicalDevice.get_device(), image, &memRequirements);
-
-    VkMemoryAllocateInfo allocInfo{};
-    allocInfo.sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    allocInfo.allocationSize  = memRequirements.size;
-    allocInfo.memoryTypeIndex = physicalDevice.find_memory_type(memRequirements.memoryTypeBits, properties);
-
-    if (vkAllocateMemory(logicalDevice.get_device(), &allocInfo, allocator, &memory) != VK_SUCCESS)
+    if (!memoryAllocator.allocate_image_memory(logicalDevice, image, tiling, properties, allocation, allocator))
     {
         throw std::runtime_error("failed to allocate image memory!");
     }
 
-    vkBindImageMemory(logicalDevice.get_device(), image, memory, 0);
-
     create_view(logicalDevice, aspectFlags, allocator);
 }
 
@@ -114,13 +104,13 @@ Void ImageVK::create_sampler(const PhysicalDevice& physicalDevice, const Logical
     }
 }
 
-Void ImageVK::resize(const PhysicalDevice& physicalDevice, const LogicalDevice& logicalDevice, const UVector2& size, const VkAllocationCallbacks* allocator)
+Void ImageVK::resize(const PhysicalDevice& physicalDevice, const LogicalDevice& logicalDevice, MemoryAllocator& memoryAllocator, const UVector2& size, const VkAllocationCallbacks* allocator)
 {
     // To prevent clearing sampler to reuse it
     const VkSampler holder = sampler;
     sampler = nullptr;
-    clear(logicalDevice, allocator);
-    create(physicalDevice, logicalDevice, size, mipLevel, samplesCount, format, tiling, usage, properties, aspectFlags, allocator);
+    clear(logicalDevice, memoryAllocator, allocator);
+    create(physicalDevice, logicalDevice, memoryAllocator, size, mipLevel, samplesCount, format, tiling, usage, properties, aspectFlags, allocator);
     sampler = holder;
 }
 
@@ -190,7 +180,7 @@ VkImageView ImageVK::s_create_view(const LogicalDevice& logicalDevice, VkImage i
     return view;
 }
 
-Void ImageVK::clear(const LogicalDevice& logicalDevice, const VkAllocationCallbacks* allocator)
+Void ImageVK::clear(const LogicalDevice& logicalDevice, MemoryAllocator& memoryAllocator, const VkAllocationCallbacks* allocator)
 {
     if (sampler != nullptr)
     {
@@ -198,6 +188,7 @@ Void ImageVK::clear(const LogicalDevice& logicalDevice, const VkAllocationCallba
     }
     vkDestroyImageView(logicalDevice.get_device(), view, allocator);
     vkDestroyImage(logicalDevice.get_device(), image, allocator);
-    vkFreeMemory(logicalDevice.get_device(), memory, allocator);
+    memoryAllocator.free(logicalDevice, allocation, allocator);
+    allocation = {};
 }
 
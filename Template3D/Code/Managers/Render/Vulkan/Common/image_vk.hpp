@@ -1,6 +1,8 @@
 #pragma once
 #include <vulkan/vulkan.hpp>
 
+#include "memory_allocator.hpp"
+
 class PhysicalDevice;
 class LogicalDevice;
 
@@ -8,7 +10,7 @@ class ImageVK
 {
 private:
     VkImage image;
-    VkDeviceMemory memory;
+    MemoryAllocation allocation;
     VkImageView view;
     VkSampler sampler = nullptr;
     UVector2 size;
@@ -24,6 +26,7 @@ private:
 public:
     Void create(const PhysicalDevice& physicalDevice,
                 const LogicalDevice& logicalDevice,
+                MemoryAllocator& memoryAllocator,
                 const UVector2& size,
                 UInt32 mipLevel,
                 VkSampleCountFlagBits samplesCount,
@@ -40,6 +43,7 @@ public:
 
     Void resize(const PhysicalDevice& physicalDevice,
                 const LogicalDevice& logicalDevice,
+                MemoryAllocator& memoryAllocator,
                 const UVector2& size,
                 const VkAllocationCallbacks* allocator);
 
@@ -60,7 +64,9 @@ public:
                                      UInt32 mipLevel,
                                      const VkAllocationCallbacks* allocator);
 
-    Void clear(const LogicalDevice& logicalDevice, const VkAllocationCallbacks* allocator);
+    Void clear(const LogicalDevice& logicalDevice,
+               MemoryAllocator& memoryAllocator,
+               const VkAllocationCallbacks* allocator);
 
 private:
     Void create_view(const LogicalDevice& logicalDevice,
@@ -0,0 +1,188 @@
+#include "immediate_context.hpp"
+
+#include "physical_device.hpp"
+#include "logical_device.hpp"
+
+#include <magic_enum.hpp>
+
+
+Void ImmediateContext::create(const PhysicalDevice& physicalDevice, const LogicalDevice& logicalDevice, const VkAllocationCallbacks* allocator)
+{
+    VkCommandPoolCreateInfo poolInfo{};
+    poolInfo.sType            = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.flags            = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    poolInfo.queueFamilyIndex = physicalDevice.get_graphics_family_index();
+
+    VkResult result = vkCreateCommandPool(logicalDevice.get_device(), &poolInfo, allocator, &pool);
+    if (result != VK_SUCCESS)
+    {
+        SPDLOG_ERROR("Creating immediate command pool failed with: {}", magic_enum::enum_name(result));
+        return;
+    }
+
+    VkCommandBufferAllocateInfo allocateInfo{};
+    allocateInfo.sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocateInfo.level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocateInfo.commandPool        = pool;
+    allocateInfo.commandBufferCount = 1;
+
+    for (Submission& submission : submissions)
+    {
+        result = vkAllocateCommandBuffers(logicalDevice.get_device(), &allocateInfo, &submission.commandBuffer);
+        if (result != VK_SUCCESS)
+        {
+            SPDLOG_ERROR("Allocating immediate command buffer failed with: {}", magic_enum::enum_name(result));
+            return;
+        }
+        submission.value         = 0;
+        submission.timelineValue = 0;
+    }
+
+    currentSubmission = 0;
+    recordedValue     = 1;
+    completedValue    = 0;
+    batchDepth        = 0;
+    isRecording       = false;
+}
+
+VkCommandBuffer ImmediateContext::begin_commands(const LogicalDevice& logicalDevice, QueueTimeline& timeline)
+{
+    Submission& submission = submissions[currentSubmission];
+    if (isRecording)
+    {
+        return submission.commandBuffer;
+    }
+
+    // Buffer is reused only after its previous submission finished
+    if (submission.value > completedValue)
+    {
+        wait(logicalDevice, timeline, submission.value);
+    }
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+    const VkResult result = vkBeginCommandBuffer(submission.commandBuffer, &beginInfo);
+    if (result != VK_SUCCESS)
+    {
+        SPDLOG_ERROR("Immediate command buffer begin failed with: {}", magic_enum::enum_name(result));
+    }
+    isRecording = true;
+
+    return submission.commandBuffer;
+}
+
+Void ImmediateContext::end_commands(const LogicalDevice& logicalDevice, QueueTimeline& timeline)
+{
+    if (batchDepth == 0)
+    {
+        wait(logicalDevice, timeline, flush(logicalDevice, timeline));
+    }
+}
+
+Void ImmediateContext::begin_batch()
+{
+    batchDepth++;
+}
+
+Void ImmediateContext::end_batch(const LogicalDevice& logicalDevice, QueueTimeline& timeline)
+{
+    if (batchDepth == 0)
+    {
+        SPDLOG_ERROR("Immediate batch has not been started.");
+        return;
+    }
+
+    batchDepth--;
+    if (batchDepth == 0)
+    {
+        flush(logicalDevice, timeline);
+    }
+}
+
+UInt64 ImmediateContext::flush(const LogicalDevice& logicalDevice, QueueTimeline& timeline)
+{
+    if (!isRecording)
+    {
+        return recordedValue - 1;
+    }
+
+    Submission& submission = submissions[currentSubmission];
+    vkEndCommandBuffer(submission.commandBuffer);
+
+    submission.timelineValue = timeline.submit(logicalDevice, EQueueType::Graphics, { submission.commandBuffer }, {});
+    submission.value         = recordedValue;
+    recordedValue++;
+    currentSubmission = (currentSubmission + 1) % SUBMISSIONS_COUNT;
+    isRecording       = false;
+
+    return submission.value;
+}
+
+Void ImmediateContext::wait(const LogicalDevice& logicalDevice, QueueTimeline& timeline, UInt64 value)
+{
+    if (value <= completedValue)
+    {
+        return;
+    }
+    if (value >= recordedValue)
+    {
+        flush(logicalDevice, timeline);
+    }
+
+    // Graphics timeline grows with submission order, so waiting for the newest matching submit is enough
+    UInt64 timelineValue = 0;
+    for (const Submission& submission : submissions)
+    {
+        if (submission.value > completedValue && submission.value <= value)
+        {
+            timelineValue = std::max(timelineValue, submission.timelineValue);
+        }
+    }
+    timeline.wait(logicalDevice, EQueueType::Graphics, timelineValue);
+    completedValue = std::min(value, recordedValue - 1);
+}
+
+Void ImmediateContext::wait_all(const LogicalDevice& logicalDevice, QueueTimeline& timeline)
+{
+    wait(logicalDevice, timeline, recordedValue - 1);
+}
+
+Bool ImmediateContext::is_completed(const LogicalDevice& logicalDevice, QueueTimeline& timeline, UInt64 value)
+{
+    if (value <= completedValue)
+    {
+        return true;
+    }
+    if (value >= recordedValue)
+    {
+        return false;
+    }
+
+    for (const Submission& submission : submissions)
+    {
+        if (submission.value > completedValue && submission.value <= value
+            && !timeline.is_completed(logicalDevice, EQueueType::Graphics, submission.timelineValue))
+        {
+            return false;
+        }
+    }
+    completedValue = value;
+    return true;
+}
+
+UInt64 ImmediateContext::get_recorded_value() const
+{
+    return recordedValue;
+}
+
+Void ImmediateContext::clear(const LogicalDevice& logicalDevice, const VkAllocationCallbacks* allocator)
+{
+    for (Submission& submission : submissions)
+    {
+        submission = {};
+    }
+    vkDestroyCommandPool(logicalDevice.get_device(), pool, allocator);
+    pool = VK_NULL_HANDLE;
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <vulkan/vulkan.hpp>
+
+#include "queue_timeline.hpp"
+
+class PhysicalDevice;
+class LogicalDevice;
+
+/** Records one time commands into recycled buffers, each flush is one graphics queue submit signaling timeline */
+class ImmediateContext
+{
+public:
+    static constexpr UInt32 SUBMISSIONS_COUNT = 3;
+
+private:
+    struct Submission
+    {
+        VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+        // Value of batch submitted with this buffer, 0 when buffer was never submitted
+        UInt64 value = 0;
+        // Graphics timeline value signaled by submit of this buffer
+        UInt64 timelineValue = 0;
+    };
+
+    VkCommandPool pool = VK_NULL_HANDLE;
+    Array<Submission, SUBMISSIONS_COUNT> submissions;
+    UInt32 currentSubmission = 0;
+    // Values grow with every flush, batch being recorded has the highest one
+    UInt64 recordedValue = 1;
+    UInt64 completedValue = 0;
+    UInt32 batchDepth = 0;
+    Bool isRecording = false;
+
+public:
+    Void create(const PhysicalDevice& physicalDevice,
+                const LogicalDevice& logicalDevice,
+                const VkAllocationCallbacks* allocator);
+
+    // Returns buffer of current batch, recording starts in free buffer when nothing is recorded yet
+    VkCommandBuffer begin_commands(const LogicalDevice& logicalDevice, QueueTimeline& timeline);
+    // Outside of batch recorded commands are submitted and waited for, inside batch they wait for end_batch
+    Void end_commands(const LogicalDevice& logicalDevice, QueueTimeline& timeline);
+
+    // Batches can be nested, the outermost end_batch flushes without waiting
+    Void begin_batch();
+    Void end_batch(const LogicalDevice& logicalDevice, QueueTimeline& timeline);
+
+    // Submits recorded commands and returns value that can be awaited
+    UInt64 flush(const LogicalDevice& logicalDevice, QueueTimeline& timeline);
+    // Value of batch being recorded is flushed first
+    Void wait(const LogicalDevice& logicalDevice, QueueTimeline& timeline, UInt64 value);
+    Void wait_all(const LogicalDevice& logicalDevice, QueueTimeline& timeline);
+    [[nodiscard]]
+    Bool is_completed(const LogicalDevice& logicalDevice, QueueTimeline& timeline, UInt64 value);
+    // Value which will be signaled by commands recorded now
+    [[nodiscard]]
+    UInt64 get_recorded_value() const;
+
+    Void clear(const LogicalDevice& logicalDevice, const VkAllocationCallbacks* allocator);
+};
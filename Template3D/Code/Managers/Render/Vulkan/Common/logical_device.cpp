@@ -14,7 +14,8 @@ Void LogicalDevice::create(const PhysicalDevice& physicalDevice, const DebugMess
     {
         physicalDevice.get_graphics_family_index(),
         physicalDevice.get_compute_family_index(),
-        physicalDevice.get_present_family_index()
+        physicalDevice.get_present_family_index(),
+        physicalDevice.get_transfer_family_index()
     };
     
     Array<Float32, 2> priorities = { 1.0f, 1.0f };
@@ -24,7 +25,11 @@ Void LogicalDevice::create(const PhysicalDevice& physicalDevice, const DebugMess
         VkDeviceQueueCreateInfo queueCreateInfo{};
         queueCreateInfo.sType            = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
         queueCreateInfo.queueFamilyIndex = queueFamily;
-        queueCreateInfo.queueCount       = UInt32(priorities.size());
+        // Dedicated transfer family needs only one queue
+        queueCreateInfo.queueCount       = physicalDevice.has_dedicated_transfer_family()
+                                           && queueFamily == physicalDevice.get_transfer_family_index()
+                                         ? 1U
+                                         : UInt32(priorities.size());
         queueCreateInfo.pQueuePriorities = priorities.data();
         queueCreateInfos.push_back(queueCreateInfo);
     }
@@ -35,9 +40,15 @@ Void LogicalDevice::create(const PhysicalDevice& physicalDevice, const DebugMess
     robustness2Features.pNext = nullptr;
     robustness2Features.nullDescriptor = VK_TRUE;
 
+    // Queues are synchronized with per queue timeline values
+    VkPhysicalDeviceTimelineSemaphoreFeatures timelineSemaphoreFeatures{};
+    timelineSemaphoreFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+    timelineSemaphoreFeatures.pNext = &robustness2Features;
+    timelineSemaphoreFeatures.timelineSemaphore = VK_TRUE;
+
     VkPhysicalDeviceDescriptorIndexingFeatures descriptorIndexingFeatures{};
     descriptorIndexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
-    descriptorIndexingFeatures.pNext = &robustness2Features;
+    descriptorIndexingFeatures.pNext = &timelineSemaphoreFeatures;
     descriptorIndexingFeatures.shaderSampledImageArrayNonUniformIndexing     = VK_TRUE;
     descriptorIndexingFeatures.descriptorBindingStorageImageUpdateAfterBind  = VK_TRUE;
     descriptorIndexingFeatures.descriptorBindingSampledImageUpdateAfterBind  = VK_TRUE;
@@ -47,14 +58,18 @@ Void LogicalDevice::create(const PhysicalDevice& physicalDevice, const DebugMess
     descriptorIndexingFeatures.descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE;
     descriptorIndexingFeatures.descriptorBindingPartiallyBound               = VK_TRUE;
     descriptorIndexingFeatures.runtimeDescriptorArray                        = VK_TRUE;
+    descriptorIndexingFeatures.descriptorBindingVariableDescriptorCount      = VK_TRUE;
 
     VkPhysicalDeviceFeatures2 deviceFeatures{};
     deviceFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
     deviceFeatures.pNext = &descriptorIndexingFeatures;
     deviceFeatures.features.samplerAnisotropy = VK_TRUE;
     deviceFeatures.features.sampleRateShading = VK_TRUE;
+    // Material texture index comes from push constant, so it is uniform for whole draw
+    deviceFeatures.features.shaderSampledImageArrayDynamicIndexing = VK_TRUE;
     if (!physicalDevice.are_features_supported(deviceFeatures.features) ||
         !physicalDevice.are_features_supported(descriptorIndexingFeatures) ||
+        !physicalDevice.are_features_supported(timelineSemaphoreFeatures) ||
         !physicalDevice.are_features_supported(robustness2Features))
     {
         return;
@@ -86,6 +101,7 @@ Void LogicalDevice::create(const PhysicalDevice& physicalDevice, const DebugMess
     vkGetDeviceQueue(device, physicalDevice.get_present_family_index(), 0, &presentQueue);
     vkGetDeviceQueue(device, physicalDevice.get_graphics_family_index(), 0, &graphicsQueue);
     vkGetDeviceQueue(device, physicalDevice.get_compute_family_index(), 1, &computeQueue);
+    vkGetDeviceQueue(device, physicalDevice.get_transfer_family_index(), 0, &transferQueue);
 }
 
 VkResult LogicalDevice::acquire_next_image(Swapchain& swapchain, VkSemaphore semaphore, VkFence fence, UInt64 timeout) const
@@ -238,6 +254,16 @@ VkResult LogicalDevice::submit_compute_queue(VkSemaphore waitSemaphore, VkPipeli
     return result;
 }
 
+VkResult LogicalDevice::submit_transfer_queue(const DynamicArray<VkSubmitInfo>& infos, VkFence fence) const
+{
+    VkResult result = vkQueueSubmit(transferQueue, UInt32(infos.size()), infos.data(), fence);
+    if (result != VK_SUCCESS)
+    {
+        SPDLOG_ERROR("Submit transfer queue failed with: {}", magic_enum::enum_name(result));
+    }
+    return result;
+}
+
 VkResult LogicalDevice::submit_present_queue(const DynamicArray<VkSemaphore>& waitSemaphores, const DynamicArray<Swapchain>& swapchains, VkResult* results, Void* next) const
 {
     DynamicArray<VkSwapchainKHR> vkSwapchains;
@@ -328,6 +354,11 @@ VkResult LogicalDevice::wait_present_queue_idle() const
     return vkQueueWaitIdle(presentQueue);
 }
 
+VkResult LogicalDevice::wait_transfer_queue_idle() const
+{
+    return vkQueueWaitIdle(transferQueue);
+}
+
 VkDevice LogicalDevice::get_device() const
 {
     return device;
@@ -348,6 +379,11 @@ VkQueue LogicalDevice::get_present_queue() const
     return presentQueue;
 }
 
+VkQueue LogicalDevice::get_transfer_queue() const
+{
+    return transferQueue;
+}
+
 Void LogicalDevice::clear(const VkAllocationCallbacks* allocator)
 {
     vkDestroyDevice(device, allocator);
@@ -12,6 +12,8 @@ private:
     VkQueue graphicsQueue = nullptr;
     VkQueue presentQueue = nullptr;
     VkQueue computeQueue = nullptr;
+    // The same as graphics queue when device has no transfer only family
+    VkQueue transferQueue = nullptr;
 
 public:
     Void create(const PhysicalDevice& physicalDevice, 
@@ -59,6 +61,8 @@ public:
                                   VkFence fence,
                                   Void* next = nullptr) const;
 
+    VkResult submit_transfer_queue(const DynamicArray<VkSubmitInfo>& infos, VkFence fence) const;
+
     VkResult submit_present_queue(const DynamicArray<VkSemaphore> &waitSemaphores,
                                   const DynamicArray<Swapchain> &swapchains, 
                                   VkResult *results = nullptr,
@@ -76,11 +80,13 @@ public:
     VkResult wait_graphics_queue_idle() const;
     VkResult wait_compute_queue_idle() const;
     VkResult wait_present_queue_idle() const;
+    VkResult wait_transfer_queue_idle() const;
 
     VkDevice get_device() const;
     VkQueue get_graphics_queue() const;
     VkQueue get_compute_queue() const;
     VkQueue get_present_queue() const;
+    VkQueue get_transfer_queue() const;
 
     Void clear(const VkAllocationCallbacks* allocator);
 };
@@ -0,0 +1,585 @@
+#include "memory_allocator.hpp"
+
+#include "physical_device.hpp"
+#include "logical_device.hpp"
+
+#include <magic_enum.hpp>
+
+
+Bool MemoryAllocation::is_dedicated() const
+{
+    return blockIndex == Limits<UInt32>::max();
+}
+
+Void MemoryAllocator::create(const PhysicalDevice& physicalDevice)
+{
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice.get_device(), &memoryProperties);
+
+    // Small heaps would be taken by a few blocks, so their blocks are smaller
+    blockSizes.resize(memoryProperties.memoryHeapCount);
+    for (UInt32 i = 0; i < memoryProperties.memoryHeapCount; ++i)
+    {
+        UInt64 blockSize = DEFAULT_BLOCK_SIZE;
+        while (blockSize > MIN_BLOCK_SIZE && blockSize > memoryProperties.memoryHeaps[i].size / 8)
+        {
+            blockSize /= 2;
+        }
+        blockSizes[i] = blockSize;
+    }
+
+    pools.resize(UInt64(memoryProperties.memoryTypeCount) * UInt64(EResourceTiling::Count));
+
+    const VkPhysicalDeviceLimits& limits = physicalDevice.get_properties().limits;
+    maxAllocationsCount = limits.maxMemoryAllocationCount;
+    SPDLOG_INFO("Memory allocator created, max allocations: {}, buffer image granularity: {}.",
+                maxAllocationsCount,
+                limits.bufferImageGranularity);
+}
+
+Bool MemoryAllocator::allocate_buffer_memory(const LogicalDevice& logicalDevice, VkBuffer buffer, VkMemoryPropertyFlags properties, MemoryAllocation& allocation, const VkAllocationCallbacks* allocator, UInt64 userData)
+{
+    VkBufferMemoryRequirementsInfo2 requirementsInfo{};
+    requirementsInfo.sType  = VK_STRUCTURE_TYPE_BUFFER_MEMORY_REQUIREMENTS_INFO_2;
+    requirementsInfo.buffer = buffer;
+
+    VkMemoryDedicatedRequirements dedicatedRequirements{};
+    dedicatedRequirements.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS;
+
+    VkMemoryRequirements2 requirements{};
+    requirements.sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2;
+    requirements.pNext = &dedicatedRequirements;
+    vkGetBufferMemoryRequirements2(logicalDevice.get_device(), &requirementsInfo, &requirements);
+
+    VkMemoryDedicatedAllocateInfo dedicatedInfo{};
+    dedicatedInfo.sType  = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO;
+    dedicatedInfo.buffer = buffer;
+    const Bool isDedicated = dedicatedRequirements.prefersDedicatedAllocation
+                          || dedicatedRequirements.requiresDedicatedAllocation;
+
+    allocation.userData = userData;
+    {
+        std::scoped_lock lock(mutex);
+        if (!allocate(logicalDevice,
+                      requirements.memoryRequirements,
+                      properties,
+                      EResourceTiling::Linear,
+                      isDedicated ? &dedicatedInfo : nullptr,
+                      allocation,
+                      allocator))
+        {
+            return false;
+        }
+    }
+
+    const VkResult result = vkBindBufferMemory(logicalDevice.get_device(), buffer, allocation.memory, allocation.offset);
+    if (result != VK_SUCCESS)
+    {
+        SPDLOG_ERROR("Binding buffer memory failed with: {}", magic_enum::enum_name(result));
+        free(logicalDevice, allocation, allocator);
+        return false;
+    }
+    return true;
+}
+
+Bool MemoryAllocator::allocate_image_memory(const LogicalDevice& logicalDevice, VkImage image, VkImageTiling tiling, VkMemoryPropertyFlags properties, MemoryAllocation& allocation, const VkAllocationCallbacks* allocator)
+{
+    VkImageMemoryRequirementsInfo2 requirementsInfo{};
+    requirementsInfo.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_REQUIREMENTS_INFO_2;
+    requirementsInfo.image = image;
+
+    VkMemoryDedicatedRequirements dedicatedRequirements{};
+    dedicatedRequirements.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS;
+
+    VkMemoryRequirements2 requirements{};
+    requirements.sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2;
+    requirements.pNext = &dedicatedRequirements;
+    vkGetImageMemoryRequirements2(logicalDevice.get_device(), &requirementsInfo, &requirements);
+
+    VkMemoryDedicatedAllocateInfo dedicatedInfo{};
+    dedicatedInfo.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO;
+    dedicatedInfo.image = image;
+    const Bool isDedicated = dedicatedRequirements.prefersDedicatedAllocation
+                          || dedicatedRequirements.requiresDedicatedAllocation;
+
+    // Images are not moved by defragmentation, their layouts are not known here
+    allocation.userData = 0;
+    {
+        std::scoped_lock lock(mutex);
+        if (!allocate(logicalDevice,
+                      requirements.memoryRequirements,
+                      properties,
+                      tiling == VK_IMAGE_TILING_OPTIMAL ? EResourceTiling::Optimal : EResourceTiling::Linear,
+                      isDedicated ? &dedicatedInfo : nullptr,
+                      allocation,
+                      allocator))
+        {
+            return false;
+        }
+    }
+
+    const VkResult result = vkBindImageMemory(logicalDevice.get_device(), image, allocation.memory, allocation.offset);
+    if (result != VK_SUCCESS)
+    {
+        SPDLOG_ERROR("Binding image memory failed with: {}", magic_enum::enum_name(result));
+        free(logicalDevice, allocation, allocator);
+        return false;
+    }
+    return true;
+}
+
+Void MemoryAllocator::free(const LogicalDevice& logicalDevice, const MemoryAllocation& allocation, const VkAllocationCallbacks* allocator)
+{
+    if (allocation.memory == VK_NULL_HANDLE)
+    {
+        return;
+    }
+
+    std::scoped_lock lock(mutex);
+    if (allocation.is_dedicated())
+    {
+        vkFreeMemory(logicalDevice.get_device(), allocation.memory, allocator);
+        statistics.dedicatedAllocationsCount--;
+        statistics.dedicatedBytes -= allocation.size;
+        statistics.allocationsCount--;
+        statistics.requestedBytes -= allocation.size;
+        return;
+    }
+
+    DynamicArray<MemoryBlock>& pool = get_pool(allocation.memoryType, allocation.tiling);
+    MemoryBlock& block = pool[allocation.blockIndex];
+    free_from_block(block, allocation);
+    if (!block.allocations.empty() || block.isEvacuated)
+    {
+        return;
+    }
+
+    // One empty block is kept, so allocating and freeing the same resource does not allocate memory every time
+    for (UInt64 i = 0; i < pool.size(); ++i)
+    {
+        if (i != allocation.blockIndex && pool[i].memory != VK_NULL_HANDLE)
+        {
+            release_block(logicalDevice, block, allocator);
+            return;
+        }
+    }
+}
+
+DynamicArray<DefragmentationMove> MemoryAllocator::begin_defragmentation(UInt64 maxBytesToMove)
+{
+    std::scoped_lock lock(mutex);
+    DynamicArray<DefragmentationMove> moves;
+    UInt64 bytesToMove = maxBytesToMove;
+    for (DynamicArray<MemoryBlock>& pool : pools)
+    {
+        DynamicArray<UInt32> blockIndexes;
+        for (UInt32 i = 0; i < UInt32(pool.size()); ++i)
+        {
+            if (pool[i].memory != VK_NULL_HANDLE && !pool[i].isEvacuated)
+            {
+                blockIndexes.push_back(i);
+            }
+        }
+        if (blockIndexes.size() < 2)
+        {
+            continue;
+        }
+
+        // Least used blocks are the cheapest to empty, the most used one is never a source
+        std::sort(blockIndexes.begin(), blockIndexes.end(), [&pool](UInt32 left, UInt32 right)
+        {
+            return pool[left].usedBytes < pool[right].usedBytes;
+        });
+
+        // Allocations moved in this pass have to stay in place, their data is not copied yet
+        std::set<UInt32> destinationBlocks;
+        for (UInt64 i = 0; i + 1 < blockIndexes.size(); ++i)
+        {
+            MemoryBlock& source = pool[blockIndexes[i]];
+            if (source.allocations.empty() || destinationBlocks.contains(blockIndexes[i]))
+            {
+                continue;
+            }
+            if (source.usedBytes > bytesToMove)
+            {
+                break;
+            }
+
+            Bool isMovable = true;
+            for (const auto& [offset, allocation] : source.allocations)
+            {
+                isMovable &= allocation.userData != 0;
+            }
+            if (!isMovable)
+            {
+                continue;
+            }
+
+            source.isEvacuated = true;
+            DynamicArray<DefragmentationMove> blockMoves;
+            Bool hasFit = true;
+            for (const auto& [offset, allocation] : source.allocations)
+            {
+                MemoryAllocation destination = allocation;
+                if (!allocate_from_blocks(pool, allocation.order, destination))
+                {
+                    hasFit = false;
+                    break;
+                }
+                blockMoves.push_back({ allocation, destination });
+            }
+
+            if (!hasFit)
+            {
+                for (const DefragmentationMove& move : blockMoves)
+                {
+                    free_from_block(pool[move.destination.blockIndex], move.destination);
+                }
+                source.isEvacuated = false;
+                // Next blocks are even more used, so they would not fit either
+                break;
+            }
+
+            bytesToMove -= source.usedBytes;
+            for (const DefragmentationMove& move : blockMoves)
+            {
+                destinationBlocks.insert(move.destination.blockIndex);
+                moves.push_back(move);
+            }
+        }
+    }
+
+    return moves;
+}
+
+Void MemoryAllocator::end_defragmentation(const LogicalDevice& logicalDevice, const DynamicArray<DefragmentationMove>& moves, const VkAllocationCallbacks* allocator)
+{
+    std::scoped_lock lock(mutex);
+    for (const DefragmentationMove& move : moves)
+    {
+        const MemoryAllocation& source = move.source;
+        free_from_block(get_pool(source.memoryType, source.tiling)[source.blockIndex], source);
+    }
+
+    for (DynamicArray<MemoryBlock>& pool : pools)
+    {
+        for (MemoryBlock& block : pool)
+        {
+            if (block.isEvacuated)
+            {
+                if (!block.allocations.empty())
+                {
+                    SPDLOG_ERROR("Evacuated memory block still has {} allocations.", block.allocations.size());
+                    block.isEvacuated = false;
+                    continue;
+                }
+                release_block(logicalDevice, block, allocator);
+            }
+        }
+    }
+}
+
+MemoryStatistics MemoryAllocator::get_statistics()
+{
+    std::scoped_lock lock(mutex);
+    return statistics;
+}
+
+Void MemoryAllocator::clear(const LogicalDevice& logicalDevice, const VkAllocationCallbacks* allocator)
+{
+    std::scoped_lock lock(mutex);
+    if (statistics.allocationsCount > 0)
+    {
+        SPDLOG_WARN("Memory allocator cleared with {} allocations still alive.", statistics.allocationsCount);
+    }
+
+    for (DynamicArray<MemoryBlock>& pool : pools)
+    {
+        for (MemoryBlock& block : pool)
+        {
+            if (block.memory != VK_NULL_HANDLE)
+            {
+                release_block(logicalDevice, block, allocator);
+            }
+        }
+    }
+    pools.clear();
+    blockSizes.clear();
+}
+
+Bool MemoryAllocator::allocate(const LogicalDevice& logicalDevice, const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, EResourceTiling tiling, const VkMemoryDedicatedAllocateInfo* dedicatedInfo, MemoryAllocation& allocation, const VkAllocationCallbacks* allocator)
+{
+    const UInt32 memoryType = find_memory_type(requirements.memoryTypeBits, properties);
+    if (memoryType == Limits<UInt32>::max())
+    {
+        SPDLOG_ERROR("Failed to find memory type with properties: {}.", properties);
+        return false;
+    }
+
+    allocation.memoryType = memoryType;
+    allocation.tiling     = tiling;
+    allocation.size       = requirements.size;
+
+    // Large resources would waste half of block in the worst case, so they get own memory
+    const UInt64 blockSize = blockSizes[memoryProperties.memoryTypes[memoryType].heapIndex];
+    if (dedicatedInfo != nullptr || requirements.size > blockSize / 2)
+    {
+        return allocate_dedicated(logicalDevice, requirements, memoryType, dedicatedInfo, allocation, allocator);
+    }
+
+    // Buddy blocks are aligned to own size, so alignment is satisfied by large enough order
+    const UInt8 order = s_get_order(std::max(requirements.size, requirements.alignment));
+    DynamicArray<MemoryBlock>& pool = get_pool(memoryType, tiling);
+    if (allocate_from_blocks(pool, order, allocation))
+    {
+        return true;
+    }
+
+    if (!create_block(logicalDevice, pool, memoryType, allocator))
+    {
+        return false;
+    }
+    return allocate_from_blocks(pool, order, allocation);
+}
+
+Bool MemoryAllocator::allocate_dedicated(const LogicalDevice& logicalDevice, const VkMemoryRequirements& requirements, UInt32 memoryType, const VkMemoryDedicatedAllocateInfo* dedicatedInfo, MemoryAllocation& allocation, const VkAllocationCallbacks* allocator)
+{
+    if (statistics.blocksCount + statistics.dedicatedAllocationsCount >= maxAllocationsCount)
+    {
+        SPDLOG_ERROR("Device memory allocations limit {} reached.", maxAllocationsCount);
+        return false;
+    }
+
+    VkMemoryAllocateInfo allocateInfo{};
+    allocateInfo.sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocateInfo.pNext           = dedicatedInfo;
+    allocateInfo.allocationSize  = requirements.size;
+    allocateInfo.memoryTypeIndex = memoryType;
+
+    VkResult result = vkAllocateMemory(logicalDevice.get_device(), &allocateInfo, allocator, &allocation.memory);
+    if (result != VK_SUCCESS)
+    {
+        SPDLOG_ERROR("Dedicated memory allocation failed with: {}", magic_enum::enum_name(result));
+        allocation.memory = VK_NULL_HANDLE;
+        return false;
+    }
+
+    allocation.offset     = 0;
+    allocation.blockIndex = Limits<UInt32>::max();
+    allocation.order      = 0;
+    allocation.mappedData = nullptr;
+    if (memoryProperties.memoryTypes[memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+    {
+        result = vkMapMemory(logicalDevice.get_device(), allocation.memory, 0, VK_WHOLE_SIZE, 0, &allocation.mappedData);
+        if (result != VK_SUCCESS)
+        {
+            SPDLOG_ERROR("Mapping dedicated memory failed with: {}", magic_enum::enum_name(result));
+        }
+    }
+
+    statistics.dedicatedAllocationsCount++;
+    statistics.dedicatedBytes += requirements.size;
+    statistics.allocationsCount++;
+    statistics.requestedBytes += requirements.size;
+    return true;
+}
+
+Bool MemoryAllocator::allocate_from_blocks(DynamicArray<MemoryBlock>& pool, UInt8 order, MemoryAllocation& allocation)
+{
+    for (UInt32 i = 0; i < UInt32(pool.size()); ++i)
+    {
+        MemoryBlock& block = pool[i];
+        if (block.memory == VK_NULL_HANDLE || block.isEvacuated || order > block.maxOrder)
+        {
+            continue;
+        }
+
+        UInt64 offset;
+        if (!s_allocate_in_block(block, order, offset))
+        {
+            continue;
+        }
+
+        allocation.memory     = block.memory;
+        allocation.offset     = offset;
+        allocation.order      = order;
+        allocation.blockIndex = i;
+        allocation.mappedData = block.mappedData ? static_cast<UInt8*>(block.mappedData) + offset : nullptr;
+
+        const UInt64 orderSize = MIN_ALLOCATION_SIZE << order;
+        block.usedBytes += orderSize;
+        block.allocations[offset] = allocation;
+        statistics.allocationsCount++;
+        statistics.usedBytes += orderSize;
+        statistics.requestedBytes += allocation.size;
+        return true;
+    }
+
+    return false;
+}
+
+Bool MemoryAllocator::create_block(const LogicalDevice& logicalDevice, DynamicArray<MemoryBlock>& pool, UInt32 memoryType, const VkAllocationCallbacks* allocator)
+{
+    if (statistics.blocksCount + statistics.dedicatedAllocationsCount >= maxAllocationsCount)
+    {
+        SPDLOG_ERROR("Device memory allocations limit {} reached.", maxAllocationsCount);
+        return false;
+    }
+
+    // Slots of released blocks are reused, so block indexes of allocations stay valid
+    MemoryBlock* block = nullptr;
+    for (MemoryBlock& candidate : pool)
+    {
+        if (candidate.memory == VK_NULL_HANDLE && !candidate.isEvacuated)
+        {
+            block = &candidate;
+            break;
+        }
+    }
+    if (block == nullptr)
+    {
+        block = &pool.emplace_back();
+    }
+
+    const UInt64 blockSize = blockSizes[memoryProperties.memoryTypes[memoryType].heapIndex];
+    VkMemoryAllocateInfo allocateInfo{};
+    allocateInfo.sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocateInfo.allocationSize  = blockSize;
+    allocateInfo.memoryTypeIndex = memoryType;
+
+    VkResult result = vkAllocateMemory(logicalDevice.get_device(), &allocateInfo, allocator, &block->memory);
+    if (result != VK_SUCCESS)
+    {
+        SPDLOG_ERROR("Memory block allocation failed with: {}", magic_enum::enum_name(result));
+        block->memory = VK_NULL_HANDLE;
+        return false;
+    }
+
+    // Host visible blocks stay mapped for whole lifetime, memory can be mapped only once
+    if (memoryProperties.memoryTypes[memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+    {
+        result = vkMapMemory(logicalDevice.get_device(), block->memory, 0, VK_WHOLE_SIZE, 0, &block->mappedData);
+        if (result != VK_SUCCESS)
+        {
+            SPDLOG_ERROR("Mapping memory block failed with: {}", magic_enum::enum_name(result));
+            block->mappedData = nullptr;
+        }
+    }
+
+    block->size     = blockSize;
+    block->maxOrder = s_get_order(blockSize);
+    block->freeLists.assign(block->maxOrder + 1, {});
+    block->freeLists[block->maxOrder].push_back(0);
+    block->freeOrders[0] = block->maxOrder;
+    block->usedBytes = 0;
+
+    statistics.blocksCount++;
+    statistics.blocksBytes += blockSize;
+    return true;
+}
+
+Void MemoryAllocator::free_from_block(MemoryBlock& block, const MemoryAllocation& allocation)
+{
+    const auto& iterator = block.allocations.find(allocation.offset);
+    if (iterator == block.allocations.end())
+    {
+        SPDLOG_ERROR("Allocation with offset {} not found in memory block.", allocation.offset);
+        return;
+    }
+    block.allocations.erase(iterator);
+    s_free_in_block(block, allocation.offset, allocation.order);
+
+    const UInt64 orderSize = MIN_ALLOCATION_SIZE << allocation.order;
+    block.usedBytes -= orderSize;
+    statistics.allocationsCount--;
+    statistics.usedBytes -= orderSize;
+    statistics.requestedBytes -= allocation.size;
+}
+
+Void MemoryAllocator::release_block(const LogicalDevice& logicalDevice, MemoryBlock& block, const VkAllocationCallbacks* allocator)
+{
+    vkFreeMemory(logicalDevice.get_device(), block.memory, allocator);
+    statistics.blocksCount--;
+    statistics.blocksBytes -= block.size;
+    block = MemoryBlock{};
+}
+
+UInt32 MemoryAllocator::find_memory_type(UInt32 typeFilter, VkMemoryPropertyFlags properties) const
+{
+    for (UInt32 i = 0; i < memoryProperties.memoryTypeCount; ++i)
+    {
+        if (typeFilter & (1 << i) && (memoryProperties.memoryTypes[i].propertyFlags & properties) == properties)
+        {
+            return i;
+        }
+    }
+
+    return Limits<UInt32>::max();
+}
+
+DynamicArray<MemoryAllocator::MemoryBlock>& MemoryAllocator::get_pool(UInt32 memoryType, EResourceTiling tiling)
+{
+    return pools[UInt64(memoryType) * UInt64(EResourceTiling::Count) + UInt64(tiling)];
+}
+
+Bool MemoryAllocator::s_allocate_in_block(MemoryBlock& block, UInt8 order, UInt64& offset)
+{
+    UInt8 current = order;
+    while (current <= block.maxOrder && block.freeLists[current].empty())
+    {
+        ++current;
+    }
+    if (current > block.maxOrder)
+    {
+        return false;
+    }
+
+    offset = block.freeLists[current].back();
+    block.freeLists[current].pop_back();
+    block.freeOrders.erase(offset);
+
+    // Larger free block is split in halves until it has requested order, second halves stay free
+    while (current > order)
+    {
+        --current;
+        const UInt64 buddy = offset + (MIN_ALLOCATION_SIZE << current);
+        block.freeLists[current].push_back(buddy);
+        block.freeOrders[buddy] = current;
+    }
+    return true;
+}
+
+Void MemoryAllocator::s_free_in_block(MemoryBlock& block, UInt64 offset, UInt8 order)
+{
+    // Merges with buddy as long as buddy of the same order is free
+    while (order < block.maxOrder)
+    {
+        const UInt64 buddy = offset ^ (MIN_ALLOCATION_SIZE << order);
+        const auto& iterator = block.freeOrders.find(buddy);
+        if (iterator == block.freeOrders.end() || iterator->second != order)
+        {
+            break;
+        }
+        block.freeOrders.erase(iterator);
+
+        DynamicArray<UInt64>& freeList = block.freeLists[order];
+        const auto& buddyIterator = std::find(freeList.begin(), freeList.end(), buddy);
+        *buddyIterator = freeList.back();
+        freeList.pop_back();
+
+        offset = std::min(offset, buddy);
+        ++order;
+    }
+
+    block.freeLists[order].push_back(offset);
+    block.freeOrders[offset] = order;
+}
+
+UInt8 MemoryAllocator::s_get_order(UInt64 size)
+{
+    UInt8 order = 0;
+    while ((MIN_ALLOCATION_SIZE << order) < size)
+    {
+        ++order;
+    }
+    return order;
+}
@@ -0,0 +1,151 @@
+#pragma once
+#include <vulkan/vulkan.hpp>
+#include <mutex>
+
+class PhysicalDevice;
+class LogicalDevice;
+
+// Linear and optimal resources are kept in separate blocks, so bufferImageGranularity never has to be padded
+enum class EResourceTiling : UInt8
+{
+    Linear = 0U,
+    Optimal,
+    Count
+};
+
+struct MemoryAllocation
+{
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    UInt64 offset = 0;
+    UInt64 size = 0;
+    // Persistently mapped pointer to allocation start, nullptr when memory is not host visible
+    Void* mappedData = nullptr;
+    UInt32 memoryType = 0;
+    // Index of block in its pool, dedicated allocations do not have one
+    UInt32 blockIndex = Limits<UInt32>::max();
+    UInt8 order = 0;
+    EResourceTiling tiling = EResourceTiling::Linear;
+    // Owner of allocation, 0 means that allocation can not be moved by defragmentation
+    UInt64 userData = 0;
+
+    [[nodiscard]]
+    Bool is_dedicated() const;
+};
+
+struct MemoryStatistics
+{
+    UInt64 blocksCount               = 0;
+    UInt64 blocksBytes               = 0;
+    UInt64 dedicatedAllocationsCount = 0;
+    UInt64 dedicatedBytes            = 0;
+    UInt64 allocationsCount          = 0;
+    // Bytes taken in blocks, including rounding to power of two
+    UInt64 usedBytes                 = 0;
+    // Bytes requested by resources
+    UInt64 requestedBytes            = 0;
+};
+
+struct DefragmentationMove
+{
+    MemoryAllocation source;
+    MemoryAllocation destination;
+};
+
+/** Sub allocates device memory blocks with buddy allocator, one pool of blocks per memory type and tiling */
+class MemoryAllocator
+{
+public:
+    static constexpr UInt64 DEFAULT_BLOCK_SIZE = 64ULL * 1024ULL * 1024ULL;
+    static constexpr UInt64 MIN_BLOCK_SIZE = 1024ULL * 1024ULL;
+    static constexpr UInt64 MIN_ALLOCATION_SIZE = 256;
+
+private:
+    struct MemoryBlock
+    {
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        UInt64 size = 0;
+        Void* mappedData = nullptr;
+        UInt8 maxOrder = 0;
+        // Free offsets per order, order n is MIN_ALLOCATION_SIZE << n bytes
+        DynamicArray<DynamicArray<UInt64>> freeLists;
+        HashMap<UInt64, UInt8> freeOrders;
+        HashMap<UInt64, MemoryAllocation> allocations;
+        UInt64 usedBytes = 0;
+        // Blocks emptied by defragmentation do not take new allocations
+        Bool isEvacuated = false;
+    };
+
+    VkPhysicalDeviceMemoryProperties memoryProperties;
+    // Block size per memory heap, power of two
+    DynamicArray<UInt64> blockSizes;
+    // Indexed with memory type * tiling count + tiling
+    DynamicArray<DynamicArray<MemoryBlock>> pools;
+    MemoryStatistics statistics;
+    UInt32 maxAllocationsCount = 0;
+    std::mutex mutex;
+
+public:
+    Void create(const PhysicalDevice& physicalDevice);
+
+    // Memory is bound to resource, returns false when allocation failed
+    Bool allocate_buffer_memory(const LogicalDevice& logicalDevice,
+                                VkBuffer buffer,
+                                VkMemoryPropertyFlags properties,
+                                MemoryAllocation& allocation,
+                                const VkAllocationCallbacks* allocator,
+                                UInt64 userData = 0);
+    Bool allocate_image_memory(const LogicalDevice& logicalDevice,
+                               VkImage image,
+                               VkImageTiling tiling,
+                               VkMemoryPropertyFlags properties,
+                               MemoryAllocation& allocation,
+                               const VkAllocationCallbacks* allocator);
+    Void free(const LogicalDevice& logicalDevice,
+              const MemoryAllocation& allocation,
+              const VkAllocationCallbacks* allocator);
+
+    // Chooses least used blocks and places their allocations in other blocks of the same pool.
+    // Caller copies resources to destinations, binds them and calls end_defragmentation
+    DynamicArray<DefragmentationMove> begin_defragmentation(UInt64 maxBytesToMove);
+    // Frees sources of moves and releases emptied blocks
+    Void end_defragmentation(const LogicalDevice& logicalDevice,
+                             const DynamicArray<DefragmentationMove>& moves,
+                             const VkAllocationCallbacks* allocator);
+
+    [[nodiscard]]
+    MemoryStatistics get_statistics();
+
+    Void clear(const LogicalDevice& logicalDevice, const VkAllocationCallbacks* allocator);
+
+private:
+    Bool allocate(const LogicalDevice& logicalDevice,
+                  const VkMemoryRequirements& requirements,
+                  VkMemoryPropertyFlags properties,
+                  EResourceTiling tiling,
+                  const VkMemoryDedicatedAllocateInfo* dedicatedInfo,
+                  MemoryAllocation& allocation,
+                  const VkAllocationCallbacks* allocator);
+    Bool allocate_dedicated(const LogicalDevice& logicalDevice,
+                            const VkMemoryRequirements& requirements,
+                            UInt32 memoryType,
+                            const VkMemoryDedicatedAllocateInfo* dedicatedInfo,
+                            MemoryAllocation& allocation,
+                            const VkAllocationCallbacks* allocator);
+    // Tries existing blocks only, returns false when none of them has free space of given order
+    Bool allocate_from_blocks(DynamicArray<MemoryBlock>& pool, UInt8 order, MemoryAllocation& allocation);
+    Bool create_block(const LogicalDevice& logicalDevice,
+                      DynamicArray<MemoryBlock>& pool,
+                      UInt32 memoryType,
+                      const VkAllocationCallbacks* allocator);
+    Void free_from_block(MemoryBlock& block, const MemoryAllocation& allocation);
+    Void release_block(const LogicalDevice& logicalDevice, MemoryBlock& block, const VkAllocationCallbacks* allocator);
+
+    [[nodiscard]]
+    UInt32 find_memory_type(UInt32 typeFilter, VkMemoryPropertyFlags properties) const;
+    [[nodiscard]]
+    DynamicArray<MemoryBlock>& get_pool(UInt32 memoryType, EResourceTiling tiling);
+
+    static Bool s_allocate_in_block(MemoryBlock& block, UInt8 order, UInt64& offset);
+    static Void s_free_in_block(MemoryBlock& block, UInt64 offset, UInt8 order);
+    static UInt8 s_get_order(UInt64 size);
+};
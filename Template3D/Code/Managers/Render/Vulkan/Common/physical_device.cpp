@@ -53,6 +53,16 @@ UInt32 PhysicalDevice::get_present_family_index() const
     return presentFamily.value();
 }
 
+UInt32 PhysicalDevice::get_transfer_family_index() const
+{
+    return transferFamily.value();
+}
+
+Bool PhysicalDevice::has_dedicated_transfer_family() const
+{
+    return transferFamily.value() != graphicsFamily.value();
+}
+
 VkSampleCountFlagBits PhysicalDevice::get_max_samples() const
 {
     return maxSamples;
@@ -188,26 +198,42 @@ Void PhysicalDevice::find_queue_families(VkSurfaceKHR surface)
     DynamicArray<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
     vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, queueFamilies.data());
 
+    graphicsFamily.reset();
+    computeFamily.reset();
+    presentFamily.reset();
+    transferFamily.reset();
     for (UInt32 i = 0; i < UInt32(queueFamilies.size()); ++i)
     {
-        if (queueFamilies[i].queueFlags & VK_QUEUE_GRAPHICS_BIT &&
-            queueFamilies[i].queueFlags & VK_QUEUE_COMPUTE_BIT)
+        const VkQueueFlags flags = queueFamilies[i].queueFlags;
+        if (!graphicsFamily.has_value() &&
+            flags & VK_QUEUE_GRAPHICS_BIT &&
+            flags & VK_QUEUE_COMPUTE_BIT)
         {
             graphicsFamily = i;
             computeFamily = i;
         }
 
+        // Transfer only family is usually backed by DMA engine, which copies without stalling graphics work
+        if (!transferFamily.has_value() &&
+            flags & VK_QUEUE_TRANSFER_BIT &&
+            !(flags & VK_QUEUE_GRAPHICS_BIT) &&
+            !(flags & VK_QUEUE_COMPUTE_BIT))
+        {
+            transferFamily = i;
+        }
+
         VkBool32 presentSupport = false;
         vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &presentSupport);
-        if (presentSupport)
+        // Presenting from graphics family avoids sharing swapchain images between families
+        if (presentSupport && (!presentFamily.has_value() || graphicsFamily == i))
         {
             presentFamily = i;
         }
+    }
 
-        if (are_families_valid())
-        {
-            break;
-        }
+    if (!transferFamily.has_value())
+    {
+        transferFamily = graphicsFamily;
     }
 }
 
@@ -10,6 +10,8 @@ private:
     Optional<UInt32> computeFamily;
     Optional<UInt32> graphicsFamily;
     Optional<UInt32> presentFamily;
+    // Falls back to graphics family when device has no transfer only family
+    Optional<UInt32> transferFamily;
     const DynamicArray<const Char*> deviceExtensions =
     {
         VK_KHR_SWAPCHAIN_EXTENSION_NAME,
@@ -29,6 +31,10 @@ public:
     [[nodiscard]]
     UInt32 get_present_family_index() const;
     [[nodiscard]]
+    UInt32 get_transfer_family_index() const;
+    [[nodiscard]]
+    Bool has_dedicated_transfer_family() const;
+    [[nodiscard]]
     VkSampleCountFlagBits get_max_samples() const;
     [[nodiscard]]
     VkSurfaceCapabilitiesKHR get_capabilities(VkSurfaceKHR surface) const;
@@ -0,0 +1,140 @@
+#include "pipeline_cache.hpp"
+
+#include "physical_device.hpp"
+#include "logical_device.hpp"
+
+#include <magic_enum.hpp>
+#include <filesystem>
+#include <fstream>
+
+
+Void PipelineCache::create(const PhysicalDevice& physicalDevice, const LogicalDevice& logicalDevice, const String& filePath, const VkAllocationCallbacks* allocator)
+{
+    DynamicArray<UInt8> data;
+    std::ifstream file(filePath, std::ios::ate | std::ios::binary);
+    if (file.is_open())
+    {
+        data.resize(UInt64(file.tellg()));
+        file.seekg(0);
+        file.read(reinterpret_cast<Char*>(data.data()), Int64(data.size()));
+        file.close();
+
+        if (!s_is_header_valid(physicalDevice, data))
+        {
+            SPDLOG_INFO("Pipeline cache {} was created for other device or driver, it is ignored.", filePath);
+            data.clear();
+        }
+    }
+
+    VkPipelineCacheCreateInfo createInfo{};
+    createInfo.sType           = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    createInfo.initialDataSize = data.size();
+    createInfo.pInitialData    = data.empty() ? nullptr : data.data();
+
+    VkResult result = vkCreatePipelineCache(logicalDevice.get_device(), &createInfo, allocator, &cache);
+    if (result != VK_SUCCESS && !data.empty())
+    {
+        // Driver could still reject data, empty cache is better than none
+        SPDLOG_WARN("Pipeline cache data rejected with: {}", magic_enum::enum_name(result));
+        data.clear();
+        createInfo.initialDataSize = 0;
+        createInfo.pInitialData    = nullptr;
+        result = vkCreatePipelineCache(logicalDevice.get_device(), &createInfo, allocator, &cache);
+    }
+    if (result != VK_SUCCESS)
+    {
+        SPDLOG_ERROR("Creating pipeline cache failed with: {}", magic_enum::enum_name(result));
+        cache = VK_NULL_HANDLE;
+        return;
+    }
+
+    loadedBytes         = data.size();
+    pipelinesCount      = 0;
+    creationNanoseconds = 0;
+}
+
+Bool PipelineCache::save(const LogicalDevice& logicalDevice, const String& filePath) const
+{
+    if (cache == VK_NULL_HANDLE)
+    {
+        return false;
+    }
+
+    UInt64 size = 0;
+    VkResult result = vkGetPipelineCacheData(logicalDevice.get_device(), cache, &size, nullptr);
+    if (result != VK_SUCCESS || size == 0)
+    {
+        SPDLOG_ERROR("Getting pipeline cache size failed with: {}", magic_enum::enum_name(result));
+        return false;
+    }
+
+    DynamicArray<UInt8> data(size);
+    result = vkGetPipelineCacheData(logicalDevice.get_device(), cache, &size, data.data());
+    if (result != VK_SUCCESS)
+    {
+        SPDLOG_ERROR("Getting pipeline cache data failed with: {}", magic_enum::enum_name(result));
+        return false;
+    }
+
+    const std::filesystem::path path(filePath);
+    if (path.has_parent_path())
+    {
+        std::error_code error;
+        std::filesystem::create_directories(path.parent_path(), error);
+    }
+
+    std::ofstream file(filePath, std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+    {
+        SPDLOG_ERROR("Failed to open pipeline cache {} for writing.", filePath);
+        return false;
+    }
+    file.write(reinterpret_cast<const Char*>(data.data()), Int64(size));
+    file.close();
+
+    SPDLOG_INFO("Pipeline cache saved with {} bytes.", size);
+    return true;
+}
+
+Void PipelineCache::record_creation(UInt64 nanoseconds)
+{
+    pipelinesCount++;
+    creationNanoseconds += nanoseconds;
+}
+
+VkPipelineCache PipelineCache::get_cache() const
+{
+    return cache;
+}
+
+PipelineCacheStatistics PipelineCache::get_statistics() const
+{
+    PipelineCacheStatistics statistics;
+    statistics.loadedBytes          = loadedBytes;
+    statistics.pipelinesCount       = pipelinesCount;
+    statistics.creationMilliseconds = Float64(creationNanoseconds) / 1'000'000.0;
+    return statistics;
+}
+
+Void PipelineCache::clear(const LogicalDevice& logicalDevice, const VkAllocationCallbacks* allocator)
+{
+    vkDestroyPipelineCache(logicalDevice.get_device(), cache, allocator);
+    cache = VK_NULL_HANDLE;
+}
+
+Bool PipelineCache::s_is_header_valid(const PhysicalDevice& physicalDevice, const DynamicArray<UInt8>& data)
+{
+    VkPipelineCacheHeaderVersionOne header{};
+    if (data.size() < sizeof(header))
+    {
+        return false;
+    }
+    memcpy(&header, data.data(), sizeof(header));
+
+    const VkPhysicalDeviceProperties& properties = physicalDevice.get_properties();
+    return header.headerSize >= sizeof(header)
+        && header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+        && header.vendorID == properties.vendorID
+        && header.deviceID == properties.deviceID
+        && memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
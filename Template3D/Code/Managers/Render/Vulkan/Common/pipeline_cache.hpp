@@ -0,0 +1,45 @@
+#pragma once
+#include <vulkan/vulkan.hpp>
+#include <atomic>
+
+class PhysicalDevice;
+class LogicalDevice;
+
+struct PipelineCacheStatistics
+{
+    // Size of data accepted from disk, 0 when cache started empty
+    UInt64 loadedBytes           = 0;
+    UInt64 pipelinesCount        = 0;
+    Float64 creationMilliseconds = 0.0;
+};
+
+/** Pipeline cache shared by all pipelines, its data is kept on disk between runs */
+class PipelineCache
+{
+private:
+    VkPipelineCache cache = VK_NULL_HANDLE;
+    UInt64 loadedBytes = 0;
+    // Pipelines could be created on many threads
+    std::atomic<UInt64> pipelinesCount = 0;
+    std::atomic<UInt64> creationNanoseconds = 0;
+
+public:
+    // Data from file is used only when its header matches device, otherwise cache starts empty
+    Void create(const PhysicalDevice& physicalDevice,
+                const LogicalDevice& logicalDevice,
+                const String& filePath,
+                const VkAllocationCallbacks* allocator);
+    Bool save(const LogicalDevice& logicalDevice, const String& filePath) const;
+
+    Void record_creation(UInt64 nanoseconds);
+
+    [[nodiscard]]
+    VkPipelineCache get_cache() const;
+    [[nodiscard]]
+    PipelineCacheStatistics get_statistics() const;
+
+    Void clear(const LogicalDevice& logicalDevice, const VkAllocationCallbacks* allocator);
+
+private:
+    static Bool s_is_header_valid(const PhysicalDevice& physicalDevice, const DynamicArray<UInt8>& data);
+};
@@ -1,23 +1,31 @@
 #include "pipeline_vk.hpp"
 
 #include "logical_device.hpp"
+#include "pipeline_cache.hpp"
 #include "descriptor_pool.hpp"
 #include "render_pass.hpp"
 #include "shader_vk.hpp"
+#include "image_vk.hpp"
 #include "Resource/Common/vertex.hpp"
 
 #include <magic_enum.hpp>
+#include <chrono>
 
 
-Void PipelineVK::create_graphics_pipeline(const DescriptorPool& descriptorPool, const RenderPass& renderPass, const DynamicArray<ShaderVK>& ShaderVKs, const LogicalDevice& logicalDevice, const VkAllocationCallbacks* allocator)
+Void PipelineVK::create_graphics_pipeline(const DescriptorPool& descriptorPool, const RenderPass& renderPass, const DynamicArray<ShaderVK>& ShaderVKs, const LogicalDevice& logicalDevice, PipelineCache& pipelineCache, const VkAllocationCallbacks* allocator)
 {
     create_layout(descriptorPool.get_layouts(), descriptorPool.get_push_constants(), logicalDevice, allocator);
 
     DynamicArray<VkPipelineShaderStageCreateInfo> ShaderVKStageInfos;
     ShaderVKStageInfos.reserve(ShaderVKs.size());
+    // Stage infos point to these, so array can not be reallocated
+    DynamicArray<VkSpecializationInfo> specializationInfos;
+    specializationInfos.reserve(ShaderVKs.size());
     for (const ShaderVK& shader : ShaderVKs)
     {
-        Bool isValid = create_shader_stage_info(shader, ShaderVKStageInfos.emplace_back());
+        Bool isValid = create_shader_stage_info(shader,
+                                                ShaderVKStageInfos.emplace_back(),
+                                                specializationInfos.emplace_back());
 
         if (!isValid)
         {
@@ -27,9 +35,9 @@ Void PipelineVK::create_graphics_pipeline(const DescriptorPool& descriptorPool,
     
     VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
     DynamicArray<VkVertexInputBindingDescription> bindingDescriptions;
-    get_mesh_binding_descriptions(bindingDescriptions);
+    s_get_mesh_binding_descriptions(bindingDescriptions);
     DynamicArray<VkVertexInputAttributeDescription> attributeDescriptions;
-    get_mesh_attribute_descriptions(attributeDescriptions);
+    s_get_mesh_attribute_descriptions(attributeDescriptions);
     vertexInputInfo.sType                           = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
     vertexInputInfo.vertexBindingDescriptionCount   = UInt32(bindingDescriptions.size());
     vertexInputInfo.pVertexBindingDescriptions      = bindingDescriptions.data();
@@ -138,12 +146,16 @@ Void PipelineVK::create_graphics_pipeline(const DescriptorPool& descriptorPool,
     pipelineInfo.basePipelineHandle  = VK_NULL_HANDLE; // Optional
     pipelineInfo.basePipelineIndex   = -1; // Optional
 
+    const auto begin = std::chrono::steady_clock::now();
     VkResult result = vkCreateGraphicsPipelines(logicalDevice.get_device(),
-                                                cache,
+                                                pipelineCache.get_cache(),
                                                 1, 
                                                 &pipelineInfo, 
                                                 allocator, 
                                                 &pipeline);
+    const auto end = std::chrono::steady_clock::now();
+    creationNanoseconds = UInt64(std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count());
+    pipelineCache.record_creation(creationNanoseconds);
 
     if (result != VK_SUCCESS)
     {
@@ -154,12 +166,13 @@ Void PipelineVK::create_graphics_pipeline(const DescriptorPool& descriptorPool,
     bindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
 }
 
-Void PipelineVK::create_compute_pipeline(const DescriptorPool& descriptorPool, const ShaderVK& shader, const LogicalDevice& logicalDevice, const VkAllocationCallbacks* allocator)
+Void PipelineVK::create_compute_pipeline(const DescriptorPool& descriptorPool, const ShaderVK& shader, const LogicalDevice& logicalDevice, PipelineCache& pipelineCache, const VkAllocationCallbacks* allocator)
 {
     create_layout(descriptorPool.get_layouts(), descriptorPool.get_push_constants(), logicalDevice, allocator);
 
     VkPipelineShaderStageCreateInfo ShaderVKStageInfo{};
-    const Bool isValid = create_shader_stage_info(shader, ShaderVKStageInfo);
+    VkSpecializationInfo specializationInfo{};
+    const Bool isValid = create_shader_stage_info(shader, ShaderVKStageInfo, specializationInfo);
 
     if (!isValid)
     {
@@ -173,12 +186,16 @@ Void PipelineVK::create_compute_pipeline(const DescriptorPool& descriptorPool, c
     pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
     pipelineInfo.basePipelineIndex  = -1;
 
+    const auto begin = std::chrono::steady_clock::now();
     const VkResult result = vkCreateComputePipelines(logicalDevice.get_device(),
-                                                     cache,
+                                                     pipelineCache.get_cache(),
                                                      1,
                                                      &pipelineInfo,
                                                      allocator,
                                                      &pipeline);
+    const auto end = std::chrono::steady_clock::now();
+    creationNanoseconds = UInt64(std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count());
+    pipelineCache.record_creation(creationNanoseconds);
 
     if (result != VK_SUCCESS)
     {
@@ -189,16 +206,16 @@ Void PipelineVK::create_compute_pipeline(const DescriptorPool& descriptorPool, c
     bindPoint = VK_PIPELINE_BIND_POINT_COMPUTE;
 }
 
-Void PipelineVK::recreate_pipeline(const DescriptorPool& descriptorPool, const RenderPass& renderPass, const DynamicArray<ShaderVK>& shaders, const LogicalDevice& logicalDevice, const VkAllocationCallbacks* allocator)
+Void PipelineVK::recreate_pipeline(const DescriptorPool& descriptorPool, const RenderPass& renderPass, const DynamicArray<ShaderVK>& shaders, const LogicalDevice& logicalDevice, PipelineCache& pipelineCache, const VkAllocationCallbacks* allocator)
 {
     clear(logicalDevice, allocator);
     if (type == EPipelineType::Graphics)
     {
-        create_graphics_pipeline(descriptorPool, renderPass, shaders, logicalDevice, allocator);
+        create_graphics_pipeline(descriptorPool, renderPass, shaders, logicalDevice, pipelineCache, allocator);
     }
     else if (type == EPipelineType::Compute)
     {
-        create_compute_pipeline(descriptorPool, shaders[0], logicalDevice, allocator);
+        create_compute_pipeline(descriptorPool, shaders[0], logicalDevice, pipelineCache, allocator);
     }
 }
 
@@ -207,14 +224,19 @@ EPipelineType PipelineVK::get_type() const
     return type;
 }
 
-VkPipeline PipelineVK::get_pipeline() const
+Bool PipelineVK::is_ready() const
 {
-    return pipeline;
+    return pipeline != VK_NULL_HANDLE;
+}
+
+UInt64 PipelineVK::get_creation_nanoseconds() const
+{
+    return creationNanoseconds;
 }
 
-VkPipelineCache PipelineVK::get_cache() const
+VkPipeline PipelineVK::get_pipeline() const
 {
-    return cache;
+    return pipeline;
 }
 
 VkPipelineLayout PipelineVK::get_layout() const
@@ -242,7 +264,7 @@ Void PipelineVK::create_layout(const DynamicArray<VkDescriptorSetLayout>& descri
     }
 }
 
-Bool PipelineVK::create_shader_stage_info(const ShaderVK& ShaderVK, VkPipelineShaderStageCreateInfo& info)
+Bool PipelineVK::create_shader_stage_info(const ShaderVK& ShaderVK, VkPipelineShaderStageCreateInfo& info, VkSpecializationInfo& specializationInfo)
 {
     info.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
     switch (ShaderVK.get_type())
@@ -276,10 +298,13 @@ Bool PipelineVK::create_shader_stage_info(const ShaderVK& ShaderVK, VkPipelineSh
     }
     info.module = ShaderVK.get_module();
     info.pName  = ShaderVK.get_function_name().c_str();
+
+    specializationInfo = ShaderVK.get_specialization_info();
+    info.pSpecializationInfo = specializationInfo.mapEntryCount > 0 ? &specializationInfo : nullptr;
     return true;
 }
 
-Void PipelineVK::get_mesh_binding_descriptions(DynamicArray<VkVertexInputBindingDescription>& descriptions)
+Void PipelineVK::s_get_mesh_binding_descriptions(DynamicArray<VkVertexInputBindingDescription>& descriptions)
 {
     VkVertexInputBindingDescription& positionsBinding = descriptions.emplace_back();
     positionsBinding.binding = 0;
@@ -287,7 +312,7 @@ Void PipelineVK::get_mesh_binding_descriptions(DynamicArray<VkVertexInputBinding
     positionsBinding.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
 }
 
-Void PipelineVK::get_mesh_attribute_descriptions(DynamicArray<VkVertexInputAttributeDescription>& descriptions)
+Void PipelineVK::s_get_mesh_attribute_descriptions(DynamicArray<VkVertexInputAttributeDescription>& descriptions)
 {
     VkVertexInputAttributeDescription& positionsAttribute = descriptions.emplace_back();
     positionsAttribute.binding = 0;
@@ -312,4 +337,56 @@ Void PipelineVK::clear(const LogicalDevice& logicalDevice, const VkAllocationCal
 {
     vkDestroyPipeline(logicalDevice.get_device(), pipeline, allocator);
     vkDestroyPipelineLayout(logicalDevice.get_device(), layout, allocator);
+}
+
+Void PipelineVK::s_describe_layout_state(const DescriptorPool& descriptorPool, DynamicArray<UInt64>& state)
+{
+    // Layouts come from shared cache, so equal layouts have equal handles
+    const DynamicArray<VkDescriptorSetLayout> layouts = descriptorPool.get_layouts();
+    state.push_back(layouts.size());
+    for (const VkDescriptorSetLayout setLayout : layouts)
+    {
+        state.push_back(UInt64(setLayout));
+    }
+
+    const DynamicArray<VkPushConstantRange>& pushConstants = descriptorPool.get_push_constants();
+    state.push_back(pushConstants.size());
+    for (const VkPushConstantRange& range : pushConstants)
+    {
+        state.push_back(range.stageFlags);
+        state.push_back(range.offset);
+        state.push_back(range.size);
+    }
+}
+
+Void PipelineVK::s_describe_graphics_state(const DescriptorPool& descriptorPool, const RenderPass& renderPass, DynamicArray<UInt64>& state)
+{
+    s_describe_layout_state(descriptorPool, state);
+
+    DynamicArray<VkVertexInputBindingDescription> bindingDescriptions;
+    s_get_mesh_binding_descriptions(bindingDescriptions);
+    for (const VkVertexInputBindingDescription& description : bindingDescriptions)
+    {
+        state.push_back(description.binding);
+        state.push_back(description.stride);
+        state.push_back(description.inputRate);
+    }
+    DynamicArray<VkVertexInputAttributeDescription> attributeDescriptions;
+    s_get_mesh_attribute_descriptions(attributeDescriptions);
+    for (const VkVertexInputAttributeDescription& description : attributeDescriptions)
+    {
+        state.push_back(description.location);
+        state.push_back(description.binding);
+        state.push_back(description.format);
+        state.push_back(description.offset);
+    }
+
+    // Pipeline can be used with every render pass compatible with the one it was created for
+    state.push_back(renderPass.get_samples());
+    state.push_back(renderPass.is_depth_test_enabled());
+    state.push_back(renderPass.is_multi_sampling_enabled());
+    for (const ImageVK& image : renderPass.get_images())
+    {
+        state.push_back(image.get_format());
+    }
 }
\ No newline at end of file
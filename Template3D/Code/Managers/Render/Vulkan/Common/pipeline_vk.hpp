@@ -7,15 +7,16 @@ class DescriptorPool;
 class RenderPass;
 class ShaderVK;
 class LogicalDevice;
+class PipelineCache;
 
 class PipelineVK
 {
 private:
-    VkPipelineLayout layout;
-    VkPipelineCache cache;
-    VkPipeline pipeline;
+    VkPipelineLayout layout = VK_NULL_HANDLE;
+    VkPipeline pipeline = VK_NULL_HANDLE;
     VkPipelineBindPoint bindPoint;
-    EPipelineType type;
+    EPipelineType type = EPipelineType::None;
+    UInt64 creationNanoseconds = 0;
     Array<VkDynamicState, 2> dynamicStates =
     {
         VK_DYNAMIC_STATE_VIEWPORT,
@@ -27,17 +28,20 @@ public:
                                   const RenderPass& renderPass,
                                   const DynamicArray<ShaderVK>& shaders,
                                   const LogicalDevice& logicalDevice,
+                                  PipelineCache& pipelineCache,
                                   const VkAllocationCallbacks* allocator);
 
     Void create_compute_pipeline(const DescriptorPool& descriptorPool, 
                                  const ShaderVK& shader,
                                  const LogicalDevice& logicalDevice,
+                                 PipelineCache& pipelineCache,
                                  const VkAllocationCallbacks* allocator);
 
     Void recreate_pipeline(const DescriptorPool& descriptorPool,
                            const RenderPass& renderPass,
                            const DynamicArray<ShaderVK>& shaders,
                            const LogicalDevice& logicalDevice,
+                           PipelineCache& pipelineCache,
                            const VkAllocationCallbacks* allocator);
 
     [[nodiscard]]
@@ -45,21 +49,35 @@ public:
     [[nodiscard]]
     VkPipeline get_pipeline() const;
     [[nodiscard]]
-    VkPipelineCache get_cache() const;
-    [[nodiscard]]
     VkPipelineLayout get_layout() const;
     [[nodiscard]]
     VkPipelineBindPoint get_bind_point() const;
+    // False until creation on worker thread is finished or when creation failed
+    [[nodiscard]]
+    Bool is_ready() const;
+    // Time of last vkCreate*Pipelines call only, layout creation is not counted
+    [[nodiscard]]
+    UInt64 get_creation_nanoseconds() const;
 
     Void clear(const LogicalDevice& logicalDevice, const VkAllocationCallbacks* allocator);
 
+    // Appends set layouts and push constants, pipelines with equal description have compatible layouts
+    static Void s_describe_layout_state(const DescriptorPool& descriptorPool, DynamicArray<UInt64>& state);
+    // Appends everything besides shaders that create_graphics_pipeline reads: layouts, push constants,
+    // vertex format and render pass compatibility, fixed function state follows from these
+    static Void s_describe_graphics_state(const DescriptorPool& descriptorPool,
+                                          const RenderPass& renderPass,
+                                          DynamicArray<UInt64>& state);
+
 private:
-    Void get_mesh_binding_descriptions(DynamicArray<VkVertexInputBindingDescription>& descriptions);
-    Void get_mesh_attribute_descriptions(DynamicArray<VkVertexInputAttributeDescription>& descriptions);
+    static Void s_get_mesh_binding_descriptions(DynamicArray<VkVertexInputBindingDescription>& descriptions);
+    static Void s_get_mesh_attribute_descriptions(DynamicArray<VkVertexInputAttributeDescription>& descriptions);
     
     Void create_layout(const DynamicArray<VkDescriptorSetLayout>& descriptorSetLayouts,
                        const DynamicArray<VkPushConstantRange>& pushConstants,
                        const LogicalDevice& logicalDevice,
                        const VkAllocationCallbacks* allocator);
-    Bool create_shader_stage_info(const ShaderVK& shader, VkPipelineShaderStageCreateInfo& info);
+    Bool create_shader_stage_info(const ShaderVK& shader,
+                                  VkPipelineShaderStageCreateInfo& info,
+                                  VkSpecializationInfo& specializationInfo);
 };
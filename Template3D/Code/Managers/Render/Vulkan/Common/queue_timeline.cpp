@@ -0,0 +1,181 @@
+#include "queue_timeline.hpp"
+
+#include "logical_device.hpp"
+
+#include <magic_enum.hpp>
+
+
+Void QueueTimeline::create(const LogicalDevice& logicalDevice, const VkAllocationCallbacks* allocator)
+{
+    VkSemaphoreTypeCreateInfo typeInfo{};
+    typeInfo.sType         = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+    typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+    typeInfo.initialValue  = 0;
+
+    VkSemaphoreCreateInfo info{};
+    info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    info.pNext = &typeInfo;
+
+    for (UInt64 i = 0; i < UInt64(EQueueType::Count); ++i)
+    {
+        const VkResult result = vkCreateSemaphore(logicalDevice.get_device(), &info, allocator, &semaphores[i]);
+        if (result != VK_SUCCESS)
+        {
+            SPDLOG_ERROR("Timeline semaphore of {} queue creation failed with: {}",
+                         magic_enum::enum_name(EQueueType(i)),
+                         magic_enum::enum_name(result));
+        }
+        submittedValues[i] = 0;
+        completedValues[i] = 0;
+    }
+}
+
+UInt64 QueueTimeline::submit(const LogicalDevice& logicalDevice, EQueueType queue, const DynamicArray<VkCommandBuffer>& commandBuffers, const DynamicArray<TimelineWait>& waits, VkSemaphore binaryWaitSemaphore, VkPipelineStageFlags binaryWaitStage, VkSemaphore binarySignalSemaphore)
+{
+    DynamicArray<VkSemaphore> waitSemaphores;
+    DynamicArray<VkPipelineStageFlags> waitStages;
+    DynamicArray<UInt64> waitValues;
+    waitSemaphores.reserve(waits.size() + 1);
+    waitStages.reserve(waits.size() + 1);
+    waitValues.reserve(waits.size() + 1);
+    for (const TimelineWait& wait : waits)
+    {
+        // Finished values do not have to be waited by device
+        if (wait.value <= completedValues[UInt64(wait.queue)])
+        {
+            continue;
+        }
+        waitSemaphores.push_back(semaphores[UInt64(wait.queue)]);
+        waitStages.push_back(wait.stage);
+        waitValues.push_back(wait.value);
+    }
+    if (binaryWaitSemaphore != VK_NULL_HANDLE)
+    {
+        // Value of binary semaphore is ignored
+        waitSemaphores.push_back(binaryWaitSemaphore);
+        waitStages.push_back(binaryWaitStage);
+        waitValues.push_back(0);
+    }
+
+    const UInt64 value = ++submittedValues[UInt64(queue)];
+    DynamicArray<VkSemaphore> signalSemaphores = { semaphores[UInt64(queue)] };
+    DynamicArray<UInt64> signalValues = { value };
+    if (binarySignalSemaphore != VK_NULL_HANDLE)
+    {
+        signalSemaphores.push_back(binarySignalSemaphore);
+        signalValues.push_back(0);
+    }
+
+    VkTimelineSemaphoreSubmitInfo timelineInfo{};
+    timelineInfo.sType                     = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+    timelineInfo.waitSemaphoreValueCount   = UInt32(waitValues.size());
+    timelineInfo.pWaitSemaphoreValues      = waitValues.data();
+    timelineInfo.signalSemaphoreValueCount = UInt32(signalValues.size());
+    timelineInfo.pSignalSemaphoreValues    = signalValues.data();
+
+    VkSubmitInfo info{};
+    info.sType                = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    info.pNext                = &timelineInfo;
+    info.waitSemaphoreCount   = UInt32(waitSemaphores.size());
+    info.pWaitSemaphores      = waitSemaphores.data();
+    info.pWaitDstStageMask    = waitStages.data();
+    info.commandBufferCount   = UInt32(commandBuffers.size());
+    info.pCommandBuffers      = commandBuffers.data();
+    info.signalSemaphoreCount = UInt32(signalSemaphores.size());
+    info.pSignalSemaphores    = signalSemaphores.data();
+
+    switch (queue)
+    {
+    case EQueueType::Graphics:
+    {
+        logicalDevice.submit_graphics_queue({ info }, VK_NULL_HANDLE);
+        break;
+    }
+    case EQueueType::Compute:
+    {
+        logicalDevice.submit_compute_queue({ info }, VK_NULL_HANDLE);
+        break;
+    }
+    case EQueueType::Transfer:
+    {
+        logicalDevice.submit_transfer_queue({ info }, VK_NULL_HANDLE);
+        break;
+    }
+    default:
+    {
+        SPDLOG_ERROR("Not supported queue: {}", magic_enum::enum_name(queue));
+        break;
+    }
+    }
+
+    return value;
+}
+
+VkResult QueueTimeline::wait(const LogicalDevice& logicalDevice, EQueueType queue, UInt64 value, UInt64 timeout)
+{
+    if (value <= completedValues[UInt64(queue)])
+    {
+        return VK_SUCCESS;
+    }
+
+    VkSemaphoreWaitInfo waitInfo{};
+    waitInfo.sType          = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+    waitInfo.semaphoreCount = 1;
+    waitInfo.pSemaphores    = &semaphores[UInt64(queue)];
+    waitInfo.pValues        = &value;
+
+    const VkResult result = vkWaitSemaphores(logicalDevice.get_device(), &waitInfo, timeout);
+    if (result == VK_SUCCESS)
+    {
+        completedValues[UInt64(queue)] = value;
+    }
+    return result;
+}
+
+VkResult QueueTimeline::wait_submitted(const LogicalDevice& logicalDevice, UInt64 timeout)
+{
+    VkSemaphoreWaitInfo waitInfo{};
+    waitInfo.sType          = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+    waitInfo.semaphoreCount = UInt32(semaphores.size());
+    waitInfo.pSemaphores    = semaphores.data();
+    waitInfo.pValues        = submittedValues.data();
+
+    const VkResult result = vkWaitSemaphores(logicalDevice.get_device(), &waitInfo, timeout);
+    if (result == VK_SUCCESS)
+    {
+        completedValues = submittedValues;
+    }
+    return result;
+}
+
+Bool QueueTimeline::is_completed(const LogicalDevice& logicalDevice, EQueueType queue, UInt64 value)
+{
+    if (value <= completedValues[UInt64(queue)])
+    {
+        return true;
+    }
+
+    UInt64 counter = 0;
+    vkGetSemaphoreCounterValue(logicalDevice.get_device(), semaphores[UInt64(queue)], &counter);
+    completedValues[UInt64(queue)] = counter;
+    return value <= counter;
+}
+
+UInt64 QueueTimeline::get_submitted_value(EQueueType queue) const
+{
+    return submittedValues[UInt64(queue)];
+}
+
+VkSemaphore QueueTimeline::get_semaphore(EQueueType queue) const
+{
+    return semaphores[UInt64(queue)];
+}
+
+Void QueueTimeline::clear(const LogicalDevice& logicalDevice, const VkAllocationCallbacks* allocator)
+{
+    for (VkSemaphore& semaphore : semaphores)
+    {
+        vkDestroySemaphore(logicalDevice.get_device(), semaphore, allocator);
+        semaphore = VK_NULL_HANDLE;
+    }
+}
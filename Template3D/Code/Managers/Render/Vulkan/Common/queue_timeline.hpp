@@ -0,0 +1,59 @@
+#pragma once
+#include <vulkan/vulkan.hpp>
+
+class LogicalDevice;
+
+enum class EQueueType : UInt8
+{
+    Graphics = 0U,
+    Compute,
+    // The same queue as graphics when device has no transfer only family
+    Transfer,
+    Count
+};
+
+// Submit waits until given queue reaches value, stage tells which work of submit is blocked
+struct TimelineWait
+{
+    EQueueType queue;
+    UInt64 value;
+    VkPipelineStageFlags stage;
+};
+
+/** One timeline semaphore per queue, every submit signals next value of its queue */
+class QueueTimeline
+{
+private:
+    Array<VkSemaphore, UInt64(EQueueType::Count)> semaphores;
+    Array<UInt64, UInt64(EQueueType::Count)> submittedValues;
+    // Cached counters, so already finished values do not query device
+    Array<UInt64, UInt64(EQueueType::Count)> completedValues;
+
+public:
+    Void create(const LogicalDevice& logicalDevice, const VkAllocationCallbacks* allocator);
+
+    // Returns value signaled when command buffers finish, binary semaphores are meant for swapchain only
+    UInt64 submit(const LogicalDevice& logicalDevice,
+                  EQueueType queue,
+                  const DynamicArray<VkCommandBuffer>& commandBuffers,
+                  const DynamicArray<TimelineWait>& waits,
+                  VkSemaphore binaryWaitSemaphore = VK_NULL_HANDLE,
+                  VkPipelineStageFlags binaryWaitStage = 0,
+                  VkSemaphore binarySignalSemaphore = VK_NULL_HANDLE);
+
+    VkResult wait(const LogicalDevice& logicalDevice,
+                  EQueueType queue,
+                  UInt64 value,
+                  UInt64 timeout = Limits<UInt64>::max());
+    // Waits for everything submitted so far to all queues, present queue is not included
+    VkResult wait_submitted(const LogicalDevice& logicalDevice, UInt64 timeout = Limits<UInt64>::max());
+    [[nodiscard]]
+    Bool is_completed(const LogicalDevice& logicalDevice, EQueueType queue, UInt64 value);
+
+    [[nodiscard]]
+    UInt64 get_submitted_value(EQueueType queue) const;
+    [[nodiscard]]
+    VkSemaphore get_semaphore(EQueueType queue) const;
+
+    Void clear(const LogicalDevice& logicalDevice, const VkAllocationCallbacks* allocator);
+};
@@ -8,7 +8,7 @@
 #include <magic_enum.hpp>
 
 
-Void RenderPass::create(const PhysicalDevice& physicalDevice, const LogicalDevice& logicalDevice, const Swapchain& swapchain, const VkAllocationCallbacks* allocator, VkSampleCountFlagBits samples, Bool depthTest, VkAttachmentLoadOp loadOperation)
+Void RenderPass::create(const PhysicalDevice& physicalDevice, const LogicalDevice& logicalDevice, MemoryAllocator& memoryAllocator, const Swapchain& swapchain, const VkAllocationCallbacks* allocator, VkSampleCountFlagBits samples, Bool depthTest, VkAttachmentLoadOp loadOperation)
 {
     DynamicArray<VkAttachmentDescription> attachments;
     isDepthTest = depthTest;
@@ -107,7 +107,7 @@ Void RenderPass::create(const PhysicalDevice& physicalDevice, const LogicalDevic
     }
     
     // Creation order of these images must match attachments order
-    create_attachments(physicalDevice, logicalDevice, swapchain, nullptr);
+    create_attachments(physicalDevice, logicalDevice, memoryAllocator, swapchain, nullptr);
     VkRenderPassCreateInfo renderPassInfo{};
     renderPassInfo.sType           = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
     renderPassInfo.attachmentCount = UInt32(attachments.size());
@@ -127,15 +127,15 @@ Void RenderPass::create(const PhysicalDevice& physicalDevice, const LogicalDevic
     create_framebuffers(logicalDevice, swapchain, allocator);
 }
 
-Void RenderPass::create_attachments(const PhysicalDevice& physicalDevice, const LogicalDevice& logicalDevice, const Swapchain& swapchain, const VkAllocationCallbacks* allocator)
+Void RenderPass::create_attachments(const PhysicalDevice& physicalDevice, const LogicalDevice& logicalDevice, MemoryAllocator& memoryAllocator, const Swapchain& swapchain, const VkAllocationCallbacks* allocator)
 {
     if (isMultiSampling)
     {
-        create_color_attachment(physicalDevice, logicalDevice, swapchain, allocator);
+        create_color_attachment(physicalDevice, logicalDevice, memoryAllocator, swapchain, allocator);
     }
     if (isDepthTest)
     {
-        create_depth_attachment(physicalDevice, logicalDevice, swapchain, allocator);
+        create_depth_attachment(physicalDevice, logicalDevice, memoryAllocator, swapchain, allocator);
     }
 }
 
@@ -222,10 +222,11 @@ Void RenderPass::clear_framebuffers(const LogicalDevice& logicalDevice, const Vk
     }
 }
 
-Void RenderPass::create_depth_attachment(const PhysicalDevice& physicalDevice, const LogicalDevice& logicalDevice, const Swapchain& swapchain, const VkAllocationCallbacks* allocator)
+Void RenderPass::create_depth_attachment(const PhysicalDevice& physicalDevice, const LogicalDevice& logicalDevice, MemoryAllocator& memoryAllocator, const Swapchain& swapchain, const VkAllocationCallbacks* allocator)
 {
     images.emplace_back().create(physicalDevice,
                                  logicalDevice,
+                                 memoryAllocator,
                                  swapchain.get_extent(),
                                  1,
                                  samples,
@@ -237,10 +238,11 @@ Void RenderPass::create_depth_attachment(const PhysicalDevice& physicalDevice, c
                                  nullptr);
 }
 
-Void RenderPass::create_color_attachment(const PhysicalDevice& physicalDevice, const LogicalDevice& logicalDevice, const Swapchain& swapchain, const VkAllocationCallbacks* allocator)
+Void RenderPass::create_color_attachment(const PhysicalDevice& physicalDevice, const LogicalDevice& logicalDevice, MemoryAllocator& memoryAllocator, const Swapchain& swapchain, const VkAllocationCallbacks* allocator)
 {
     images.emplace_back().create(physicalDevice,
                                  logicalDevice,
+                                 memoryAllocator,
                                  swapchain.get_extent(),
                                  1,
                                  samples,
@@ -252,18 +254,18 @@ Void RenderPass::create_color_attachment(const PhysicalDevice& physicalDevice, c
                                  allocator);
 }
 
-Void RenderPass::clear_images(const LogicalDevice& logicalDevice, const VkAllocationCallbacks* allocator)
+Void RenderPass::clear_images(const LogicalDevice& logicalDevice, MemoryAllocator& memoryAllocator, const VkAllocationCallbacks* allocator)
 {
     for (ImageVK& image : images)
     {
-        image.clear(logicalDevice, allocator);
+        image.clear(logicalDevice, memoryAllocator, allocator);
     }
     images.clear();
 }
 
-Void RenderPass::clear(const LogicalDevice& logicalDevice, const VkAllocationCallbacks* allocator)
+Void RenderPass::clear(const LogicalDevice& logicalDevice, MemoryAllocator& memoryAllocator, const VkAllocationCallbacks* allocator)
 {
-    clear_images(logicalDevice, allocator);
+    clear_images(logicalDevice, memoryAllocator, allocator);
     clear_framebuffers(logicalDevice, allocator);
 
     vkDestroyRenderPass(logicalDevice.get_device(), renderPass, allocator);
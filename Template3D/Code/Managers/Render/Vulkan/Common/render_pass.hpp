@@ -7,6 +7,7 @@ class ImageVK;
 class PhysicalDevice;
 class LogicalDevice;
 class Swapchain;
+class MemoryAllocator;
 
 class RenderPass
 {
@@ -21,6 +22,7 @@ private:
 public:
     Void create(const PhysicalDevice& physicalDevice,
                 const LogicalDevice& logicalDevice,
+                MemoryAllocator& memoryAllocator,
                 const Swapchain& swapchain,
                 const VkAllocationCallbacks* allocator,
                 VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT,
@@ -29,6 +31,7 @@ public:
 
     Void create_attachments(const PhysicalDevice& physicalDevice,
                             const LogicalDevice& logicalDevice,
+                            MemoryAllocator& memoryAllocator,
                             const Swapchain& swapchain,
                             const VkAllocationCallbacks* allocator);
 
@@ -52,16 +55,22 @@ public:
     VkFramebuffer get_framebuffer(UInt64 number) const;
 
     Void clear_framebuffers(const LogicalDevice& logicalDevice, const VkAllocationCallbacks* allocator);
-    Void clear_images(const LogicalDevice& logicalDevice, const VkAllocationCallbacks* allocator);
-    Void clear(const LogicalDevice& logicalDevice, const VkAllocationCallbacks* allocator);
+    Void clear_images(const LogicalDevice& logicalDevice,
+                      MemoryAllocator& memoryAllocator,
+                      const VkAllocationCallbacks* allocator);
+    Void clear(const LogicalDevice& logicalDevice,
+               MemoryAllocator& memoryAllocator,
+               const VkAllocationCallbacks* allocator);
 
 private:
     Void create_depth_attachment(const PhysicalDevice& physicalDevice,
                                  const LogicalDevice& logicalDevice,
+                                 MemoryAllocator& memoryAllocator,
                                  const Swapchain& swapchain,
                                  const VkAllocationCallbacks* allocator);
     Void create_color_attachment(const PhysicalDevice& physicalDevice,
                                  const LogicalDevice& logicalDevice,
+                                 MemoryAllocator& memoryAllocator,
                                  const Swapchain& swapchain,
                                  const VkAllocationCallbacks* allocator);
 
@@ -0,0 +1,31 @@
+#pragma once
+#include "shader_vk.hpp"
+
+struct ShaderSetVK;
+class DescriptorPool;
+class RenderPass;
+
+// Feature switched by variant key
+struct ShaderKeyword
+{
+    String name;
+    // Defined only in shaders of these types, other stages are shared by all variants
+    DynamicArray<EShaderType> stages;
+};
+
+/** Sources of shader set with feature keywords, every used combination of keywords is compiled to own shader set */
+struct ShaderPermutationsVK
+{
+    Handle<RenderPass> renderPassHandle;
+    // Layouts of pool are reflected from first compiled variant when pool has none, names are given by set number
+    Handle<DescriptorPool> descriptorPoolHandle;
+    DynamicArray<String> layoutNames;
+    VkDescriptorBindingFlags bindingFlags = 0;
+    DynamicArray<ShaderDescription> descriptions;
+    // Bit i of variant key defines keywords[i] in shaders of its stages
+    DynamicArray<ShaderKeyword> keywords;
+    // Variants are created on first request, so unused combinations are never compiled
+    HashMap<UInt64, Handle<ShaderSetVK>> variants;
+    // Variant with every keyword, it is created first and is fallback of later variants until their pipelines are ready
+    Handle<ShaderSetVK> fallbackHandle = Handle<ShaderSetVK>::NONE;
+};
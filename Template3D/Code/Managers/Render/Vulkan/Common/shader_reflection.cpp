@@ -0,0 +1,515 @@
+#include "shader_reflection.hpp"
+
+#include <algorithm>
+
+constexpr UInt32 SPIRV_MAGIC = 0x07230203;
+constexpr UInt32 SPIRV_HEADER_SIZE = 5;
+// Since 1.4 entry points list every global variable they use, not only inputs and outputs
+constexpr UInt32 SPIRV_VERSION_1_4 = 0x00010400;
+
+constexpr UInt32 OP_ENTRY_POINT = 15;
+constexpr UInt32 OP_TYPE_BOOL = 20;
+constexpr UInt32 OP_TYPE_INT = 21;
+constexpr UInt32 OP_TYPE_FLOAT = 22;
+constexpr UInt32 OP_TYPE_VECTOR = 23;
+constexpr UInt32 OP_TYPE_MATRIX = 24;
+constexpr UInt32 OP_TYPE_IMAGE = 25;
+constexpr UInt32 OP_TYPE_SAMPLER = 26;
+constexpr UInt32 OP_TYPE_SAMPLED_IMAGE = 27;
+constexpr UInt32 OP_TYPE_ARRAY = 28;
+constexpr UInt32 OP_TYPE_RUNTIME_ARRAY = 29;
+constexpr UInt32 OP_TYPE_STRUCT = 30;
+constexpr UInt32 OP_TYPE_POINTER = 32;
+constexpr UInt32 OP_CONSTANT = 43;
+constexpr UInt32 OP_SPEC_CONSTANT = 50;
+constexpr UInt32 OP_VARIABLE = 59;
+constexpr UInt32 OP_DECORATE = 71;
+constexpr UInt32 OP_MEMBER_DECORATE = 72;
+constexpr UInt32 OP_TYPE_ACCELERATION_STRUCTURE = 5341;
+
+constexpr UInt32 DECORATION_BLOCK = 2;
+constexpr UInt32 DECORATION_BUFFER_BLOCK = 3;
+constexpr UInt32 DECORATION_ARRAY_STRIDE = 6;
+constexpr UInt32 DECORATION_MATRIX_STRIDE = 7;
+constexpr UInt32 DECORATION_BINDING = 33;
+constexpr UInt32 DECORATION_DESCRIPTOR_SET = 34;
+constexpr UInt32 DECORATION_OFFSET = 35;
+
+constexpr UInt32 STORAGE_CLASS_UNIFORM_CONSTANT = 0;
+constexpr UInt32 STORAGE_CLASS_UNIFORM = 2;
+constexpr UInt32 STORAGE_CLASS_PUSH_CONSTANT = 9;
+constexpr UInt32 STORAGE_CLASS_STORAGE_BUFFER = 12;
+
+constexpr UInt32 DIM_BUFFER = 5;
+constexpr UInt32 DIM_SUBPASS_DATA = 6;
+constexpr UInt32 IMAGE_STORAGE = 2;
+
+
+// Ids are indexes of these arrays, bound of module is their size
+struct ShaderReflection::Module
+{
+    const UInt32* words = nullptr;
+    // Word index of instruction which defines id, zero when id is not a type, constant or variable
+    DynamicArray<UInt32> definitions;
+    DynamicArray<UInt32> bindingNumbers;
+    DynamicArray<UInt32> setNumbers;
+    DynamicArray<UInt32> arrayStrides;
+    DynamicArray<Bool> areBufferBlocks;
+    // Key is struct id << 32 | member index
+    HashMap<UInt64, UInt32> memberOffsets;
+    HashMap<UInt64, UInt32> matrixStrides;
+};
+
+Bool ShaderReflection::create(const DynamicArray<UInt32>& code, VkShaderStageFlags stage)
+{
+    clear();
+    if (code.size() < SPIRV_HEADER_SIZE || code[0] != SPIRV_MAGIC)
+    {
+        SPDLOG_ERROR("Reflected code is not valid SPIR-V.");
+        return false;
+    }
+
+    const UInt32 bound = code[3];
+    const Bool hasFullInterface = code[1] >= SPIRV_VERSION_1_4;
+
+    Module module;
+    module.words = code.data();
+    module.definitions.resize(bound, 0);
+    module.bindingNumbers.resize(bound, Limits<UInt32>::max());
+    module.setNumbers.resize(bound, 0);
+    module.arrayStrides.resize(bound, 0);
+    module.areBufferBlocks.resize(bound, false);
+
+    Set<UInt32> interfaceIds;
+    DynamicArray<UInt32> variables;
+    UInt64 word = SPIRV_HEADER_SIZE;
+    while (word < code.size())
+    {
+        const UInt32* instruction = code.data() + word;
+        const UInt32 wordsCount = instruction[0] >> 16;
+        const UInt32 opcode = instruction[0] & 0xFFFF;
+        if (wordsCount == 0 || word + wordsCount > code.size())
+        {
+            SPDLOG_ERROR("Reflected SPIR-V has broken instruction at word {}.", word);
+            clear();
+            return false;
+        }
+
+        switch (opcode)
+        {
+        case OP_ENTRY_POINT:
+        {
+            // Name is null terminated and padded with zeros, so its last word has zero in highest byte
+            UInt32 operand = 3;
+            while (operand < wordsCount && (instruction[operand] >> 24) != 0)
+            {
+                operand++;
+            }
+            for (operand++; operand < wordsCount; ++operand)
+            {
+                interfaceIds.insert(instruction[operand]);
+            }
+            break;
+        }
+        case OP_DECORATE:
+        {
+            const UInt32 target = instruction[1];
+            if (target >= bound || wordsCount < 3)
+            {
+                break;
+            }
+
+            switch (instruction[2])
+            {
+            case DECORATION_BINDING:
+            {
+                module.bindingNumbers[target] = instruction[3];
+                break;
+            }
+            case DECORATION_DESCRIPTOR_SET:
+            {
+                module.setNumbers[target] = instruction[3];
+                break;
+            }
+            case DECORATION_ARRAY_STRIDE:
+            {
+                module.arrayStrides[target] = instruction[3];
+                break;
+            }
+            case DECORATION_BUFFER_BLOCK:
+            {
+                module.areBufferBlocks[target] = true;
+                break;
+            }
+            case DECORATION_BLOCK:
+            default:
+            {
+                break;
+            }
+            }
+            break;
+        }
+        case OP_MEMBER_DECORATE:
+        {
+            if (wordsCount < 5)
+            {
+                break;
+            }
+
+            const UInt64 key = (UInt64(instruction[1]) << 32) | instruction[2];
+            if (instruction[3] == DECORATION_OFFSET)
+            {
+                module.memberOffsets[key] = instruction[4];
+            }
+            else if (instruction[3] == DECORATION_MATRIX_STRIDE)
+            {
+                module.matrixStrides[key] = instruction[4];
+            }
+            break;
+        }
+        case OP_TYPE_BOOL:
+        case OP_TYPE_INT:
+        case OP_TYPE_FLOAT:
+        case OP_TYPE_VECTOR:
+        case OP_TYPE_MATRIX:
+        case OP_TYPE_IMAGE:
+        case OP_TYPE_SAMPLER:
+        case OP_TYPE_SAMPLED_IMAGE:
+        case OP_TYPE_ARRAY:
+        case OP_TYPE_RUNTIME_ARRAY:
+        case OP_TYPE_STRUCT:
+        case OP_TYPE_POINTER:
+        case OP_TYPE_ACCELERATION_STRUCTURE:
+        {
+            if (instruction[1] < bound)
+            {
+                module.definitions[instruction[1]] = UInt32(word);
+            }
+            break;
+        }
+        case OP_CONSTANT:
+        case OP_SPEC_CONSTANT:
+        case OP_VARIABLE:
+        {
+            if (wordsCount < 4 || instruction[2] >= bound)
+            {
+                break;
+            }
+
+            module.definitions[instruction[2]] = UInt32(word);
+            if (opcode == OP_VARIABLE)
+            {
+                variables.push_back(instruction[2]);
+            }
+            break;
+        }
+        default:
+        {
+            break;
+        }
+        }
+
+        word += wordsCount;
+    }
+
+    for (const UInt32 variable : variables)
+    {
+        if (hasFullInterface && !interfaceIds.contains(variable))
+        {
+            continue;
+        }
+
+        const UInt32* instruction = module.words + module.definitions[variable];
+        const UInt32 storageClass = instruction[3];
+        if (storageClass != STORAGE_CLASS_UNIFORM_CONSTANT
+            && storageClass != STORAGE_CLASS_UNIFORM
+            && storageClass != STORAGE_CLASS_PUSH_CONSTANT
+            && storageClass != STORAGE_CLASS_STORAGE_BUFFER)
+        {
+            continue;
+        }
+
+        const UInt32 pointerId = instruction[1];
+        if (pointerId >= bound || module.definitions[pointerId] == 0)
+        {
+            continue;
+        }
+        const UInt32 typeId = module.words[module.definitions[pointerId] + 3];
+
+        if (storageClass == STORAGE_CLASS_PUSH_CONSTANT)
+        {
+            if (typeId >= bound || module.definitions[typeId] == 0)
+            {
+                continue;
+            }
+
+            // Block could start with offset when other stage owns beginning of range
+            const UInt32* structure = module.words + module.definitions[typeId];
+            const UInt32 membersCount = (structure[0] >> 16) - 2;
+            UInt32 offset = Limits<UInt32>::max();
+            for (UInt32 member = 0; member < membersCount; ++member)
+            {
+                const auto iterator = module.memberOffsets.find((UInt64(typeId) << 32) | member);
+                offset = std::min(offset, iterator == module.memberOffsets.end() ? 0 : iterator->second);
+            }
+            offset = membersCount == 0 ? 0 : offset;
+
+            pushConstants.stageFlags = stage;
+            pushConstants.offset     = offset;
+            pushConstants.size       = s_get_type_size(module, typeId) - offset;
+            continue;
+        }
+
+        if (module.bindingNumbers[variable] == Limits<UInt32>::max())
+        {
+            SPDLOG_WARN("Reflected resource {} has no binding, it is skipped.", variable);
+            continue;
+        }
+
+        ReflectedBinding binding{};
+        binding.setNumber  = module.setNumbers[variable];
+        binding.binding    = module.bindingNumbers[variable];
+        binding.stageFlags = stage;
+        if (!s_get_descriptor_type(module, typeId, storageClass, binding.descriptorType, binding.descriptorCount))
+        {
+            SPDLOG_WARN("Reflected resource in set {} binding {} has not supported type, it is skipped.",
+                        binding.setNumber,
+                        binding.binding);
+            continue;
+        }
+        bindings.push_back(binding);
+    }
+
+    sort_bindings();
+
+    return true;
+}
+
+Bool ShaderReflection::merge(const ShaderReflection& other)
+{
+    for (const ReflectedBinding& otherBinding : other.bindings)
+    {
+        auto iterator = std::find_if(bindings.begin(), bindings.end(), [&otherBinding](const ReflectedBinding& binding)
+        {
+            return binding.setNumber == otherBinding.setNumber && binding.binding == otherBinding.binding;
+        });
+
+        if (iterator == bindings.end())
+        {
+            bindings.push_back(otherBinding);
+            continue;
+        }
+
+        if (iterator->descriptorType != otherBinding.descriptorType
+            || iterator->descriptorCount != otherBinding.descriptorCount)
+        {
+            SPDLOG_ERROR("Binding {} in set {} is declared differently between stages.",
+                         otherBinding.binding,
+                         otherBinding.setNumber);
+            return false;
+        }
+        iterator->stageFlags |= otherBinding.stageFlags;
+    }
+
+    sort_bindings();
+
+    // One range visible to all stages which use any part of it
+    if (other.pushConstants.size > 0)
+    {
+        if (pushConstants.size == 0)
+        {
+            pushConstants = other.pushConstants;
+        } else {
+            const UInt32 end = std::max(pushConstants.offset + pushConstants.size,
+                                        other.pushConstants.offset + other.pushConstants.size);
+            pushConstants.offset      = std::min(pushConstants.offset, other.pushConstants.offset);
+            pushConstants.size        = end - pushConstants.offset;
+            pushConstants.stageFlags |= other.pushConstants.stageFlags;
+        }
+    }
+
+    return true;
+}
+
+const DynamicArray<ReflectedBinding>& ShaderReflection::get_bindings() const
+{
+    return bindings;
+}
+
+const VkPushConstantRange& ShaderReflection::get_push_constants() const
+{
+    return pushConstants;
+}
+
+UInt32 ShaderReflection::get_sets_count() const
+{
+    return bindings.empty() ? 0 : bindings.back().setNumber + 1;
+}
+
+Void ShaderReflection::clear()
+{
+    bindings.clear();
+    pushConstants = {};
+}
+
+Void ShaderReflection::sort_bindings()
+{
+    std::sort(bindings.begin(), bindings.end(), [](const ReflectedBinding& left, const ReflectedBinding& right)
+    {
+        return left.setNumber != right.setNumber ? left.setNumber < right.setNumber : left.binding < right.binding;
+    });
+}
+
+UInt32 ShaderReflection::s_get_constant(const Module& module, UInt32 constantId)
+{
+    if (constantId >= module.definitions.size() || module.definitions[constantId] == 0)
+    {
+        return 1;
+    }
+
+    // Specialization constants are reflected with their default value
+    return module.words[module.definitions[constantId] + 3];
+}
+
+UInt32 ShaderReflection::s_get_type_size(const Module& module, UInt32 typeId)
+{
+    if (typeId >= module.definitions.size() || module.definitions[typeId] == 0)
+    {
+        return 0;
+    }
+
+    const UInt32* instruction = module.words + module.definitions[typeId];
+    switch (instruction[0] & 0xFFFF)
+    {
+    case OP_TYPE_BOOL:
+    {
+        return 4;
+    }
+    case OP_TYPE_INT:
+    case OP_TYPE_FLOAT:
+    {
+        return instruction[2] / 8;
+    }
+    case OP_TYPE_VECTOR:
+    case OP_TYPE_MATRIX:
+    {
+        return s_get_type_size(module, instruction[2]) * instruction[3];
+    }
+    case OP_TYPE_ARRAY:
+    {
+        const UInt32 stride = module.arrayStrides[typeId];
+        const UInt32 elementSize = stride != 0 ? stride : s_get_type_size(module, instruction[2]);
+        return elementSize * s_get_constant(module, instruction[3]);
+    }
+    case OP_TYPE_STRUCT:
+    {
+        UInt32 size = 0;
+        const UInt32 membersCount = (instruction[0] >> 16) - 2;
+        for (UInt32 member = 0; member < membersCount; ++member)
+        {
+            const UInt64 key = (UInt64(typeId) << 32) | member;
+            const UInt32 memberTypeId = instruction[2 + member];
+            UInt32 memberSize = s_get_type_size(module, memberTypeId);
+
+            // Columns of matrix in block are padded to its stride
+            const auto matrixStride = module.matrixStrides.find(key);
+            if (matrixStride != module.matrixStrides.end() && module.definitions[memberTypeId] != 0)
+            {
+                const UInt32* matrix = module.words + module.definitions[memberTypeId];
+                if ((matrix[0] & 0xFFFF) == OP_TYPE_MATRIX)
+                {
+                    memberSize = matrixStride->second * matrix[3];
+                }
+            }
+
+            const auto offset = module.memberOffsets.find(key);
+            const UInt32 memberOffset = offset != module.memberOffsets.end() ? offset->second : size;
+            size = std::max(size, memberOffset + memberSize);
+        }
+        return size;
+    }
+    case OP_TYPE_RUNTIME_ARRAY:
+    default:
+    {
+        return 0;
+    }
+    }
+}
+
+Bool ShaderReflection::s_get_descriptor_type(const Module& module, UInt32 typeId, UInt32 storageClass, VkDescriptorType& descriptorType, UInt32& descriptorCount)
+{
+    descriptorCount = 1;
+    if (typeId >= module.definitions.size() || module.definitions[typeId] == 0)
+    {
+        return false;
+    }
+
+    const UInt32* instruction = module.words + module.definitions[typeId];
+    UInt32 opcode = instruction[0] & 0xFFFF;
+    while (opcode == OP_TYPE_ARRAY || opcode == OP_TYPE_RUNTIME_ARRAY)
+    {
+        descriptorCount = opcode == OP_TYPE_ARRAY ? descriptorCount * s_get_constant(module, instruction[3]) : 0;
+        typeId = instruction[2];
+        if (typeId >= module.definitions.size() || module.definitions[typeId] == 0)
+        {
+            return false;
+        }
+        instruction = module.words + module.definitions[typeId];
+        opcode = instruction[0] & 0xFFFF;
+    }
+
+    switch (storageClass)
+    {
+    case STORAGE_CLASS_UNIFORM_CONSTANT:
+    {
+        if (opcode == OP_TYPE_SAMPLED_IMAGE)
+        {
+            descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+            return true;
+        }
+        if (opcode == OP_TYPE_SAMPLER)
+        {
+            descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER;
+            return true;
+        }
+        if (opcode == OP_TYPE_ACCELERATION_STRUCTURE)
+        {
+            descriptorType = VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR;
+            return true;
+        }
+        if (opcode != OP_TYPE_IMAGE)
+        {
+            return false;
+        }
+
+        const UInt32 dimension = instruction[3];
+        const Bool isStorage = instruction[7] == IMAGE_STORAGE;
+        if (dimension == DIM_BUFFER)
+        {
+            descriptorType = isStorage ? VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+        }
+        else if (dimension == DIM_SUBPASS_DATA)
+        {
+            descriptorType = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+        } else {
+            descriptorType = isStorage ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+        }
+        return true;
+    }
+    case STORAGE_CLASS_UNIFORM:
+    {
+        // Before SPIR-V 1.3 storage buffers were uniform blocks decorated as buffer blocks
+        descriptorType = module.areBufferBlocks[typeId] ? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        return true;
+    }
+    case STORAGE_CLASS_STORAGE_BUFFER:
+    {
+        descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        return true;
+    }
+    default:
+    {
+        return false;
+    }
+    }
+}
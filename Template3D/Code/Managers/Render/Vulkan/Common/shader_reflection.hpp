@@ -0,0 +1,51 @@
+#pragma once
+#include <vulkan/vulkan.hpp>
+
+struct ReflectedBinding
+{
+    UInt32 setNumber;
+    UInt32 binding;
+    VkDescriptorType descriptorType;
+    // Zero for runtime sized arrays
+    UInt32 descriptorCount;
+    VkShaderStageFlags stageFlags;
+};
+
+/** Descriptor bindings and push constants used by compiled SPIR-V, stages of one set can be merged */
+class ShaderReflection
+{
+private:
+    // Sorted by set number and binding
+    DynamicArray<ReflectedBinding> bindings;
+    // Size is zero when shader has no push constants
+    VkPushConstantRange pushConstants{};
+
+public:
+    // Only resources listed by entry points are reflected, so unused declarations do not get bindings
+    Bool create(const DynamicArray<UInt32>& code, VkShaderStageFlags stage);
+    // Returns false when the same binding has different type or count in other stage
+    Bool merge(const ShaderReflection& other);
+
+    [[nodiscard]]
+    const DynamicArray<ReflectedBinding>& get_bindings() const;
+    [[nodiscard]]
+    const VkPushConstantRange& get_push_constants() const;
+    // Highest set number + 1, sets without bindings in between are counted as well
+    [[nodiscard]]
+    UInt32 get_sets_count() const;
+
+    Void clear();
+
+private:
+    struct Module;
+
+    Void sort_bindings();
+
+    static UInt32 s_get_constant(const Module& module, UInt32 constantId);
+    static UInt32 s_get_type_size(const Module& module, UInt32 typeId);
+    static Bool s_get_descriptor_type(const Module& module,
+                                      UInt32 typeId,
+                                      UInt32 storageClass,
+                                      VkDescriptorType& descriptorType,
+                                      UInt32& descriptorCount);
+};
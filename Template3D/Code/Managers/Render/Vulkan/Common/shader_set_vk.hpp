@@ -11,4 +11,6 @@ struct ShaderSetVK
     Handle<RenderPass> renderPassHandle;
     Handle<DescriptorPool> descriptorPoolHandle;
     DynamicArray<Handle<ShaderVK>> shaderHandles;
+    // Drawn instead while pipeline is created on worker thread, draws are skipped without it
+    Handle<ShaderSetVK> fallbackHandle = Handle<ShaderSetVK>::NONE;
 };
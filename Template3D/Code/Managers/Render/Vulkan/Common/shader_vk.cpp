@@ -1,30 +1,101 @@
 #include "shader_vk.hpp"
 
 #include "logical_device.hpp"
+#include "spirv_cache.hpp"
+#include "Render/Vulkan/Shaders/builtin_shaders.hpp"
+#include "Utilities/hash.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <filesystem>
 #include <fstream>
+#include <mutex>
 #include <magic_enum.hpp>
 #include <glslang/SPIRV/GlslangToSpv.h>
+#include <glslang/SPIRV/SPVRemapper.h>
 #include <glslang/Public/ShaderLang.h>
 #include <glslang/Public/ResourceLimits.h>
+#include <spirv-tools/optimizer.hpp>
+
+// Has to be increased when compilation changes in way not covered by cache key
+constexpr UInt32 SPIRV_CACHE_VERSION = 2;
+constexpr Int32 GLSL_VERSION = 460;
+constexpr glslang::EShTargetClientVersion TARGET_CLIENT = glslang::EShTargetVulkan_1_3;
+constexpr glslang::EShTargetLanguageVersion TARGET_SPIRV = glslang::EShTargetSpv_1_6;
+constexpr spv_target_env TARGET_ENVIRONMENT = SPV_ENV_VULKAN_1_3;
+// Remapper reports errors through global handler, shaders are compiled on many threads so flag is per thread
+static thread_local Bool isRemapFailed = false;
+static std::once_flag compilerFlag;
+static std::atomic<Bool> isCompilerInitialized = false;
+
+
+// Serves headers collected before parsing, so compiled code matches headers hashed in cache key
+class ShaderVK::Includer final : public glslang::TShader::Includer
+{
+private:
+    const ShaderIncludes& includes;
 
+public:
+    explicit Includer(const ShaderIncludes& shaderIncludes)
+        : includes(shaderIncludes)
+    {}
 
-Void ShaderVK::create(const String& shaderFilePath, const String& shaderFunctionName, const EShaderType shaderType, const LogicalDevice& logicalDevice, const VkAllocationCallbacks* allocator)
-{
-    filePath = shaderFilePath;
-    functionName = shaderFunctionName;
-    type = shaderType;
+    IncludeResult* includeLocal(const Char* headerName, const Char* includerName, size_t) override
+    {
+        return include(headerName, includerName);
+    }
 
-    compose_name();
+    IncludeResult* includeSystem(const Char* headerName, const Char* includerName, size_t) override
+    {
+        return include(headerName, includerName);
+    }
 
-    const Bool isLoaded = load();
-    if (!isLoaded)
+    Void releaseInclude(IncludeResult* result) override
+    {
+        delete result;
+    }
+
+private:
+    IncludeResult* include(const Char* headerName, const Char* includerName) const
+    {
+        // Resolved path is given back as includer name of nested headers
+        const String path = includes.resolve(headerName, includerName);
+        const String* content = includes.get_content(path);
+        if (!content)
+        {
+            return nullptr;
+        }
+        return new IncludeResult(path, content->data(), content->size(), nullptr);
+    }
+};
+
+
+Void ShaderVK::create(const String& shaderFilePath, const String& shaderFunctionName, const EShaderType shaderType, const LogicalDevice& logicalDevice, SpirvCache& spirvCache, const VkAllocationCallbacks* allocator)
+{
+    ShaderDescription description;
+    description.filePath     = shaderFilePath;
+    description.type         = shaderType;
+    description.functionName = shaderFunctionName;
+
+    const Bool isPrepared = prepare(description, spirvCache);
+    if (!isPrepared)
     {
         return;
     }
 
-    const Bool isCompiled = compile();
-    if (!isCompiled)
+    create_module(logicalDevice, allocator);
+}
+
+Void ShaderVK::create(const String& shaderName, const String& shaderCode, const String& shaderFunctionName, const EShaderType shaderType, const LogicalDevice& logicalDevice, SpirvCache& spirvCache, const VkAllocationCallbacks* allocator)
+{
+    ShaderDescription description;
+    description.filePath     = shaderName;
+    description.code         = shaderCode;
+    description.type         = shaderType;
+    description.functionName = shaderFunctionName;
+
+    const Bool isPrepared = prepare(description, spirvCache);
+    if (!isPrepared)
     {
         return;
     }
@@ -32,41 +103,90 @@ Void ShaderVK::create(const String& shaderFilePath, const String& shaderFunction
     create_module(logicalDevice, allocator);
 }
 
-Void ShaderVK::create(const String& shaderName, const String& shaderCode, const String& shaderFunctionName, const EShaderType shaderType, const LogicalDevice& logicalDevice, const VkAllocationCallbacks* allocator)
+Bool ShaderVK::recreate(const LogicalDevice& logicalDevice, SpirvCache& spirvCache, const VkAllocationCallbacks* allocator)
 {
-    filePath = shaderName;
-    functionName = shaderFunctionName;
-    type = shaderType;
-    code = shaderCode;
+    clear(logicalDevice, allocator);
+
+    const Bool isCompiled = recompile(spirvCache);
+    if (!isCompiled)
+    {
+        return false;
+    }
+
+    return create_module(logicalDevice, allocator);
+}
+
+Bool ShaderVK::prepare(const ShaderDescription& description, SpirvCache& spirvCache)
+{
+    module = VK_NULL_HANDLE;
+    filePath = description.filePath;
+    functionName = description.functionName;
+    type = description.type;
+    code = description.code;
+    spirvOptions = description.spirvOptions;
+
+    // Sorted, so the same set of defines always gives the same name and cache key
+    defines = description.defines;
+    std::sort(defines.begin(), defines.end());
+    defines.erase(std::unique(defines.begin(), defines.end()), defines.end());
+
+    specializationEntries.clear();
+    specializationData.clear();
+    for (const SpecializationConstant& constant : description.constants)
+    {
+        VkSpecializationMapEntry& entry = specializationEntries.emplace_back();
+        entry.constantID = constant.id;
+        entry.offset     = UInt32(specializationData.size() * sizeof(UInt32));
+        entry.size       = sizeof(UInt32);
+        specializationData.push_back(constant.value);
+    }
 
     compose_name();
 
-    const Bool isCompiled = compile();
+    // Built-in shaders were compiled at build time, so neither their file nor glslang is needed
+    if (code.empty() && filePath.starts_with(BUILTIN_SHADERS_PREFIX))
+    {
+        if (!load_builtin())
+        {
+            SPDLOG_ERROR("Built-in shader {} is not embedded, its variant has to be added by embed_shader in CMakeLists.txt", name);
+            return false;
+        }
+        return reflect();
+    }
+
+    if (code.empty())
+    {
+        const Bool isLoaded = load();
+        if (!isLoaded)
+        {
+            return false;
+        }
+    }
+
+    const Bool isCompiled = compile(spirvCache);
     if (!isCompiled)
     {
-        return;
+        return false;
     }
 
-    create_module(logicalDevice, allocator);
+    return reflect();
 }
 
-Bool ShaderVK::recreate(const LogicalDevice& logicalDevice, const VkAllocationCallbacks* allocator)
+Bool ShaderVK::recompile(SpirvCache& spirvCache)
 {
-    clear(logicalDevice, allocator);
-
     const Bool isLoaded = load();
     if (!isLoaded)
     {
         return false;
     }
 
-    const Bool isCompiled = compile();
+    const Bool isCompiled = compile(spirvCache);
     if (!isCompiled)
     {
         return false;
     }
 
-    return create_module(logicalDevice, allocator);
+    return reflect();
 }
 
 const String& ShaderVK::get_name() const
@@ -94,6 +214,60 @@ EShaderType ShaderVK::get_type() const
     return type;
 }
 
+VkShaderStageFlagBits ShaderVK::get_stage() const
+{
+    switch (type)
+    {
+    case EShaderType::Vertex:
+    {
+        return VK_SHADER_STAGE_VERTEX_BIT;
+    }
+    case EShaderType::Geometry:
+    {
+        return VK_SHADER_STAGE_GEOMETRY_BIT;
+    }
+    case EShaderType::Fragment:
+    {
+        return VK_SHADER_STAGE_FRAGMENT_BIT;
+    }
+    case EShaderType::Compute:
+    {
+        return VK_SHADER_STAGE_COMPUTE_BIT;
+    }
+    case EShaderType::Count:
+    case EShaderType::None:
+    default:
+    {
+        return VK_SHADER_STAGE_ALL;
+    }
+    }
+}
+
+const DynamicArray<String>& ShaderVK::get_defines() const
+{
+    return defines;
+}
+
+const ShaderReflection& ShaderVK::get_reflection() const
+{
+    return reflection;
+}
+
+const DynamicArray<String>& ShaderVK::get_included_files() const
+{
+    return includes.get_paths();
+}
+
+VkSpecializationInfo ShaderVK::get_specialization_info() const
+{
+    VkSpecializationInfo info{};
+    info.mapEntryCount = UInt32(specializationEntries.size());
+    info.pMapEntries   = specializationEntries.data();
+    info.dataSize      = specializationData.size() * sizeof(UInt32);
+    info.pData         = specializationData.data();
+    return info;
+}
+
 Void ShaderVK::compose_name()
 {
     String prefix;
@@ -129,10 +303,58 @@ Void ShaderVK::compose_name()
 
     const std::filesystem::path path(filePath);
     name = prefix + path.stem().string();
+
+    if (defines.empty() && specializationEntries.empty())
+    {
+        return;
+    }
+
+    String suffix;
+    for (const String& define : defines)
+    {
+        suffix += suffix.empty() ? define : "," + define;
+    }
+    for (UInt64 i = 0; i < specializationEntries.size(); ++i)
+    {
+        const String constant = fmt::format("{}={}", specializationEntries[i].constantID, specializationData[i]);
+        suffix += suffix.empty() ? constant : "," + constant;
+    }
+    name += "[" + suffix + "]";
 }
 
-Bool ShaderVK::compile()
+String ShaderVK::compose_preamble() const
 {
+    // Enables #include without declaring extension in every shader
+    String preamble = "#extension GL_GOOGLE_include_directive : enable\n";
+    for (const String& define : defines)
+    {
+        const UInt64 separator = define.find('=');
+        if (separator == String::npos)
+        {
+            preamble += "#define " + define + "\n";
+        } else {
+            preamble += "#define " + define.substr(0, separator) + " " + define.substr(separator + 1) + "\n";
+        }
+    }
+    return preamble;
+}
+
+Bool ShaderVK::compile(SpirvCache& spirvCache)
+{
+    // Headers are read before key is computed, so edited header is not served from cache
+    includes.collect(code, filePath);
+    const UInt64 cacheKey = get_cache_key();
+    if (spirvCache.load(cacheKey, compiledCode))
+    {
+        return true;
+    }
+
+    if (!s_initialize_compiler())
+    {
+        return false;
+    }
+    const auto begin = std::chrono::steady_clock::now();
+
     EShLanguage stage;
     switch (type)
     {
@@ -168,13 +390,20 @@ Bool ShaderVK::compile()
     glslang::TShader shader(stage);
 
     const Char* shaderStrings = code.c_str();
-    shader.setStrings(&shaderStrings, 1);
-
-    shader.setEnvInput(glslang::EShSourceGlsl, stage, glslang::EShClientVulkan, 460);
-    shader.setEnvClient(glslang::EShClientVulkan, glslang::EShTargetVulkan_1_3);
-    shader.setEnvTarget(glslang::EShTargetSpv, glslang::EShTargetSpv_1_6);
-
-    if (!shader.parse(GetDefaultResources(), 100, false, EShMsgDefault))
+    const Int32 shaderLength = Int32(code.size());
+    // Name of string is includer name of top level headers
+    const Char* shaderNames = filePath.c_str();
+    shader.setStringsWithLengthsAndNames(&shaderStrings, &shaderLength, &shaderNames, 1);
+    // glslang keeps only pointer to preamble, so it has to live until parsing is done
+    const String preamble = compose_preamble();
+    shader.setPreamble(preamble.c_str());
+
+    shader.setEnvInput(glslang::EShSourceGlsl, stage, glslang::EShClientVulkan, GLSL_VERSION);
+    shader.setEnvClient(glslang::EShClientVulkan, TARGET_CLIENT);
+    shader.setEnvTarget(glslang::EShTargetSpv, TARGET_SPIRV);
+
+    Includer includer(includes);
+    if (!shader.parse(GetDefaultResources(), 100, false, EShMsgDefault, includer))
     {
         SPDLOG_ERROR("GLSL parsing failed: {}", shader.getInfoLog());
         return false;
@@ -189,11 +418,144 @@ Bool ShaderVK::compile()
         return false;
     }
 
-    glslang::GlslangToSpv(*program.getIntermediate(stage), compiledCode);
+    // GlslangToSpv runs only size passes by itself, so every optimization is done by optimize
+    glslang::SpvOptions spvOptions;
+    spvOptions.disableOptimizer = true;
+
+    compiledCode.clear();
+    spv::SpvBuildLogger logger;
+    glslang::GlslangToSpv(*program.getIntermediate(stage), compiledCode, &logger, &spvOptions);
+    const String messages = logger.getAllMessages();
+    if (!messages.empty())
+    {
+        SPDLOG_WARN("SPIR-V generation of shader {}: {}", name, messages);
+    }
+
+    const UInt64 generatedSize = compiledCode.size() * sizeof(UInt32);
+    if (spirvOptions.optimization != ESpirvOptimization::None || spirvOptions.stripDebugInfo)
+    {
+        optimize();
+    }
+    if (spirvOptions.remap)
+    {
+        remap();
+    }
+
+    const auto end = std::chrono::steady_clock::now();
+    spirvCache.record_compilation(generatedSize,
+                                  compiledCode.size() * sizeof(UInt32),
+                                  UInt64(std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count()));
+    spirvCache.store(cacheKey, compiledCode);
 
     return true;
 }
 
+Void ShaderVK::optimize()
+{
+    spvtools::Optimizer optimizer(TARGET_ENVIRONMENT);
+    optimizer.SetMessageConsumer([this](spv_message_level_t level,
+                                        const Char*,
+                                        const spv_position_t&,
+                                        const Char* message)
+    {
+        if (level <= SPV_MSG_ERROR)
+        {
+            SPDLOG_WARN("SPIR-V optimization of shader {}: {}", name, message);
+        }
+    });
+
+    switch (spirvOptions.optimization)
+    {
+    case ESpirvOptimization::Performance:
+    {
+        optimizer.RegisterPerformancePasses();
+        break;
+    }
+    case ESpirvOptimization::Size:
+    {
+        optimizer.RegisterSizePasses();
+        break;
+    }
+    case ESpirvOptimization::None:
+    default:
+    {
+        break;
+    }
+    }
+
+    if (spirvOptions.stripDebugInfo)
+    {
+        optimizer.RegisterPass(spvtools::CreateStripDebugInfoPass());
+    }
+
+    DynamicArray<UInt32> optimizedCode;
+    if (optimizer.Run(compiledCode.data(), compiledCode.size(), &optimizedCode))
+    {
+        compiledCode = std::move(optimizedCode);
+    }
+}
+
+Void ShaderVK::remap()
+{
+    // Default handler exits process, so it is replaced once before first remapping
+    static std::once_flag handlerFlag;
+    std::call_once(handlerFlag, []()
+    {
+        spv::spirvbin_t::registerErrorHandler([](const String& message)
+        {
+            SPDLOG_WARN("SPIR-V remapping failed: {}", message);
+            isRemapFailed = true;
+        });
+    });
+
+    UInt32 options = spv::spirvbin_t::MAP_ALL | spv::spirvbin_t::DCE_ALL;
+    if (spirvOptions.stripDebugInfo)
+    {
+        options |= spv::spirvbin_t::STRIP;
+    }
+
+    DynamicArray<UInt32> remappedCode = compiledCode;
+    isRemapFailed = false;
+    spv::spirvbin_t remapper;
+    remapper.remap(remappedCode, options);
+    if (!isRemapFailed)
+    {
+        compiledCode = std::move(remappedCode);
+    }
+}
+
+Bool ShaderVK::reflect()
+{
+    const Bool isReflected = reflection.create(compiledCode, get_stage());
+    if (!isReflected)
+    {
+        SPDLOG_ERROR("Failed to reflect shader {}", name);
+    }
+    return isReflected;
+}
+
+UInt64 ShaderVK::get_cache_key() const
+{
+    // Specialization constants are not part of key, they do not change compiled code
+    UInt64 key = hash_value(SPIRV_CACHE_VERSION);
+    key = hash_string(code, key);
+    key = includes.get_hash(key);
+    key = hash_value(UInt64(defines.size()), key);
+    for (const String& define : defines)
+    {
+        key = hash_string(define, key);
+    }
+    key = hash_value(type, key);
+    key = hash_string(functionName, key);
+    key = hash_value(spirvOptions.optimization, key);
+    key = hash_value(spirvOptions.stripDebugInfo, key);
+    key = hash_value(spirvOptions.remap, key);
+    key = hash_value(GLSL_VERSION, key);
+    key = hash_value(TARGET_CLIENT, key);
+    key = hash_value(TARGET_SPIRV, key);
+    return key;
+}
+
 Bool ShaderVK::load()
 {
     std::ifstream file(filePath, std::ios::ate | std::ios::binary);
@@ -211,6 +573,28 @@ Bool ShaderVK::load()
     return true;
 }
 
+Bool ShaderVK::load_builtin()
+{
+    String joinedDefines;
+    for (const String& define : defines)
+    {
+        joinedDefines += joinedDefines.empty() ? define : "," + define;
+    }
+
+    for (const BuiltinShader& builtin : BUILTIN_SHADERS)
+    {
+        if (filePath == builtin.filePath && joinedDefines == builtin.defines)
+        {
+            compiledCode.assign(builtin.code, builtin.code + builtin.wordsCount);
+            // Name keeps built-in path, so variants are still found by it
+            filePath = builtin.sourcePath;
+            includes.clear();
+            return true;
+        }
+    }
+    return false;
+}
+
 Bool ShaderVK::create_module(const LogicalDevice& logicalDevice, const VkAllocationCallbacks* allocator)
 {
     VkShaderModuleCreateInfo createInfo{};
@@ -230,6 +614,35 @@ Bool ShaderVK::create_module(const LogicalDevice& logicalDevice, const VkAllocat
 Void ShaderVK::clear(const LogicalDevice& logicalDevice, const VkAllocationCallbacks* allocator)
 {
     code.clear();
+    includes.clear();
     vkDestroyShaderModule(logicalDevice.get_device(), module, allocator);
     module = VK_NULL_HANDLE;
+}
+
+Bool ShaderVK::s_initialize_compiler()
+{
+    // Shaders are compiled on many threads, only first of them initializes
+    std::call_once(compilerFlag, []()
+    {
+        isCompilerInitialized = glslang::InitializeProcess();
+        if (!isCompilerInitialized)
+        {
+            SPDLOG_ERROR("Failed to initialize glslang.");
+        }
+    });
+    return isCompilerInitialized;
+}
+
+Void ShaderVK::s_finalize_compiler()
+{
+    if (isCompilerInitialized)
+    {
+        glslang::FinalizeProcess();
+        isCompilerInitialized = false;
+    }
+}
+
+Bool ShaderVK::s_is_compiler_initialized()
+{
+    return isCompilerInitialized;
 }
\ No newline at end of file
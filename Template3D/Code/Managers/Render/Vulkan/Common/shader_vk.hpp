@@ -1,9 +1,57 @@
 #pragma once
 #include "Render/Common/shader_type.hpp"
+#include "Render/Common/shader_includes.hpp"
+#include "shader_reflection.hpp"
 
 #include <vulkan/vulkan.hpp>
 
 class LogicalDevice;
+class SpirvCache;
+
+// Value of constant declared with layout(constant_id = id), floats are passed by bits
+struct SpecializationConstant
+{
+    UInt32 id;
+    UInt32 value;
+};
+
+enum class ESpirvOptimization : UInt8
+{
+    None,
+    // Recommended pass lists of SPIRV-Tools optimizer, run on generated code before remapping
+    Performance,
+    Size,
+};
+
+// Release builds optimize by default, debug builds keep names for debuggers and validation messages
+struct SpirvOptions
+{
+#ifdef NDEBUG
+    ESpirvOptimization optimization = ESpirvOptimization::Performance;
+    Bool stripDebugInfo = true;
+    // Dead code elimination and id compaction of SPVRemapper
+    Bool remap = true;
+#else
+    ESpirvOptimization optimization = ESpirvOptimization::None;
+    Bool stripDebugInfo = false;
+    Bool remap = false;
+#endif
+};
+
+// Shader is loaded from file path when code is empty, otherwise path is used only as name
+struct ShaderDescription
+{
+    String filePath;
+    String code;
+    EShaderType type = EShaderType::None;
+    String functionName = "main";
+    // Injected as preamble, NAME or NAME=VALUE
+    DynamicArray<String> defines;
+    // Applied when pipeline is created, so they do not need another compilation
+    DynamicArray<SpecializationConstant> constants;
+    SpirvOptions spirvOptions;
+};
+
 class ShaderVK
 {
 public:
@@ -11,17 +59,26 @@ public:
                 const String& shaderFunctionName,
                 const EShaderType shaderType,
                 const LogicalDevice& logicalDevice,
+                SpirvCache& spirvCache,
                 const VkAllocationCallbacks* allocator);
     Void create(const String& shaderName,
                 const String& shaderCode,
                 const String& shaderFunctionName,
                 const EShaderType shaderType,
                 const LogicalDevice& logicalDevice,
+                SpirvCache& spirvCache,
                 const VkAllocationCallbacks* allocator);
 
     Bool recreate(const LogicalDevice& logicalDevice,
+                  SpirvCache& spirvCache,
                   const VkAllocationCallbacks* allocator);
 
+    // Loads and compiles code without touching device, different shaders can be prepared on many threads
+    Bool prepare(const ShaderDescription& description, SpirvCache& spirvCache);
+    // Reloads file and compiles it again, current module stays valid until it is cleared
+    Bool recompile(SpirvCache& spirvCache);
+    Bool create_module(const LogicalDevice& logicalDevice, const VkAllocationCallbacks* allocator);
+
     [[nodiscard]]
     const String& get_name() const;
     [[nodiscard]]
@@ -32,9 +89,27 @@ public:
     const VkShaderModule& get_module() const;
     [[nodiscard]]
     EShaderType get_type() const;
+    [[nodiscard]]
+    VkShaderStageFlagBits get_stage() const;
+    [[nodiscard]]
+    const DynamicArray<String>& get_defines() const;
+    [[nodiscard]]
+    const ShaderReflection& get_reflection() const;
+    // Headers read by last compilation, including cached one
+    [[nodiscard]]
+    const DynamicArray<String>& get_included_files() const;
+    // Pointers of info are valid as long as shader is not modified, count is zero without constants
+    [[nodiscard]]
+    VkSpecializationInfo get_specialization_info() const;
 
     Void clear(const LogicalDevice& logicalDevice, const VkAllocationCallbacks* allocator);
 
+    // Called by first compilation, so startup with cached and built-in shaders does not initialize glslang
+    static Bool s_initialize_compiler();
+    static Void s_finalize_compiler();
+    [[nodiscard]]
+    static Bool s_is_compiler_initialized();
+
 private:
     VkShaderModule module;
     String code;
@@ -42,9 +117,31 @@ private:
     String filePath;
     String name, functionName;
     EShaderType type;
+    DynamicArray<String> defines;
+    SpirvOptions spirvOptions;
+    DynamicArray<VkSpecializationMapEntry> specializationEntries;
+    DynamicArray<UInt32> specializationData;
+    // Read from compiled code, so it is valid for cached code too
+    ShaderReflection reflection;
+    ShaderIncludes includes;
+
+    class Includer;
 
+    // Variants of the same source get defines and constants as suffix, so they do not collide by name
     Void compose_name();
-    Bool compile();
+    [[nodiscard]]
+    String compose_preamble() const;
+    // Compiled code is taken from cache when source, included headers, stage, entry point, target and options did not change
+    Bool compile(SpirvCache& spirvCache);
+    // Optimization passes and stripping of debug info, keeps code as it was when optimizer fails
+    Void optimize();
+    // Keeps code as it was when remapper reports error
+    Void remap();
+    Bool reflect();
+    [[nodiscard]]
+    UInt64 get_cache_key() const;
     Bool load();
-    Bool create_module(const LogicalDevice& logicalDevice, const VkAllocationCallbacks* allocator);
+    // Returns false when there is no built-in shader with the same file path and defines,
+    // file path is replaced by path of its source, so recompile reads the source
+    Bool load_builtin();
 };
\ No newline at end of file
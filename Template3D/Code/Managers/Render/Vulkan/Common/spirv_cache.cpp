@@ -0,0 +1,110 @@
+#include "spirv_cache.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+
+Void SpirvCache::create(const String& cacheDirectoryPath)
+{
+    directoryPath      = cacheDirectoryPath;
+    hitsCount          = 0;
+    missesCount        = 0;
+    compiledCount      = 0;
+    generatedBytes     = 0;
+    finalBytes         = 0;
+    compileNanoseconds = 0;
+
+    std::error_code error;
+    std::filesystem::create_directories(directoryPath, error);
+    if (error)
+    {
+        SPDLOG_WARN("Failed to create SPIR-V cache directory {}: {}", directoryPath, error.message());
+    }
+}
+
+Bool SpirvCache::load(UInt64 key, DynamicArray<UInt32>& code)
+{
+    std::ifstream file(get_file_path(key), std::ios::ate | std::ios::binary);
+    if (!file.is_open())
+    {
+        missesCount++;
+        return false;
+    }
+
+    const UInt64 size = UInt64(file.tellg());
+    // Truncated file or file not being SPIR-V is compiled again
+    constexpr UInt32 SPIRV_MAGIC = 0x07230203U;
+    if (size < sizeof(UInt32) || size % sizeof(UInt32) != 0)
+    {
+        missesCount++;
+        return false;
+    }
+
+    code.resize(size / sizeof(UInt32));
+    file.seekg(0);
+    file.read(reinterpret_cast<Char*>(code.data()), Int64(size));
+    if (!file || code[0] != SPIRV_MAGIC)
+    {
+        code.clear();
+        missesCount++;
+        return false;
+    }
+
+    hitsCount++;
+    return true;
+}
+
+Void SpirvCache::store(UInt64 key, const DynamicArray<UInt32>& code) const
+{
+    if (directoryPath.empty() || code.empty())
+    {
+        return;
+    }
+
+    // Written under temporary name of thread, so reader never sees half written file
+    const String filePath = get_file_path(key);
+    const String temporaryPath = fmt::format("{}.{}.tmp", filePath, std::hash<std::thread::id>{}(std::this_thread::get_id()));
+    {
+        std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+        {
+            SPDLOG_WARN("Failed to write SPIR-V cache file {}", temporaryPath);
+            return;
+        }
+        file.write(reinterpret_cast<const Char*>(code.data()), Int64(code.size() * sizeof(UInt32)));
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temporaryPath, filePath, error);
+    if (error)
+    {
+        SPDLOG_WARN("Failed to store SPIR-V cache file {}: {}", filePath, error.message());
+        std::filesystem::remove(temporaryPath, error);
+    }
+}
+
+Void SpirvCache::record_compilation(UInt64 generatedSize, UInt64 finalSize, UInt64 nanoseconds)
+{
+    compiledCount++;
+    generatedBytes += generatedSize;
+    finalBytes += finalSize;
+    compileNanoseconds += nanoseconds;
+}
+
+SpirvCacheStatistics SpirvCache::get_statistics() const
+{
+    SpirvCacheStatistics statistics;
+    statistics.hitsCount           = hitsCount;
+    statistics.missesCount         = missesCount;
+    statistics.compiledCount       = compiledCount;
+    statistics.generatedBytes      = generatedBytes;
+    statistics.finalBytes          = finalBytes;
+    statistics.compileMilliseconds = Float64(compileNanoseconds) / 1'000'000.0;
+    return statistics;
+}
+
+String SpirvCache::get_file_path(UInt64 key) const
+{
+    return fmt::format("{}{:016x}.spv", directoryPath, key);
+}
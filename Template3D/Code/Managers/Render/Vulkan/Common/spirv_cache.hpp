@@ -0,0 +1,42 @@
+#pragma once
+#include <atomic>
+
+struct SpirvCacheStatistics
+{
+    UInt64 hitsCount   = 0;
+    UInt64 missesCount = 0;
+    // Misses compiled since creation, sizes are taken after generation and after remapping
+    UInt64 compiledCount  = 0;
+    UInt64 generatedBytes = 0;
+    UInt64 finalBytes     = 0;
+    Float64 compileMilliseconds = 0.0;
+};
+
+/** Compiled SPIR-V kept on disk, one file per hash of everything that affects compilation */
+class SpirvCache
+{
+private:
+    String directoryPath;
+    // Shaders could be compiled on many threads, every key has own file so only counters are shared
+    std::atomic<UInt64> hitsCount = 0;
+    std::atomic<UInt64> missesCount = 0;
+    std::atomic<UInt64> compiledCount = 0;
+    std::atomic<UInt64> generatedBytes = 0;
+    std::atomic<UInt64> finalBytes = 0;
+    std::atomic<UInt64> compileNanoseconds = 0;
+
+public:
+    Void create(const String& cacheDirectoryPath);
+
+    // Returns false and counts miss when there is no valid code for key
+    Bool load(UInt64 key, DynamicArray<UInt32>& code);
+    Void store(UInt64 key, const DynamicArray<UInt32>& code) const;
+    Void record_compilation(UInt64 generatedSize, UInt64 finalSize, UInt64 nanoseconds);
+
+    [[nodiscard]]
+    SpirvCacheStatistics get_statistics() const;
+
+private:
+    [[nodiscard]]
+    String get_file_path(UInt64 key) const;
+};
@@ -0,0 +1,26 @@
+#pragma once
+// Generated by embed_shader step of CMakeLists.txt
+#include "default_vert.hpp"
+#include "default_frag.hpp"
+#include "default_frag_alpha_test.hpp"
+
+// Descriptions with file path starting with it are never loaded from disk
+inline constexpr const Char* BUILTIN_SHADERS_PREFIX = "Builtin/";
+
+// Shader compiled at build time, description with its file path and defines skips loading and compilation
+struct BuiltinShader
+{
+    const Char* filePath;
+    // Absolute path of source, defined by CMakeLists.txt, hot reload and dependency graph use it
+    const Char* sourcePath;
+    // Sorted and separated by commas like in shader name
+    const Char* defines;
+    const UInt32* code;
+    UInt64 wordsCount;
+};
+
+inline constexpr Array<BuiltinShader, 3> BUILTIN_SHADERS = {{
+    { "Builtin/Default.vert", BUILTIN_SHADERS_DIRECTORY "default.vert", "",           DEFAULT_VERT_SPIRV,            std::size(DEFAULT_VERT_SPIRV) },
+    { "Builtin/Default.frag", BUILTIN_SHADERS_DIRECTORY "default.frag", "",           DEFAULT_FRAG_SPIRV,            std::size(DEFAULT_FRAG_SPIRV) },
+    { "Builtin/Default.frag", BUILTIN_SHADERS_DIRECTORY "default.frag", "ALPHA_TEST", DEFAULT_FRAG_ALPHA_TEST_SPIRV, std::size(DEFAULT_FRAG_ALPHA_TEST_SPIRV) },
+}};
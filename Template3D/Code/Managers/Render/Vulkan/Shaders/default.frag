@@ -0,0 +1,46 @@
+#version 460
+#extension GL_EXT_nonuniform_qualifier : require
+
+layout (location = 0) in vec3 worldPosition;
+layout (location = 1) in vec3 worldNormal;
+layout (location = 2) in vec2 uvFragment;
+
+// Every texture is registered once, material selects its own by index
+layout(set = 1, binding = 0) uniform sampler2D textures[];
+
+layout(push_constant) uniform Material
+{
+    uint albedoIndex;
+} material;
+
+layout (location = 0) out vec4 color;
+
+layout (constant_id = 0) const float LIGHT_POSITION_X = 10.0f;
+layout (constant_id = 1) const float LIGHT_POSITION_Y = 50.0f;
+layout (constant_id = 2) const float LIGHT_POSITION_Z = 10.0f;
+
+void main()
+{
+    const vec3 lightColor = vec3(1.0f, 1.0f, 1.0f);
+    const vec3 lightPosition = vec3(LIGHT_POSITION_X,
+                                    LIGHT_POSITION_Y,
+                                    LIGHT_POSITION_Z);
+    vec4 objectColor = texture(textures[material.albedoIndex], uvFragment);
+#ifdef ALPHA_TEST
+    if (objectColor.w < 0.1f)
+    {
+        discard;
+    }
+#endif
+
+    // ambient
+    float ambientStrength = 0.5f;
+    vec3 ambient = ambientStrength * lightColor;
+    // diffuse
+    vec3 normal = normalize(worldNormal);
+    vec3 lightDirection = normalize(lightPosition - worldPosition);
+    float diff = max(dot(normal, lightDirection), 0.0f);
+    vec3 diffuse = diff * lightColor;
+
+    color = vec4((ambient + diffuse) * objectColor.xyz, 1.0f);
+}
@@ -0,0 +1,30 @@
+#version 460
+layout (location = 0) in vec3 position;
+layout (location = 1) in vec3 normal;
+layout (location = 2) in vec2 uv;
+
+
+layout(binding = 0) uniform UniformBufferObject
+{
+    mat4 viewProjection;
+} ubo;
+
+
+layout(std430, binding = 1) readonly buffer Instances
+{
+    mat4 transforms[];
+} instances;
+
+layout (location = 0) out vec3 worldPosition;
+layout (location = 1) out vec3 worldNormal;
+layout (location = 2) out vec2 uvFragment;
+
+void main()
+{
+    mat4 model = instances.transforms[gl_InstanceIndex];
+    worldPosition = vec3(model * vec4(position, 1.0f));
+    worldNormal = mat3(transpose(inverse(model))) * normal;
+    uvFragment = uv;
+
+    gl_Position = ubo.viewProjection * vec4(worldPosition, 1.0f);
+}
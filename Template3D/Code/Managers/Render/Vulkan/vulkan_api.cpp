@@ -4,18 +4,30 @@
 #include "Resource/Common/texture.hpp"
 #include "Resource/Common/mesh.hpp"
 #include "Resource/Common/model.hpp"
+#include "Render/Common/render_queue.hpp"
 
 #include <filesystem>
+#include <chrono>
 #include <GLFW/glfw3.h>
 #include <magic_enum.hpp>
-#include <glslang/Public/ShaderLang.h>
 
 #include "simulation.hpp"
 
 
+Void Vulkan::set_frames_in_flight(UInt32 count)
+{
+    if (!frames.empty())
+    {
+        SPDLOG_ERROR("Frames in flight count can not be changed after startup.");
+        return;
+    }
+    framesInFlight = std::clamp(count, 1U, MAX_FRAMES_IN_FLIGHT);
+}
+
 Void Vulkan::startup(Simulation<Vulkan>& simulation)
 {
-    isFrameEven = false;
+    const auto startupBegin = std::chrono::steady_clock::now();
+    frameIndex = 0;
     create_vulkan_instance();
     if constexpr (DebugMessenger::ENABLE_VALIDATION_LAYERS)
     {
@@ -24,228 +36,395 @@ Void Vulkan::startup(Simulation<Vulkan>& simulation)
     create_surface(simulation);
     physicalDevice.select_physical_device(instance, surface);
     logicalDevice.create(physicalDevice, debugMessenger, nullptr);
-
-    create_dynamic_buffer<UniformBufferObject>(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, "DefaultUniformBuffer");
+    memoryAllocator.create(physicalDevice);
+    queueTimeline.create(logicalDevice, nullptr);
+    pipelineCache.create(physicalDevice, logicalDevice, PIPELINE_CACHE_PATH, nullptr);
+    spirvCache.create(SPIRV_CACHE_PATH);
 
     graphicsPool = create_command_pool(VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT);
-    create_command_buffers(get_command_pool(graphicsPool),
-                           VK_COMMAND_BUFFER_LEVEL_PRIMARY,
-                           { "DefaultCommandBuffer" });
+    immediateContext.create(physicalDevice, logicalDevice, nullptr);
+    create_frames();
+    create_staging_buffer();
+    create_compute_resources();
 
-    inFlightFence = create_fence("DefaultFence", VK_FENCE_CREATE_SIGNALED_BIT);
-    imageAvailable = create_semaphore("DefaultImageAvailable");
-    renderFinished = create_semaphore("DefaultSemaphore");
-
-    if (!glslang::InitializeProcess())
-    {
-        SPDLOG_ERROR("Failed to initialize glslang.");
-        return;
-    }
     // Create default pipeline
     {
-        String vertCode = "#version 460                                                         \n"
-                          "layout (location = 0) in vec3 position;                              \n"
-                          "layout (location = 1) in vec3 normal;                                \n"
-                          "layout (location = 2) in vec2 uv;                                    \n"
-                          "                                                                     \n"
-                          "                                                                     \n"
-                          "layout(binding = 0) uniform UniformBufferObject                      \n"
-                          "{                                                                    \n"
-                          "    mat4 viewProjection;                                             \n"
-                          "} ubo;                                                               \n"
-                          "                                                                     \n"
-                          "                                                                     \n"
-                          "layout( push_constant ) uniform PushConstants                        \n"
-                          "{                                                                    \n"
-                          "    mat4 model;                                                      \n"
-                          "} constants;                                                         \n"
-                          "                                                                     \n"
-                          "layout (location = 0) out vec3 worldPosition;                        \n"
-                          "layout (location = 1) out vec3 worldNormal;                          \n"
-                          "layout (location = 2) out vec2 uvFragment;                           \n"
-                          "                                                                     \n"
-                          "void main()                                                          \n"
-                          "{                                                                    \n"
-                          "    worldPosition = vec3(constants.model * vec4(position, 1.0f));    \n"
-                          "    worldNormal = mat3(transpose(inverse(constants.model))) * normal;\n"
-                          "    uvFragment = uv;                                                 \n"
-                          "	                                                                    \n"
-                          "	   gl_Position = ubo.viewProjection * vec4(worldPosition, 1.0f);    \n"
-                          "}                                                                    \n";
-
-        String fragCode = "#version 460                                                       \n"
-                          "#extension GL_EXT_nonuniform_qualifier : require                   \n"
-                          "                                                                   \n"
-                          "layout (location = 0) in vec3 worldPosition;                       \n"
-                          "layout (location = 1) in vec3 worldNormal;                         \n"
-                          "layout (location = 2) in vec2 uvFragment;                          \n"
-                          "                                                                   \n"
-                          "layout(set = 1, binding = 0) uniform sampler2D Albedo;             \n"
-                          "                                                                   \n"
-                          "layout (location = 0) out vec4 color;                              \n"
-                          "                                                                   \n"
-                          "void main()                                                        \n"
-                          "{                                                                  \n"
-                          "    const vec3 lightColor = vec3(1.0f, 1.0f, 1.0f);                \n"
-                          "    vec3 lightPosition = vec3(10.0f, 50.0f, 10.0f);                \n"
-                          "    vec4 objectColor = texture(Albedo, uvFragment);                \n"
-                          "    if (objectColor.w < 0.1f)                                      \n"
-                          "    {                                                              \n"
-                          "        discard;                                                   \n"
-                          "    }                                                              \n"
-                          "                                                                   \n"
-                          "    // ambient                                                     \n"
-                          "    float ambientStrength = 0.5f;                                  \n"
-                          "    vec3 ambient = ambientStrength * lightColor;                   \n"
-                          "    // diffuse                                                     \n"
-                          "    vec3 normal = normalize(worldNormal);                          \n"
-                          "    vec3 lightDirection = normalize(lightPosition - worldPosition);\n"
-                          "    float diff = max(dot(normal, lightDirection), 0.0f);           \n"
-                          "    vec3 diffuse = diff * lightColor;                              \n"
-                          "                                                                   \n"
-                          "    color = vec4((ambient + diffuse) * objectColor.xyz, 1.0f);     \n"
-                          "}                                                                  \n";
-
-
-        ShaderSet defaultSet;
-        //Shaders should be created after logical device
-        defaultSet.shaderHandles.push_back(create_shader("Default", vertCode, EShaderType::Vertex));
-        defaultSet.shaderHandles.push_back(create_shader("Default", fragCode, EShaderType::Fragment));
+        ShaderPermutations defaultSet;
+        // Sources are in Render/Vulkan/Shaders, every used variant is compiled to SPIR-V at build time
+        defaultSet.descriptions = {
+            { "Builtin/Default.vert", "", EShaderType::Vertex },
+            { "Builtin/Default.frag", "", EShaderType::Fragment }
+        };
+        defaultSet.keywords = { { ALPHA_TEST_KEYWORD, { EShaderType::Fragment } } };
 
         swapchain.create(logicalDevice,
                          physicalDevice,
                          surface, 
                          simulation.displayManager.get_framebuffer_size(), 
                          nullptr);
+        create_present_semaphores();
 
         defaultSet.renderPassHandle = create_render_pass(physicalDevice.get_max_samples());
         defaultSet.descriptorPoolHandle = create_descriptor_pool();
-        create_default_descriptors();
-
-        defaultSet.pipelineHandle = create_pipeline(defaultSet);
-        simulation.resourceManager.get_default_material().shaderSetHandle = create_shader_set(defaultSet);
+        defaultSet.layoutNames = { FRAME_LAYOUT_NAME, TEXTURE_LAYOUT_NAME };
+        defaultSet.bindingFlags = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT;
+
+        //Shaders should be created after logical device, variants are compiled when materials need them
+        defaultPermutations = create_shader_permutations(defaultSet);
+        // Variant with every keyword uses all resources, so layouts reflected from it fit other variants
+        get_shader_variant(simulation, defaultPermutations, Limits<UInt64>::max());
+        assign_material_variant(simulation, simulation.resourceManager.get_default_material());
         create_model_render_data(simulation, simulation.resourceManager.get_default_model());
         setup_default_descriptors(simulation);
     }
+
+    const PipelineCacheStatistics cacheStatistics = pipelineCache.get_statistics();
+    SPDLOG_INFO("Startup created {} pipelines in {:.3f} ms, pipeline cache loaded {} bytes.",
+                cacheStatistics.pipelinesCount,
+                cacheStatistics.creationMilliseconds,
+                cacheStatistics.loadedBytes);
+    const SpirvCacheStatistics spirvStatistics = spirvCache.get_statistics();
+    SPDLOG_INFO("SPIR-V cache: {} hits, {} misses.", spirvStatistics.hitsCount, spirvStatistics.missesCount);
+    SPDLOG_INFO("SPIR-V compiled {} shaders in {:.3f} ms, {} bytes generated, {} bytes after remapping.",
+                spirvStatistics.compiledCount,
+                spirvStatistics.compileMilliseconds,
+                spirvStatistics.generatedBytes,
+                spirvStatistics.finalBytes);
+    SPDLOG_INFO("Descriptor layouts: {} created for {} requests.",
+                descriptorLayoutCache.get_layouts_count(),
+                descriptorLayoutCache.get_requests_count());
+    const PipelineStateStatistics stateStatistics = pipelineStateCache.get_statistics();
+    SPDLOG_INFO("Pipeline states: {} created, {} of {} requests reused, {:.3f} ms of creation avoided.",
+                stateStatistics.createdCount,
+                stateStatistics.hitsCount,
+                stateStatistics.requestsCount,
+                stateStatistics.avoidedMilliseconds);
+
+    // Built-in shaders are embedded, so glslang is initialized only when other shaders miss SPIR-V cache
+    const auto startupEnd = std::chrono::steady_clock::now();
+    SPDLOG_INFO("Startup took {:.3f} ms, glslang {}.",
+                Float64(std::chrono::duration_cast<std::chrono::nanoseconds>(startupEnd - startupBegin).count()) / 1'000'000.0,
+                Shader::s_is_compiler_initialized() ? "was initialized" : "was not needed");
 }
 
-Void Vulkan::draw_model(Simulation<Vulkan>& simulation, const Model<Vulkan>& model)
+Bool Vulkan::begin_frame(Simulation<Vulkan>& simulation)
 {
-    const VkFence renderFence = get_fence(inFlightFence);
-    logicalDevice.wait_for_fence(renderFence, true);
-    logicalDevice.reset_fence(renderFence);
+    if (isFrameStarted)
+    {
+        SPDLOG_ERROR("Frame has been already started.");
+        return false;
+    }
 
-    CommandBuffer commandBuffer = get_command_buffer("DefaultCommandBuffer");
-    const UVector2& extent = swapchain.get_extent();
-    VkSemaphore imageSemaphore = get_semaphore(imageAvailable);
-    VkResult result = logicalDevice.acquire_next_image(swapchain, imageSemaphore);
+    // Waits only for frame which used these resources, newer frames could still be executed
+    FrameResources& frame = frames[frameIndex];
+    queueTimeline.wait(logicalDevice, EQueueType::Graphics, frame.submittedValue);
+
+    const VkResult result = logicalDevice.acquire_next_image(swapchain, get_semaphore(frame.imageAvailable));
     if (result == VK_ERROR_OUT_OF_DATE_KHR)
     {
         recreate_swapchain(simulation);
-        return;
+        return false;
     }
+    release_staging_buffers();
+    // Handles are swapped only here, so recording threads see the same pipelines for whole frame
+    update_pending_pipelines();
+    update_pending_reloads();
+    release_retired_pipelines();
 
     {
         UniformBufferObject ubo{};
-        const FMatrix4 projectionMatrix = glm::perspective(glm::radians(70.0f),
-                                                           simulation.displayManager.get_aspect_ratio(),
-                                                           0.001f,
-                                                           5000.0f);
-        const FMatrix4 viewMatrix = glm::lookAt(FVector3{ 0.0f, 0.0f, -10.0f },
-                                                FVector3{ 0.0f, 0.0f, 0.0f },
-                                                FVector3{ 0.0f, 1.0f, 0.0f });
-        ubo.viewProjection = projectionMatrix * viewMatrix;
+        ubo.viewProjection = simulation.renderManager.get_view_projection();
 
-        get_buffer("DefaultUniformBuffer").update_dynamic_buffer(ubo);
+        get_buffer(frame.uniformBuffer).update_dynamic_buffer(ubo);
     }
+    frame.instancesCount = 0;
 
-    ResourceManager<Vulkan>& resourceManager = simulation.resourceManager;
-    for (UInt64 i = 0; i < model.meshes.size(); ++i)
+    // Pools are reset as a whole, it is cheaper than resetting every secondary buffer
+    for (UInt32 i = 0; i < frame.usedRecordingBuffersCount; ++i)
     {
-        const Mesh<Vulkan>& mesh = resourceManager.get_mesh(model.meshes[i]);
-        const Material<Vulkan>& material = resourceManager.get_material(model.materials[i]);
-        ShaderSet& shaderSet = get_shader_set(material.shaderSetHandle);
-        Pipeline& pipeline = get_pipeline(shaderSet.pipelineHandle);
-        RenderPass& renderPass = get_render_pass(shaderSet.renderPassHandle);
-        DescriptorPool& descriptorPool = get_descriptor_pool(shaderSet.descriptorPoolHandle);
-
-        commandBuffer.reset(0);
-        commandBuffer.begin();
-        commandBuffer.begin_render_pass(renderPass,
-                                        swapchain,
-                                        swapchain.get_image_index(),
-                                        VK_SUBPASS_CONTENTS_INLINE);
-        commandBuffer.bind_pipeline(pipeline);
-
-        commandBuffer.set_viewport(0, { 0.0f, 0.0f }, extent, { 0.0f, 1.0f });
-        commandBuffer.set_scissor(0, { 0, 0 }, extent);
-
-        DescriptorResourceInfo textureResource;
-        VkDescriptorImageInfo& textureInfo = textureResource.imageInfos.emplace_back();
-        Texture<Vulkan> albedoTexture = resourceManager.get_texture(material[ETextureType::Albedo]);
-        const Image& albedo = get_image(albedoTexture.imageHandle);
-        textureInfo.imageLayout = albedo.get_current_layout();
-        textureInfo.imageView = albedo.get_view();
-        textureInfo.sampler = albedo.get_sampler();
-
-        descriptorPool.update_set(logicalDevice, 
-                                  textureResource,
-                                  "Texture", 
-                                  0, 
-                                  0);
-
-        const DescriptorSetData& uniformSet = descriptorPool.get_set_data("Uniforms");
-        commandBuffer.bind_descriptor_set(pipeline, uniformSet.set, uniformSet.setNumber);
-
-        const DescriptorSetData& textureSet = descriptorPool.get_set_data("Texture");
-        commandBuffer.bind_descriptor_set(pipeline, textureSet.set, textureSet.setNumber);
-    
+        vkResetCommandPool(logicalDevice.get_device(), get_command_pool(frame.recordingPools[i]), 0);
+    }
+    frame.usedRecordingBuffersCount = 0;
 
-        const VkBuffer vertexesBuffer = get_buffer(mesh.vertexesHandle).get_buffer();
-        const VkBuffer indexesBuffer = get_buffer(mesh.indexesHandle).get_buffer();
-        
-        commandBuffer.bind_vertex_buffers<1>(0, { vertexesBuffer }, { 0 });
-        commandBuffer.bind_index_buffer(indexesBuffer, 0, VK_INDEX_TYPE_UINT32);
+    // All shader sets are drawn to swapchain with the same render pass for now
+    const Handle<ShaderSet> defaultShaderSet = simulation.resourceManager.get_default_material().shaderSetHandle;
+    frameRenderPass = get_shader_set(defaultShaderSet).renderPassHandle;
 
-        VertexConstants vertexConstants{};
-        static Float32 rot = 0.0f;
-        vertexConstants.model = glm::rotate(FMatrix4(1.0f), 
-                                            glm::radians(rot), 
-                                            {0.0f, 1.0f, 0.0f});
-        rot += 0.01f;
+    const CommandBuffer& commandBuffer = get_command_buffer(frame.commandBuffer);
+    commandBuffer.reset(0);
+    commandBuffer.begin();
+    commandBuffer.begin_render_pass(get_render_pass(frameRenderPass),
+                                    swapchain,
+                                    swapchain.get_image_index(),
+                                    VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
 
-        commandBuffer.set_constants(pipeline,
-                                    VK_SHADER_STAGE_VERTEX_BIT,
-                                    0,
-                                    sizeof(vertexConstants),
-                                    &vertexConstants);
+    isFrameStarted = true;
+    return true;
+}
 
+Void Vulkan::draw_queue(Simulation<Vulkan>& simulation, RenderQueue& queue)
+{
+    if (!isFrameStarted)
+    {
+        SPDLOG_ERROR("Queue can not be drawn outside of frame.");
+        return;
+    }
 
-        commandBuffer.draw_indexed(UInt32(mesh.indexes.size()),
-                                   1,
-                                   0,
-                                   0,
-                                   0);
-    
+    FrameResources& frame = frames[frameIndex];
+    RenderQueueStatistics& statistics = queue.get_statistics();
 
-        commandBuffer.end_render_pass();
-        commandBuffer.end();
+    // Transforms are appended after ones of queues drawn earlier in this frame
+    const DynamicArray<FMatrix4>& instanceTransforms = queue.get_instance_transforms();
+    const UInt32 firstInstance = frame.instancesCount;
+    const UInt32 instancesCount = std::min(UInt32(instanceTransforms.size()), MAX_INSTANCES_COUNT - firstInstance);
+    if (instancesCount < instanceTransforms.size())
+    {
+        SPDLOG_WARN("Instances limit {} exceeded, {} instances skipped.",
+                    MAX_INSTANCES_COUNT,
+                    instanceTransforms.size() - instancesCount);
+    }
+    get_buffer(frame.instanceBuffer).update_dynamic_buffer(instanceTransforms.data(),
+                                                           instancesCount * sizeof(FMatrix4),
+                                                           firstInstance * sizeof(FMatrix4));
+    frame.instancesCount += instancesCount;
+
+    const DynamicArray<DrawBatch>& batches = queue.get_batches();
+    UInt64 batchesCount = batches.size();
+    while (batchesCount > 0 && batches[batchesCount - 1].firstInstance >= instancesCount)
+    {
+        --batchesCount;
+    }
+    if (batchesCount == 0)
+    {
+        return;
+    }
+
+    ThreadPool& threadPool = simulation.threadPool;
+    const UInt64 maxSlicesCount = UInt64(threadPool.get_threads_count()) + 1;
+    const UInt64 slicesCount = std::clamp((batchesCount + MIN_BATCHES_PER_SLICE - 1) / MIN_BATCHES_PER_SLICE,
+                                          UInt64(1),
+                                          maxSlicesCount);
+    const UInt64 sliceSize = (batchesCount + slicesCount - 1) / slicesCount;
+    const UInt32 firstBuffer = frame.usedRecordingBuffersCount;
+    reserve_recording_buffers(frame, firstBuffer + UInt32(slicesCount));
+    frame.usedRecordingBuffersCount += UInt32(slicesCount);
+
+    // Every slice counts own statistics, so threads do not write to the same counters
+    DynamicArray<RenderQueueStatistics> slicesStatistics(slicesCount);
+    const auto recordSlice = [&](UInt64 slice)
+    {
+        const UInt64 beginBatch = slice * sliceSize;
+        const UInt64 endBatch = std::min(beginBatch + sliceSize, batchesCount);
+        record_batches(simulation,
+                       get_command_buffer(frame.recordingBuffers[firstBuffer + slice]),
+                       frame,
+                       batches,
+                       beginBatch,
+                       endBatch,
+                       firstInstance,
+                       instancesCount,
+                       slicesStatistics[slice]);
+    };
+
+    DynamicArray<std::future<Void>> futures;
+    futures.reserve(slicesCount - 1);
+    for (UInt64 slice = 1; slice < slicesCount; ++slice)
+    {
+        futures.push_back(threadPool.submit([&recordSlice, slice]() { recordSlice(slice); }));
+    }
+    recordSlice(0);
+    for (std::future<Void>& future : futures)
+    {
+        threadPool.wait(future);
+    }
+
+    for (const RenderQueueStatistics& sliceStatistics : slicesStatistics)
+    {
+        statistics.drawsCount         += sliceStatistics.drawsCount;
+        statistics.instancesCount     += sliceStatistics.instancesCount;
+        statistics.pipelineBindsCount += sliceStatistics.pipelineBindsCount;
+        statistics.pipelineBindsSaved += sliceStatistics.pipelineBindsSaved;
+        statistics.materialBindsCount += sliceStatistics.materialBindsCount;
+        statistics.materialBindsSaved += sliceStatistics.materialBindsSaved;
+        statistics.meshBindsCount     += sliceStatistics.meshBindsCount;
+        statistics.meshBindsSaved     += sliceStatistics.meshBindsSaved;
+        statistics.fallbackDrawsCount += sliceStatistics.fallbackDrawsCount;
+        statistics.skippedDrawsCount  += sliceStatistics.skippedDrawsCount;
+    }
+}
+
+Void Vulkan::end_frame(Simulation<Vulkan>& simulation)
+{
+    if (!isFrameStarted)
+    {
+        SPDLOG_ERROR("Frame can not be ended before it started.");
+        return;
+    }
+    isFrameStarted = false;
+
+    FrameResources& frame = frames[frameIndex];
+    const CommandBuffer& commandBuffer = get_command_buffer(frame.commandBuffer);
+    if (frame.usedRecordingBuffersCount > 0)
+    {
+        DynamicArray<VkCommandBuffer> secondaryBuffers;
+        secondaryBuffers.reserve(frame.usedRecordingBuffersCount);
+        for (UInt32 i = 0; i < frame.usedRecordingBuffersCount; ++i)
+        {
+            secondaryBuffers.push_back(get_command_buffer(frame.recordingBuffers[i]).get_buffer());
+        }
+        commandBuffer.execute_commands(secondaryBuffers);
+    }
+    commandBuffer.end_render_pass();
+    commandBuffer.end();
+
+    // Only stages which could read compute results wait, so async compute overlaps with rest of frame.
+    // Finished compute value is skipped by timeline
+    const TimelineWait computeWait = { EQueueType::Compute,
+                                       computeValues[UInt64(EComputeQueue::Async)],
+                                       VK_PIPELINE_STAGE_VERTEX_INPUT_BIT
+                                       | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT
+                                       | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT };
+    const VkSemaphore renderSemaphore = get_semaphore(renderFinished[swapchain.get_image_index()]);
+    frame.submittedValue = queueTimeline.submit(logicalDevice,
+                                                EQueueType::Graphics,
+                                                { commandBuffer.get_buffer() },
+                                                { computeWait },
+                                                get_semaphore(frame.imageAvailable),
+                                                VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                                                renderSemaphore);
+
+    const VkResult result = logicalDevice.submit_present_queue(renderSemaphore, swapchain);
+    if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR)
+    {
+        recreate_swapchain(simulation);
+    }
+
+    frameIndex = (frameIndex + 1) % framesInFlight;
+}
+
+Void Vulkan::record_batches(Simulation<Vulkan>& simulation,
+                            const CommandBuffer& commandBuffer,
+                            const FrameResources& frame,
+                            const DynamicArray<DrawBatch>& batches,
+                            UInt64 beginBatch,
+                            UInt64 endBatch,
+                            UInt32 firstInstance,
+                            UInt32 instancesCount,
+                            RenderQueueStatistics& statistics)
+{
+    const RenderPass& renderPass = get_render_pass(frameRenderPass);
+    VkCommandBufferInheritanceInfo inheritanceInfo{};
+    inheritanceInfo.sType       = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    inheritanceInfo.renderPass  = renderPass.get_render_pass();
+    inheritanceInfo.subpass     = 0;
+    inheritanceInfo.framebuffer = renderPass.get_framebuffer(swapchain.get_image_index());
+
+    // Dynamic state is not inherited from primary buffer
+    const UVector2& extent = swapchain.get_extent();
+    commandBuffer.begin(VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+                        &inheritanceInfo);
+    commandBuffer.set_viewport(0, { 0.0f, 0.0f }, extent, { 0.0f, 1.0f });
+    commandBuffer.set_scissor(0, { 0, 0 }, extent);
+
+    ResourceManager<Vulkan>& resourceManager = simulation.resourceManager;
+    UInt64 boundShaderSet = Limits<UInt64>::max();
+    UInt64 boundMaterial  = Limits<UInt64>::max();
+    UInt64 boundMesh      = Limits<UInt64>::max();
+    Pipeline* pipeline = nullptr;
+    DescriptorPool* descriptorPool = nullptr;
+    Bool isFallback = false;
+    Bool isSkipped  = false;
+    for (UInt64 i = beginBatch; i < endBatch; ++i)
+    {
+        const DrawBatch& batch = batches[i];
+        if (batch.shaderSetId != boundShaderSet)
+        {
+            boundShaderSet = batch.shaderSetId;
+            const ShaderSet* shaderSet = &get_shader_set({ batch.shaderSetId });
+            // Pipeline is still created on worker thread, so set it falls back to is drawn instead
+            isFallback = !get_pipeline(shaderSet->pipelineHandle).is_ready()
+                         && shaderSet->fallbackHandle.id != Handle<ShaderSet>::NONE.id;
+            if (isFallback)
+            {
+                shaderSet = &get_shader_set(shaderSet->fallbackHandle);
+            }
+
+            Pipeline* nextPipeline = &get_pipeline(shaderSet->pipelineHandle);
+            isSkipped = !nextPipeline->is_ready();
+            if (isSkipped)
+            {
+                statistics.skippedDrawsCount++;
+                continue;
+            }
+
+            DescriptorPool* nextDescriptorPool = &get_descriptor_pool(shaderSet->descriptorPoolHandle);
+            pipeline = nextPipeline;
+            commandBuffer.bind_pipeline(*pipeline);
 
-        const VkSemaphore renderSemaphore = get_semaphore(renderFinished);
-        logicalDevice.submit_graphics_queue(imageSemaphore,
-                                            VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
-                                            commandBuffer.get_buffer(),
-                                            renderSemaphore,
-                                            renderFence);
+            // Pipelines of one pool share set layouts from cache, so sets bound before stay valid
+            if (nextDescriptorPool != descriptorPool)
+            {
+                descriptorPool = nextDescriptorPool;
+                const DescriptorSetData& uniformSet = descriptorPool->get_set_data(frame.uniformSetName);
+                const DescriptorSetData& textureSet = descriptorPool->get_set_data(TEXTURES_SET_NAME);
+                commandBuffer.bind_descriptor_set(*pipeline, uniformSet.set, uniformSet.setNumber);
+                commandBuffer.bind_descriptor_set(*pipeline, textureSet.set, textureSet.setNumber);
+                boundMaterial = Limits<UInt64>::max();
+            }
 
-        const VkResult result = logicalDevice.submit_present_queue(renderSemaphore, swapchain);
-        if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR)
+            statistics.pipelineBindsCount++;
+        } else if (isSkipped) {
+            statistics.skippedDrawsCount++;
+            continue;
+        } else {
+            statistics.pipelineBindsSaved++;
+        }
+
+        if (batch.materialId != boundMaterial)
+        {
+            // Textures set stays bound, material only selects its slot
+            const DynamicArray<VkPushConstantRange>& pushConstants = descriptorPool->get_push_constants();
+            if (!pushConstants.empty())
+            {
+                const UInt32 albedoSlot = get_texture_slot(simulation, batch.materialId);
+                commandBuffer.set_constants(*pipeline, pushConstants[0].stageFlags, 0, sizeof(albedoSlot), &albedoSlot);
+            }
+            boundMaterial = batch.materialId;
+            statistics.materialBindsCount++;
+        } else {
+            statistics.materialBindsSaved++;
+        }
+
+        const Mesh<Vulkan>& mesh = resourceManager.get_mesh(Handle<Mesh<Vulkan>>{ batch.meshId });
+        if (batch.meshId != boundMesh)
+        {
+            const VkBuffer vertexesBuffer = get_buffer(mesh.vertexesHandle).get_buffer();
+            const VkBuffer indexesBuffer = get_buffer(mesh.indexesHandle).get_buffer();
+
+            commandBuffer.bind_vertex_buffers<1>(0, { vertexesBuffer }, { 0 });
+            commandBuffer.bind_index_buffer(indexesBuffer, 0, VK_INDEX_TYPE_UINT32);
+            boundMesh = batch.meshId;
+            statistics.meshBindsCount++;
+        } else {
+            statistics.meshBindsSaved++;
+        }
+
+        // Shader reads transform of instance from storage buffer with gl_InstanceIndex
+        const UInt32 batchInstancesCount = std::min(batch.instancesCount, instancesCount - batch.firstInstance);
+        commandBuffer.draw_indexed(UInt32(mesh.indexes.size()),
+                                   batchInstancesCount,
+                                   0,
+                                   0,
+                                   firstInstance + batch.firstInstance);
+        statistics.drawsCount++;
+        statistics.instancesCount += batchInstancesCount;
+        if (isFallback)
         {
-            recreate_swapchain(simulation);
+            statistics.fallbackDrawsCount++;
         }
     }
 
-    isFrameEven = !isFrameEven;
+    commandBuffer.end();
 }
 
 Handle<Vulkan::Shader> Vulkan::create_shader(const String& filePath, const EShaderType shaderType, const String& functionName)
@@ -253,7 +432,7 @@ Handle<Vulkan::Shader> Vulkan::create_shader(const String& filePath, const EShad
     const UInt64 shaderId = shaders.size();
     Shader& shader = shaders.emplace_back();
 
-    shader.create(filePath, functionName, shaderType, logicalDevice, nullptr);
+    shader.create(filePath, functionName, shaderType, logicalDevice, spirvCache, nullptr);
 
     const Handle<Shader> handle{ shaderId };
     auto iterator = shadersNameMap.find(shader.get_name());
@@ -265,6 +444,7 @@ Handle<Vulkan::Shader> Vulkan::create_shader(const String& filePath, const EShad
     }
 
     shadersNameMap[shader.get_name()] = handle;
+    register_dependencies(handle);
 
     return handle;
 }
@@ -274,7 +454,7 @@ Handle<Vulkan::Shader> Vulkan::create_shader(const String& shaderName, const Str
     const UInt64 shaderId = shaders.size();
     Shader& shader = shaders.emplace_back();
 
-    shader.create(shaderName, shaderCode, functionName, shaderType, logicalDevice, nullptr);
+    shader.create(shaderName, shaderCode, functionName, shaderType, logicalDevice, spirvCache, nullptr);
 
     const Handle<Shader> handle{ shaderId };
     auto iterator = shadersNameMap.find(shader.get_name());
@@ -286,17 +466,90 @@ Handle<Vulkan::Shader> Vulkan::create_shader(const String& shaderName, const Str
     }
 
     shadersNameMap[shader.get_name()] = handle;
+    register_dependencies(handle);
 
     return handle;
 }
 
-Handle<Vulkan::Pipeline> Vulkan::create_pipeline(const ShaderSet& shaderSet)
+DynamicArray<Handle<Vulkan::Shader>> Vulkan::create_shaders(Simulation<Vulkan>& simulation, const DynamicArray<ShaderDescription>& descriptions)
 {
-    Handle<Pipeline> handle = { pipelines.size() };
-    Pipeline& pipeline = pipelines.emplace_back();
+    // Workers fill own array, so shaders are not reallocated while they are compiled
+    DynamicArray<Shader> preparedShaders(descriptions.size());
+    DynamicArray<UInt8> arePrepared(descriptions.size(), 0);
+    ThreadPool& threadPool = simulation.threadPool;
 
-    const DescriptorPool& descriptorPool = get_descriptor_pool(shaderSet.descriptorPoolHandle);
+    // One task per shader, compilation time differs too much between shaders for equal ranges
+    DynamicArray<std::future<Void>> futures;
+    futures.reserve(descriptions.size());
+    for (UInt64 i = 0; i < descriptions.size(); ++i)
+    {
+        futures.push_back(threadPool.submit([this, &preparedShaders, &arePrepared, &descriptions, i]()
+        {
+            arePrepared[i] = preparedShaders[i].prepare(descriptions[i], spirvCache);
+        }));
+    }
+    for (std::future<Void>& future : futures)
+    {
+        threadPool.wait(future);
+    }
+
+    DynamicArray<Handle<Shader>> handles;
+    handles.reserve(descriptions.size());
+    shaders.reserve(shaders.size() + descriptions.size());
+    for (UInt64 i = 0; i < preparedShaders.size(); ++i)
+    {
+        Shader& preparedShader = preparedShaders[i];
+        // Variants share stages which none of their keywords is defined in
+        auto iterator = shadersNameMap.find(preparedShader.get_name());
+        if (iterator != shadersNameMap.end())
+        {
+            handles.push_back(iterator->second);
+            continue;
+        }
+
+        const Handle<Shader> handle{ shaders.size() };
+        Shader& shader = shaders.emplace_back(std::move(preparedShader));
+        if (arePrepared[i])
+        {
+            shader.create_module(logicalDevice, nullptr);
+        }
+
+        shadersNameMap[shader.get_name()] = handle;
+        register_dependencies(handle);
+        handles.push_back(handle);
+    }
+
+    return handles;
+}
+
+Handle<Vulkan::Pipeline> Vulkan::create_pipeline(const ShaderSet& shaderSet, ThreadPool* threadPool)
+{
+    DescriptorPool& descriptorPool = get_descriptor_pool(shaderSet.descriptorPoolHandle);
+    if (!descriptorPool.has_layouts())
+    {
+        create_reflected_layouts(descriptorPool, shaderSet.shaderHandles, {}, 0);
+    }
     const RenderPass& renderPass = get_render_pass(shaderSet.renderPassHandle);
+
+    // Shaders are unique by name with defines and constants, so handles identify stages fully
+    DynamicArray<UInt64> state;
+    state.push_back(UInt64(EPipelineType::Graphics));
+    state.push_back(shaderSet.shaderHandles.size());
+    for (const Handle<Shader> shaderHandle : shaderSet.shaderHandles)
+    {
+        state.push_back(shaderHandle.id);
+    }
+    Pipeline::s_describe_graphics_state(descriptorPool, renderPass, state);
+
+    const Handle<Pipeline> cachedHandle = pipelineStateCache.find(state);
+    if (cachedHandle.id != Handle<Pipeline>::NONE.id)
+    {
+        return cachedHandle;
+    }
+
+    const auto begin = std::chrono::steady_clock::now();
+    Handle<Pipeline> handle = { pipelines.size() };
+    Pipeline& pipeline = pipelines.emplace_back();
     DynamicArray<Shader> pipelineShaders;
     pipelineShaders.reserve(shaderSet.shaderHandles.size());
     for (const Handle<ShaderVK> shaderHandle : shaderSet.shaderHandles)
@@ -304,15 +557,99 @@ Handle<Vulkan::Pipeline> Vulkan::create_pipeline(const ShaderSet& shaderSet)
         pipelineShaders.push_back(get_shader(shaderHandle));
     }
 
-    pipeline.create_graphics_pipeline(descriptorPool,
-                                      renderPass,
-                                      pipelineShaders,
-                                      logicalDevice,
-                                      nullptr);
+    if (threadPool)
+    {
+        // Pool and render pass are copied, their arrays could grow before worker starts,
+        // background thread keeps creation away from threads that frame waits for
+        PendingPipeline& pendingPipeline = pendingPipelines.emplace_back();
+        pendingPipeline.handle = handle;
+        pendingPipeline.state  = state;
+        pendingPipeline.future = threadPool->submit_background([this,
+                                                                descriptorPool,
+                                                                renderPass,
+                                                                shaders = std::move(pipelineShaders)]()
+        {
+            Pipeline createdPipeline;
+            createdPipeline.create_graphics_pipeline(descriptorPool,
+                                                     renderPass,
+                                                     shaders,
+                                                     logicalDevice,
+                                                     pipelineCache,
+                                                     nullptr);
+            return createdPipeline;
+        });
+        pipelineStateCache.insert(state, handle, 0);
+        asyncPipelinesCount++;
+    } else {
+        pipeline.create_graphics_pipeline(descriptorPool,
+                                          renderPass,
+                                          pipelineShaders,
+                                          logicalDevice,
+                                          pipelineCache,
+                                          nullptr);
+        pipelineStateCache.insert(state, handle, pipeline.get_creation_nanoseconds());
+    }
+    const auto end = std::chrono::steady_clock::now();
+    record_blocking_time(UInt64(std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count()));
 
     return handle;
 }
 
+Void Vulkan::update_pending_pipelines()
+{
+    UInt64 pendingCount = 0;
+    for (UInt64 i = 0; i < pendingPipelines.size(); ++i)
+    {
+        PendingPipeline& pendingPipeline = pendingPipelines[i];
+        if (pendingPipeline.future.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        {
+            if (pendingCount != i)
+            {
+                pendingPipelines[pendingCount] = std::move(pendingPipeline);
+            }
+            pendingCount++;
+            continue;
+        }
+
+        Pipeline createdPipeline = pendingPipeline.future.get();
+        pipelineStateCache.set_creation_time(pendingPipeline.state, createdPipeline.get_creation_nanoseconds());
+
+        // Reload of the same set finished first and installed pipeline from newer shaders,
+        // placeholder is never drawn, so created pipeline was never bound and is destroyed now
+        Pipeline& pipeline = pipelines[pendingPipeline.handle.id];
+        if (pipeline.is_ready())
+        {
+            createdPipeline.clear(logicalDevice, nullptr);
+            continue;
+        }
+        pipeline = createdPipeline;
+    }
+    pendingPipelines.resize(pendingCount);
+}
+
+Void Vulkan::wait_pending_pipelines()
+{
+    if (pendingPipelines.empty())
+    {
+        return;
+    }
+
+    const auto begin = std::chrono::steady_clock::now();
+    for (PendingPipeline& pendingPipeline : pendingPipelines)
+    {
+        pendingPipeline.future.wait();
+    }
+    update_pending_pipelines();
+    const auto end = std::chrono::steady_clock::now();
+    record_blocking_time(UInt64(std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count()));
+}
+
+Void Vulkan::record_blocking_time(UInt64 nanoseconds)
+{
+    pipelinesBlockingNanoseconds += nanoseconds;
+    maxPipelineBlockingNanoseconds = std::max(maxPipelineBlockingNanoseconds, nanoseconds);
+}
+
 Handle<Vulkan::ShaderSet> Vulkan::create_shader_set(const ShaderSet& shaderSet)
 {
     const UInt64 shaderSetId = shaderSets.size();
@@ -321,13 +658,319 @@ Handle<Vulkan::ShaderSet> Vulkan::create_shader_set(const ShaderSet& shaderSet)
     return handle;
 }
 
+Handle<Vulkan::ShaderPermutations> Vulkan::create_shader_permutations(const ShaderPermutations& permutations)
+{
+    if (permutations.keywords.size() > MAX_SHADER_KEYWORDS_COUNT)
+    {
+        SPDLOG_ERROR("Shader permutations support up to {} keywords, got {}.",
+                     MAX_SHADER_KEYWORDS_COUNT,
+                     permutations.keywords.size());
+        return Handle<ShaderPermutations>::NONE;
+    }
+
+    const Handle<ShaderPermutations> handle{ shaderPermutations.size() };
+    ShaderPermutations& createdPermutations = shaderPermutations.emplace_back(permutations);
+    createdPermutations.variants.clear();
+    createdPermutations.fallbackHandle = Handle<ShaderSet>::NONE;
+    return handle;
+}
+
+UInt64 Vulkan::get_variant_key(Handle<ShaderPermutations> handle, const DynamicArray<String>& enabledKeywords)
+{
+    const ShaderPermutations& permutations = get_shader_permutations(handle);
+    UInt64 variantKey = 0;
+    for (const String& keyword : enabledKeywords)
+    {
+        const auto iterator = std::find_if(permutations.keywords.begin(),
+                                           permutations.keywords.end(),
+                                           [&keyword](const ShaderKeyword& declared) { return declared.name == keyword; });
+        if (iterator == permutations.keywords.end())
+        {
+            SPDLOG_WARN("Shader keyword {} is not declared, it is ignored.", keyword);
+            continue;
+        }
+        variantKey |= 1ULL << UInt64(iterator - permutations.keywords.begin());
+    }
+    return variantKey;
+}
+
+Handle<Vulkan::ShaderSet> Vulkan::get_shader_variant(Simulation<Vulkan>& simulation, Handle<ShaderPermutations> handle, UInt64 variantKey)
+{
+    ShaderPermutations& permutations = get_shader_permutations(handle);
+    const UInt64 keywordsCount = permutations.keywords.size();
+    const UInt64 allKeywordsKey = keywordsCount < MAX_SHADER_KEYWORDS_COUNT
+                                ? (1ULL << keywordsCount) - 1ULL
+                                : Limits<UInt64>::max();
+    variantKey &= allKeywordsKey;
+
+    const auto iterator = permutations.variants.find(variantKey);
+    if (iterator != permutations.variants.end())
+    {
+        return iterator->second;
+    }
+
+    // Fallback has to contain every feature of variants drawn with it, so variant with all keywords is created first
+    if (permutations.variants.empty() && variantKey != allKeywordsKey)
+    {
+        get_shader_variant(simulation, handle, allKeywordsKey);
+    }
+
+    DynamicArray<ShaderDescription> descriptions = permutations.descriptions;
+    for (ShaderDescription& description : descriptions)
+    {
+        for (UInt64 i = 0; i < keywordsCount; ++i)
+        {
+            const DynamicArray<EShaderType>& stages = permutations.keywords[i].stages;
+            if (((variantKey >> i) & 1ULL)
+                && std::find(stages.begin(), stages.end(), description.type) != stages.end())
+            {
+                description.defines.push_back(permutations.keywords[i].name);
+            }
+        }
+    }
+
+    ShaderSet shaderSet;
+    shaderSet.renderPassHandle     = permutations.renderPassHandle;
+    shaderSet.descriptorPoolHandle = permutations.descriptorPoolHandle;
+    shaderSet.shaderHandles        = create_shaders(simulation, descriptions);
+
+    DescriptorPool& descriptorPool = get_descriptor_pool(permutations.descriptorPoolHandle);
+    if (!descriptorPool.has_layouts())
+    {
+        create_reflected_layouts(descriptorPool,
+                                 shaderSet.shaderHandles,
+                                 permutations.layoutNames,
+                                 permutations.bindingFlags);
+    }
+
+    // First variant is fallback and has nothing to fall back to, so only later ones are created on workers
+    if (permutations.variants.empty())
+    {
+        shaderSet.pipelineHandle = create_pipeline(shaderSet);
+    } else {
+        shaderSet.fallbackHandle = permutations.fallbackHandle;
+        shaderSet.pipelineHandle = create_pipeline(shaderSet, &simulation.threadPool);
+    }
+
+    const Handle<ShaderSet> shaderSetHandle = create_shader_set(shaderSet);
+    if (permutations.variants.empty())
+    {
+        permutations.fallbackHandle = shaderSetHandle;
+    }
+    permutations.variants[variantKey] = shaderSetHandle;
+    return shaderSetHandle;
+}
+
+Handle<Vulkan::ShaderSet> Vulkan::create_compute_shader_set(Handle<Shader> shaderHandle, const DynamicArray<VkDescriptorType>& bindings, UInt32 constantsSize)
+{
+    const Shader& shader = get_shader(shaderHandle);
+    if (shader.get_type() != EShaderType::Compute)
+    {
+        SPDLOG_ERROR("Shader {} is not compute shader.", shader.get_name());
+        return Handle<ShaderSet>::NONE;
+    }
+
+    ShaderSet shaderSet;
+    shaderSet.descriptorPoolHandle = create_descriptor_pool();
+    shaderSet.renderPassHandle     = Handle<RenderPass>::NONE;
+    shaderSet.shaderHandles        = { shaderHandle };
+
+    DescriptorPool& descriptorPool = get_descriptor_pool(shaderSet.descriptorPoolHandle);
+    for (UInt32 i = 0; i < UInt32(bindings.size()); ++i)
+    {
+        descriptorPool.add_binding("ComputeData", 0, i, bindings[i], 1, VK_SHADER_STAGE_COMPUTE_BIT);
+    }
+    if (constantsSize > 0)
+    {
+        VkPushConstantRange range{};
+        range.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        range.size       = constantsSize;
+        descriptorPool.set_push_constants({ range });
+    }
+    descriptorPool.create_layouts(logicalDevice, descriptorLayoutCache, nullptr);
+
+    DynamicArray<UInt64> state = { UInt64(EPipelineType::Compute), shaderHandle.id };
+    Pipeline::s_describe_layout_state(descriptorPool, state);
+    shaderSet.pipelineHandle = pipelineStateCache.find(state);
+    if (shaderSet.pipelineHandle.id == Handle<Pipeline>::NONE.id)
+    {
+        shaderSet.pipelineHandle = { pipelines.size() };
+        Pipeline& pipeline = pipelines.emplace_back();
+        pipeline.create_compute_pipeline(descriptorPool, shader, logicalDevice, pipelineCache, nullptr);
+        pipelineStateCache.insert(state, shaderSet.pipelineHandle, pipeline.get_creation_nanoseconds());
+        record_blocking_time(pipeline.get_creation_nanoseconds());
+    }
+
+    return create_shader_set(shaderSet);
+}
+
+Handle<DescriptorSetData> Vulkan::create_compute_set(Handle<ShaderSet> shaderSetHandle, const DynamicArray<DescriptorResourceInfo>& resources, const String& name)
+{
+    DescriptorPool& descriptorPool = get_descriptor_pool(get_shader_set(shaderSetHandle).descriptorPoolHandle);
+    // Sets are allocated from growth pools, so compute sets can be added at any time
+    return descriptorPool.allocate_set(logicalDevice,
+                                       descriptorPool.get_layout_data_handle("ComputeData"),
+                                       resources,
+                                       name,
+                                       nullptr);
+}
+
+DescriptorResourceInfo Vulkan::get_storage_resource(Handle<Buffer> bufferHandle)
+{
+    DescriptorResourceInfo resource;
+    VkDescriptorBufferInfo& bufferInfo = resource.bufferInfos.emplace_back();
+    bufferInfo.buffer = get_buffer(bufferHandle).get_buffer();
+    bufferInfo.offset = 0;
+    bufferInfo.range  = VK_WHOLE_SIZE;
+    return resource;
+}
+
+DescriptorResourceInfo Vulkan::get_storage_resource(Handle<Image> imageHandle)
+{
+    Image& image = get_image(imageHandle);
+    if (image.get_current_layout() != VK_IMAGE_LAYOUT_GENERAL)
+    {
+        transition_image_layout(image,
+                                VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                                VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                                VK_IMAGE_LAYOUT_GENERAL);
+    }
+
+    DescriptorResourceInfo resource;
+    VkDescriptorImageInfo& imageInfo = resource.imageInfos.emplace_back();
+    imageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+    imageInfo.imageView   = image.get_view();
+    imageInfo.sampler     = image.get_sampler();
+    return resource;
+}
+
+Void Vulkan::begin_compute(EComputeQueue queue)
+{
+    if (recordedComputeQueue != EComputeQueue::Count)
+    {
+        SPDLOG_ERROR("Compute has been already started.");
+        return;
+    }
+    if (queue == EComputeQueue::Count)
+    {
+        SPDLOG_ERROR("Invalid compute queue.");
+        return;
+    }
+
+    // Waits only when previous work of this queue has not finished yet
+    queueTimeline.wait(logicalDevice,
+                       queue == EComputeQueue::Async ? EQueueType::Compute : EQueueType::Graphics,
+                       computeValues[UInt64(queue)]);
+
+    get_command_buffer(computeCommandBuffers[UInt64(queue)]).begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+    recordedComputeQueue = queue;
+}
+
+Void Vulkan::dispatch(Handle<ShaderSet> shaderSetHandle, Handle<DescriptorSetData> setHandle, const UVector3& groupCount, const Void* constants)
+{
+    if (recordedComputeQueue == EComputeQueue::Count)
+    {
+        SPDLOG_ERROR("Dispatch has to be called between begin_compute and end_compute.");
+        return;
+    }
+
+    const ShaderSet& shaderSet = get_shader_set(shaderSetHandle);
+    const Pipeline& pipeline = get_pipeline(shaderSet.pipelineHandle);
+    DescriptorPool& descriptorPool = get_descriptor_pool(shaderSet.descriptorPoolHandle);
+    const CommandBuffer& commandBuffer = get_command_buffer(computeCommandBuffers[UInt64(recordedComputeQueue)]);
+
+    commandBuffer.bind_pipeline(pipeline);
+    commandBuffer.bind_descriptor_set(pipeline, descriptorPool.get_set_data(setHandle).set, 0);
+    if (constants != nullptr && !descriptorPool.get_push_constants().empty())
+    {
+        const VkPushConstantRange& range = descriptorPool.get_push_constants()[0];
+        commandBuffer.set_constants(pipeline, range.stageFlags, range.offset, range.size, constants);
+    }
+    commandBuffer.dispatch(groupCount);
+
+    // Next dispatch could read results of this one
+    commandBuffer.pipeline_memory_barrier(VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                                          VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                                          0,
+                                          VK_ACCESS_SHADER_WRITE_BIT,
+                                          VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+}
+
+Void Vulkan::end_compute()
+{
+    if (recordedComputeQueue == EComputeQueue::Count)
+    {
+        SPDLOG_ERROR("Compute can not be ended before it started.");
+        return;
+    }
+
+    const EComputeQueue queue = recordedComputeQueue;
+    recordedComputeQueue = EComputeQueue::Count;
+    const CommandBuffer& commandBuffer = get_command_buffer(computeCommandBuffers[UInt64(queue)]);
+
+    if (queue == EComputeQueue::Graphics)
+    {
+        // Draws submitted later are ordered after this barrier
+        commandBuffer.pipeline_memory_barrier(VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                                              VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT
+                                              | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT
+                                              | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT
+                                              | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                                              0,
+                                              VK_ACCESS_SHADER_WRITE_BIT,
+                                              VK_ACCESS_INDIRECT_COMMAND_READ_BIT
+                                              | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT
+                                              | VK_ACCESS_INDEX_READ_BIT
+                                              | VK_ACCESS_SHADER_READ_BIT);
+        commandBuffer.end();
+        computeValues[UInt64(queue)] = queueTimeline.submit(logicalDevice,
+                                                            EQueueType::Graphics,
+                                                            { commandBuffer.get_buffer() },
+                                                            {});
+        return;
+    }
+
+    commandBuffer.end();
+    // Compute queue is created from graphics family, so resources do not need ownership transfer.
+    // Frames submitted later wait for this value, timeline can be waited many times unlike binary semaphore
+    computeValues[UInt64(queue)] = queueTimeline.submit(logicalDevice,
+                                                        EQueueType::Compute,
+                                                        { commandBuffer.get_buffer() },
+                                                        {});
+}
+
+Void Vulkan::begin_uploads()
+{
+    uploadsBatchDepth++;
+    immediateContext.begin_batch();
+}
+
+Void Vulkan::end_uploads()
+{
+    if (uploadsBatchDepth == 0)
+    {
+        SPDLOG_ERROR("Uploads batch has not been started.");
+        return;
+    }
+
+    uploadsBatchDepth--;
+    if (uploadsBatchDepth == 0)
+    {
+        flush_uploads();
+    }
+    immediateContext.end_batch(logicalDevice, queueTimeline);
+}
+
 Void Vulkan::create_model_render_data(Simulation<Vulkan>& simulation, Model<Vulkan>& model)
 {
+    // Buffers and textures of all meshes are copied with one graphics submit
+    begin_uploads();
     for (UInt64 i = 0; i < model.meshes.size(); ++i)
     {
         create_mesh_buffers(simulation.resourceManager.get_mesh(model.meshes[i]));
         create_material_images(simulation, simulation.resourceManager.get_material(model.materials[i]));
     }
+    end_uploads();
 }
 
 Void Vulkan::create_mesh_buffers(Mesh<Vulkan>& mesh)
@@ -338,6 +981,8 @@ Void Vulkan::create_mesh_buffers(Mesh<Vulkan>& mesh)
 
 Void Vulkan::create_material_images(Simulation<Vulkan>& simulation, Material<Vulkan>& material)
 {
+    assign_material_variant(simulation, material);
+
     for (Handle<Texture<Vulkan>>& textureHandle : material.textures)
     {
         if (textureHandle != Handle<Texture<Vulkan>>::NONE)
@@ -357,23 +1002,19 @@ Void Vulkan::create_texture_image(Texture<Vulkan>& texture, UInt32 mipLevels)
     {
         textureSize *= sizeof(Float32);
     }
-    stagingBuffer.create(physicalDevice,
-                         logicalDevice,
+    stagingBuffer.create(logicalDevice,
+                         memoryAllocator,
                          textureSize,
                          VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
                          VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
                          nullptr);
-
-    Void* data;
-    vkMapMemory(logicalDevice.get_device(), stagingBuffer.get_memory(), 0, textureSize, 0, &data);
-    memcpy(data, texture.data, textureSize);
-    vkUnmapMemory(logicalDevice.get_device(), stagingBuffer.get_memory());
+    memcpy(*stagingBuffer.get_mapped_memory(), texture.data, textureSize);
 
 
     if (texture.channels != 4)
     {
         SPDLOG_ERROR("Not supported channels count: {} in texture: {}", texture.channels, texture.name);
-        stagingBuffer.clear(logicalDevice, nullptr);
+        stagingBuffer.clear(logicalDevice, memoryAllocator, nullptr);
         return;
     }
     VkFormat format = VK_FORMAT_R8G8B8A8_UNORM;
@@ -388,6 +1029,7 @@ Void Vulkan::create_texture_image(Texture<Vulkan>& texture, UInt32 mipLevels)
 
     textureImage.create(physicalDevice,
                         logicalDevice,
+                        memoryAllocator,
                         texture.size,
                         mipLevels,
                         VK_SAMPLE_COUNT_1_BIT,
@@ -399,11 +1041,35 @@ Void Vulkan::create_texture_image(Texture<Vulkan>& texture, UInt32 mipLevels)
                         nullptr);
     textureImage.create_sampler(physicalDevice, logicalDevice, nullptr);
 
-    transition_image_layout(textureImage,
-                            VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-                            VK_PIPELINE_STAGE_TRANSFER_BIT,
-                            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-    copy_buffer_to_image(stagingBuffer, textureImage);
+    if (physicalDevice.has_dedicated_transfer_family())
+    {
+        // Copy goes with buffer uploads to transfer queue, graphics family acquires image in flush_uploads
+        if (!isUploadRecorded)
+        {
+            wait_for_uploads();
+            get_command_buffer(uploadCommandBuffer).begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+            isUploadRecorded = true;
+        }
+        const CommandBuffer& uploadBuffer = get_command_buffer(uploadCommandBuffer);
+        uploadBuffer.pipeline_image_barrier(textureImage,
+                                            VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                                            VK_PIPELINE_STAGE_TRANSFER_BIT,
+                                            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+        copy_buffer_to_image(uploadBuffer.get_buffer(), stagingBuffer, textureImage);
+        uploadedImages.push_back(texture.imageHandle);
+
+        // Acquire has to be submitted before graphics commands below, inside batch end_uploads does it first
+        if (uploadsBatchDepth == 0)
+        {
+            flush_uploads();
+        }
+    } else {
+        transition_image_layout(textureImage,
+                                VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                                VK_PIPELINE_STAGE_TRANSFER_BIT,
+                                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+        copy_buffer_to_image(stagingBuffer, textureImage);
+    }
     if (texture.type != ETextureType::HDR)
     {
         generate_mipmaps(textureImage); // implicit transition to read optimal
@@ -415,7 +1081,11 @@ Void Vulkan::create_texture_image(Texture<Vulkan>& texture, UInt32 mipLevels)
                                 VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
     }
 
-    stagingBuffer.clear(logicalDevice, nullptr);
+    // Copy could be still recorded in open batch
+    retire_staging_buffer(stagingBuffer);
+    release_staging_buffers();
+
+    register_texture(texture.imageHandle);
 }
 
 Void Vulkan::load_pixels_from_image(Texture<Vulkan>& texture)
@@ -534,15 +1204,18 @@ Void Vulkan::load_pixels_from_image(Texture<Vulkan>& texture)
 
     const VkDeviceSize size = pixelSize * imageSize.x * imageSize.y;
 
-    buffer.create(physicalDevice,
-                  logicalDevice,
+    buffer.create(logicalDevice,
+                  memoryAllocator,
                   size,
                   VK_BUFFER_USAGE_TRANSFER_DST_BIT,
                   VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
                   nullptr);
 
-    logicalDevice.wait_idle();
+    // Image could be still written by submitted frames or compute
+    queueTimeline.wait_submitted(logicalDevice);
     copy_image_to_buffer(buffer, image);
+    // Pixels are read at once, so copy can not wait for end of uploads batch
+    immediateContext.wait(logicalDevice, queueTimeline, immediateContext.flush(logicalDevice, queueTimeline));
     //TODO: Sorry code for my sin ;-; don't judge my laziness ;-;
     if (texture.data == nullptr)
     {
@@ -551,6 +1224,7 @@ Void Vulkan::load_pixels_from_image(Texture<Vulkan>& texture)
         {
             SPDLOG_ERROR("Failed to allocate texture memory");
             free(texture.data);
+            buffer.clear(logicalDevice, memoryAllocator, nullptr);
             return;
         }
     } else {
@@ -559,6 +1233,7 @@ Void Vulkan::load_pixels_from_image(Texture<Vulkan>& texture)
         {
             SPDLOG_ERROR("Failed to allocate texture memory");
             free(texture.data);
+            buffer.clear(logicalDevice, memoryAllocator, nullptr);
             return;
         }
     }
@@ -570,9 +1245,7 @@ Void Vulkan::load_pixels_from_image(Texture<Vulkan>& texture)
             DynamicArray<Float32> tempData;
             tempData.resize(size / sizeof(Float32));
 
-            vkMapMemory(logicalDevice.get_device(), buffer.get_memory(), 0, size, 0, buffer.get_mapped_memory());
             memcpy(tempData.data(), *buffer.get_mapped_memory(), size);
-            vkUnmapMemory(logicalDevice.get_device(), buffer.get_memory());
 
             for (UInt64 i = 0; i < tempData.size(); ++i)
             {
@@ -585,10 +1258,11 @@ Void Vulkan::load_pixels_from_image(Texture<Vulkan>& texture)
         default:
         {
             SPDLOG_ERROR("Not supported image type, failed to copy pixels");
-            return;
+            break;
         }
     }
 
+    buffer.clear(logicalDevice, memoryAllocator, nullptr);
 }
 
 Handle<Vulkan::Image> Vulkan::create_image(const UVector2& size, VkFormat format, VkImageUsageFlags usage, VkImageTiling tiling, UInt32 mipLevels)
@@ -598,6 +1272,7 @@ Handle<Vulkan::Image> Vulkan::create_image(const UVector2& size, VkFormat format
 
     image.create(physicalDevice,
                  logicalDevice,
+                 memoryAllocator,
                  size,
                  mipLevels,
                  VK_SAMPLE_COUNT_1_BIT,
@@ -617,7 +1292,7 @@ Handle<RenderPass> Vulkan::create_render_pass(VkSampleCountFlagBits samples, Boo
 {
     Handle<RenderPass> handle = { renderPasses.size() };
     RenderPass& pass = renderPasses.emplace_back();
-    pass.create(physicalDevice, logicalDevice, swapchain, nullptr, samples, depthTest, loadOperation);
+    pass.create(physicalDevice, logicalDevice, memoryAllocator, swapchain, nullptr, samples, depthTest, loadOperation);
     return handle;
 }
 
@@ -629,13 +1304,18 @@ Handle<DescriptorPool> Vulkan::create_descriptor_pool()
 }
 
 Handle<VkCommandPool> Vulkan::create_command_pool(VkCommandPoolCreateFlagBits flags)
+{
+    return create_command_pool(flags, physicalDevice.get_graphics_family_index());
+}
+
+Handle<VkCommandPool> Vulkan::create_command_pool(VkCommandPoolCreateFlagBits flags, UInt32 queueFamilyIndex)
 {
     Handle<VkCommandPool> handle = { commandPools.size() };
     VkCommandPool pool;
     VkCommandPoolCreateInfo poolInfo{};
     poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
     poolInfo.flags = flags;
-    poolInfo.queueFamilyIndex = physicalDevice.get_graphics_family_index();
+    poolInfo.queueFamilyIndex = queueFamilyIndex;
 
     const VkResult result = vkCreateCommandPool(logicalDevice.get_device(), &poolInfo, nullptr, &pool);
     if (result != VK_SUCCESS)
@@ -740,6 +1420,20 @@ Handle<VkFence> Vulkan::create_fence(const String& name, VkFenceCreateFlags flag
 }
 
 
+UInt32 Vulkan::get_frames_in_flight() const
+{
+    return framesInFlight;
+}
+
+UInt32 Vulkan::get_frame_index() const
+{
+    return frameIndex;
+}
+
+FrameResources& Vulkan::get_current_frame()
+{
+    return frames[frameIndex];
+}
 
 VkSurfaceKHR Vulkan::get_surface() const
 {
@@ -805,6 +1499,16 @@ Vulkan::Pipeline& Vulkan::get_pipeline(const Handle<Pipeline> handle)
     return pipelines[handle.id];
 }
 
+Vulkan::ShaderPermutations& Vulkan::get_shader_permutations(const Handle<ShaderPermutations> handle)
+{
+    if (handle.id >= shaderPermutations.size())
+    {
+        SPDLOG_ERROR("Shader permutations {} not found, returned default.", handle.id);
+        return shaderPermutations[0];
+    }
+    return shaderPermutations[handle.id];
+}
+
 Vulkan::ShaderSet& Vulkan::get_shader_set(const Handle<ShaderSet> handle)
 {
     if (handle.id >= buffers.size())
@@ -996,6 +1700,52 @@ DescriptorPool& Vulkan::get_default_descriptor_pool()
     return descriptorPools[0];
 }
 
+Void Vulkan::defragment_memory(UInt64 maxBytesToMove)
+{
+    const DynamicArray<DefragmentationMove> moves = memoryAllocator.begin_defragmentation(maxBytesToMove);
+    if (moves.empty())
+    {
+        return;
+    }
+
+    // Moved buffers could be still read by frames in flight
+    queueTimeline.wait_submitted(logicalDevice);
+
+    DynamicArray<VkBuffer> oldBuffers;
+    oldBuffers.reserve(moves.size());
+    const VkCommandBuffer commandBuffer = immediateContext.begin_commands(logicalDevice, queueTimeline);
+    for (const DefragmentationMove& move : moves)
+    {
+        const Handle<Buffer> handle = { move.source.userData - 1 };
+        Buffer& buffer = get_buffer(handle);
+        const VkBuffer oldBuffer = buffer.get_buffer();
+        oldBuffers.push_back(oldBuffer);
+        buffer.rebind(logicalDevice, move.destination, nullptr);
+
+        VkBufferCopy copyRegion{};
+        copyRegion.size = buffer.get_size();
+        vkCmdCopyBuffer(commandBuffer, oldBuffer, buffer.get_buffer(), 1, &copyRegion);
+    }
+    immediateContext.wait(logicalDevice, queueTimeline, immediateContext.flush(logicalDevice, queueTimeline));
+
+    for (const VkBuffer oldBuffer : oldBuffers)
+    {
+        vkDestroyBuffer(logicalDevice.get_device(), oldBuffer, nullptr);
+    }
+    memoryAllocator.end_defragmentation(logicalDevice, moves, nullptr);
+    SPDLOG_INFO("Defragmentation moved {} buffers.", moves.size());
+}
+
+MemoryStatistics Vulkan::get_memory_statistics()
+{
+    return memoryAllocator.get_statistics();
+}
+
+SpirvCacheStatistics Vulkan::get_spirv_cache_statistics() const
+{
+    return spirvCache.get_statistics();
+}
+
 Void Vulkan::create_vulkan_instance()
 {
     if constexpr (DebugMessenger::ENABLE_VALIDATION_LAYERS)
@@ -1070,72 +1820,430 @@ DynamicArray<const Char*> Vulkan::get_required_extensions()
     return extensions;
 }
 
+Void Vulkan::create_frames()
+{
+    DynamicArray<String> commandBufferNames;
+    commandBufferNames.reserve(framesInFlight);
+    for (UInt32 i = 0; i < framesInFlight; ++i)
+    {
+        commandBufferNames.push_back("FrameCommandBuffer" + std::to_string(i));
+    }
+    create_command_buffers(get_command_pool(graphicsPool), VK_COMMAND_BUFFER_LEVEL_PRIMARY, commandBufferNames);
+
+    frames.resize(framesInFlight);
+    for (UInt32 i = 0; i < framesInFlight; ++i)
+    {
+        const String index = std::to_string(i);
+        FrameResources& frame = frames[i];
+        frame.commandBuffer  = get_command_buffer_handle(commandBufferNames[i]);
+        frame.submittedValue = 0;
+        frame.imageAvailable = create_semaphore("FrameImageAvailable" + index);
+        frame.uniformBuffer  = create_dynamic_buffer<UniformBufferObject>(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+                                                                          "FrameUniformBuffer" + index);
+        frame.instanceBuffer = create_dynamic_buffer<Array<FMatrix4, MAX_INSTANCES_COUNT>>(
+                                   VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                                   "FrameInstanceBuffer" + index);
+        frame.instancesCount = 0;
+        frame.usedRecordingBuffersCount = 0;
+        frame.uniformSetName = "Uniforms" + index;
+    }
+}
 
-Void Vulkan::create_default_descriptors()
+Void Vulkan::create_staging_buffer()
 {
-    DescriptorPool& descriptorPool = get_default_descriptor_pool();
-    descriptorPool.add_binding("TextureData",
-                               1,
-                               0,
-                               VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-                               1,
-                               VK_SHADER_STAGE_FRAGMENT_BIT,
-                               VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT,
-                               VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT,
-                               VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT);
+    transferPool = create_command_pool(VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+                                       physicalDevice.get_transfer_family_index());
+    create_command_buffers(transferPool, VK_COMMAND_BUFFER_LEVEL_PRIMARY, { "UploadCommandBuffer" });
+    create_command_buffers(graphicsPool, VK_COMMAND_BUFFER_LEVEL_PRIMARY, { "AcquireCommandBuffer" });
+    uploadCommandBuffer  = get_command_buffer_handle("UploadCommandBuffer");
+    acquireCommandBuffer = get_command_buffer_handle("AcquireCommandBuffer");
+
+    stagingBuffer = { buffers.size() };
+    buffers.emplace_back().create(logicalDevice,
+                                  memoryAllocator,
+                                  STAGING_BUFFER_SIZE,
+                                  VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                                  VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                                  nullptr);
+    stagingOffset = 0;
+    uploadsBatchDepth = 0;
+    isUploadRecorded = false;
+    isUploadPending = false;
+    if (physicalDevice.has_dedicated_transfer_family())
+    {
+        SPDLOG_INFO("Uploads use dedicated transfer queue family {}.", physicalDevice.get_transfer_family_index());
+    }
+}
+
+Void Vulkan::upload_buffer(const Void* data, UInt64 size, const Buffer& destination)
+{
+    if (size > STAGING_BUFFER_SIZE)
+    {
+        // Does not fit into ring at all, so it is copied through own staging buffer
+        SPDLOG_WARN("Upload of {} bytes is larger than staging buffer, temporary buffer is used.", size);
+        flush_uploads();
+        Buffer temporaryBuffer{};
+        temporaryBuffer.create(logicalDevice,
+                               memoryAllocator,
+                               size,
+                               VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                               VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                               nullptr);
+        memcpy(*temporaryBuffer.get_mapped_memory(), data, size);
+        copy_buffer(temporaryBuffer, destination);
+        retire_staging_buffer(temporaryBuffer);
+        return;
+    }
 
-    descriptorPool.add_binding("ViewProjection",
-                               0,
-                               0,
-                               VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
-                               1,
-                               VK_SHADER_STAGE_VERTEX_BIT,
-                               VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT,
-                               VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT,
-                               VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT);
+    UInt64 offset = (stagingOffset + STAGING_ALIGNMENT - 1) & ~(STAGING_ALIGNMENT - 1);
+    if (offset + size > STAGING_BUFFER_SIZE)
+    {
+        flush_uploads();
+        offset = 0;
+    }
 
+    const Bool isTransferDedicated = physicalDevice.has_dedicated_transfer_family();
+    if (!isUploadRecorded)
+    {
+        // Previous batch still reads staging ring and uses command buffers
+        wait_for_uploads();
+        offset = 0;
+        if (isTransferDedicated)
+        {
+            get_command_buffer(uploadCommandBuffer).begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+        }
+        isUploadRecorded = true;
+    }
+    // Graphics family copies go with texture commands into the same submit
+    const VkCommandBuffer commandBuffer = isTransferDedicated
+                                        ? get_command_buffer(uploadCommandBuffer).get_buffer()
+                                        : immediateContext.begin_commands(logicalDevice, queueTimeline);
 
-    descriptorPool.create_layouts(logicalDevice, nullptr);
+    Buffer& staging = get_buffer(stagingBuffer);
+    staging.update_dynamic_buffer(data, size, offset);
+    stagingOffset = offset + size;
 
-    DynamicArray<VkPushConstantRange> pushConstants;
-    VkPushConstantRange& vertexConstant = pushConstants.emplace_back();
-    vertexConstant.size = sizeof(VertexConstants);
-    vertexConstant.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+    VkBufferCopy copyRegion{};
+    copyRegion.srcOffset = offset;
+    copyRegion.dstOffset = 0;
+    copyRegion.size      = size;
+    vkCmdCopyBuffer(commandBuffer, staging.get_buffer(), destination.get_buffer(), 1, &copyRegion);
+    uploadedBuffers.push_back(destination.get_buffer());
 
-    descriptorPool.set_push_constants(pushConstants);
+    if (uploadsBatchDepth == 0)
+    {
+        flush_uploads();
+    }
 }
 
-Void Vulkan::setup_default_descriptors(Simulation<Vulkan>& simulation)
+Void Vulkan::flush_uploads()
 {
-    DescriptorPool& descriptorPool = get_default_descriptor_pool();
+    if (!isUploadRecorded)
+    {
+        return;
+    }
 
-    DynamicArray<DescriptorResourceInfo> uniformResources;
-    VkDescriptorBufferInfo& uniformBufferInfo = uniformResources.emplace_back().bufferInfos.emplace_back();
-    uniformBufferInfo.buffer = get_buffer("DefaultUniformBuffer").get_buffer();
-    uniformBufferInfo.offset = 0;
-    uniformBufferInfo.range = sizeof(UniformBufferObject);
+    const CommandBuffer& uploadBuffer = get_command_buffer(uploadCommandBuffer);
+    if (!physicalDevice.has_dedicated_transfer_family())
+    {
+        // Copied data has to be visible for vertex input of next submits
+        CommandBuffer commandBuffer;
+        commandBuffer.set_buffer(immediateContext.begin_commands(logicalDevice, queueTimeline));
+        commandBuffer.pipeline_memory_barrier(VK_PIPELINE_STAGE_TRANSFER_BIT,
+                                              VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+                                              0,
+                                              VK_ACCESS_TRANSFER_WRITE_BIT,
+                                              VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT);
+        uploadValue = immediateContext.get_recorded_value();
+        // Inside batch immediate context is submitted by end_uploads or when ring has to be reused
+        if (uploadsBatchDepth == 0)
+        {
+            immediateContext.flush(logicalDevice, queueTimeline);
+        }
+    } else {
+        // Buffers are exclusive, so transfer family releases them and graphics family acquires them
+        DynamicArray<VkBufferMemoryBarrier> releaseBarriers;
+        DynamicArray<VkBufferMemoryBarrier> acquireBarriers;
+        releaseBarriers.reserve(uploadedBuffers.size());
+        acquireBarriers.reserve(uploadedBuffers.size());
+        for (const VkBuffer buffer : uploadedBuffers)
+        {
+            VkBufferMemoryBarrier barrier{};
+            barrier.sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+            barrier.srcQueueFamilyIndex = physicalDevice.get_transfer_family_index();
+            barrier.dstQueueFamilyIndex = physicalDevice.get_graphics_family_index();
+            barrier.buffer              = buffer;
+            barrier.offset              = 0;
+            barrier.size                = VK_WHOLE_SIZE;
+
+            barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barrier.dstAccessMask = 0;
+            releaseBarriers.push_back(barrier);
+
+            barrier.srcAccessMask = 0;
+            barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT;
+            acquireBarriers.push_back(barrier);
+        }
 
-    descriptorPool.add_set(descriptorPool.get_layout_data_handle("ViewProjection"),
-                           uniformResources,
-                           "Uniforms");
+        uploadBuffer.pipeline_barrier(VK_PIPELINE_STAGE_TRANSFER_BIT,
+                                      VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                                      0,
+                                      {},
+                                      releaseBarriers,
+                                      {});
+
+        const CommandBuffer& acquireBuffer = get_command_buffer(acquireCommandBuffer);
+        acquireBuffer.begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+        acquireBuffer.pipeline_barrier(VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                                       VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+                                       0,
+                                       {},
+                                       acquireBarriers,
+                                       {});
+
+        // Images stay in transfer layout, mipmaps are generated from them on graphics queue
+        const UInt32 transferFamily = physicalDevice.get_transfer_family_index();
+        const UInt32 graphicsFamily = physicalDevice.get_graphics_family_index();
+        for (const Handle<Image> imageHandle : uploadedImages)
+        {
+            Image& image = get_image(imageHandle);
+            uploadBuffer.pipeline_image_barrier(VK_PIPELINE_STAGE_TRANSFER_BIT,
+                                                VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                                                0,
+                                                VK_ACCESS_TRANSFER_WRITE_BIT,
+                                                0,
+                                                transferFamily,
+                                                graphicsFamily,
+                                                image,
+                                                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+            acquireBuffer.pipeline_image_barrier(VK_PIPELINE_STAGE_TRANSFER_BIT,
+                                                 VK_PIPELINE_STAGE_TRANSFER_BIT,
+                                                 0,
+                                                 0,
+                                                 VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT,
+                                                 transferFamily,
+                                                 graphicsFamily,
+                                                 image,
+                                                 VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+        }
+        uploadBuffer.end();
+        acquireBuffer.end();
+
+        const UInt64 transferValue = queueTimeline.submit(logicalDevice,
+                                                          EQueueType::Transfer,
+                                                          { uploadBuffer.get_buffer() },
+                                                          {});
+
+        // Draws submitted later to graphics queue are ordered after acquire barrier, so they see uploaded data
+        uploadValue = queueTimeline.submit(logicalDevice,
+                                           EQueueType::Graphics,
+                                           { acquireBuffer.get_buffer() },
+                                           { { EQueueType::Transfer,
+                                               transferValue,
+                                               VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT } });
+    }
+
+    uploadedBuffers.clear();
+    uploadedImages.clear();
+    isUploadRecorded = false;
+    isUploadPending = true;
+}
 
-    DynamicArray<DescriptorResourceInfo> resources;
-    DynamicArray<VkDescriptorImageInfo>& imageInfos = resources.emplace_back().imageInfos;
+Void Vulkan::wait_for_uploads()
+{
+    if (!isUploadPending)
+    {
+        return;
+    }
 
-    Handle<Texture<Vulkan>> textureHandle = simulation.resourceManager.get_default_material()[ETextureType::Albedo];
-    const Texture<Vulkan>& texture = simulation.resourceManager.get_texture(textureHandle);
+    if (physicalDevice.has_dedicated_transfer_family())
+    {
+        // Acquire submit waits for transfer one, so upload buffer is free as well
+        queueTimeline.wait(logicalDevice, EQueueType::Graphics, uploadValue);
+    } else {
+        immediateContext.wait(logicalDevice, queueTimeline, uploadValue);
+    }
+    stagingOffset = 0;
+    isUploadPending = false;
+}
 
-    Image& image = get_image(texture.imageHandle);
-    VkDescriptorImageInfo& imageInfo = imageInfos.emplace_back();
+Void Vulkan::retire_staging_buffer(const Buffer& buffer)
+{
+    retiredStagingBuffers.emplace_back(immediateContext.get_recorded_value(), buffer);
+}
+
+Void Vulkan::release_staging_buffers()
+{
+    UInt64 keptCount = 0;
+    for (UInt64 i = 0; i < retiredStagingBuffers.size(); ++i)
+    {
+        Pair<UInt64, Buffer>& retired = retiredStagingBuffers[i];
+        if (immediateContext.is_completed(logicalDevice, queueTimeline, retired.first))
+        {
+            retired.second.clear(logicalDevice, memoryAllocator, nullptr);
+        } else {
+            retiredStagingBuffers[keptCount] = retired;
+            keptCount++;
+        }
+    }
+    retiredStagingBuffers.resize(keptCount);
+}
+
+Void Vulkan::create_compute_resources()
+{
+    computePool = create_command_pool(VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+                                      physicalDevice.get_compute_family_index());
+    for (UInt64 i = 0; i < UInt64(EComputeQueue::Count); ++i)
+    {
+        const String name = String(magic_enum::enum_name(EComputeQueue(i))) + "ComputeCommandBuffer";
+        create_command_buffers(computePool, VK_COMMAND_BUFFER_LEVEL_PRIMARY, { name });
+        computeCommandBuffers[i] = get_command_buffer_handle(name);
+        computeValues[i] = 0;
+    }
+    recordedComputeQueue = EComputeQueue::Count;
+}
+
+Void Vulkan::reserve_recording_buffers(FrameResources& frame, UInt32 count)
+{
+    for (UInt64 i = frame.recordingBuffers.size(); i < count; ++i)
+    {
+        const String name = "Frame" + std::to_string(frameIndex) + "SecondaryCommandBuffer" + std::to_string(i);
+        const Handle<VkCommandPool> pool = create_command_pool(VK_COMMAND_POOL_CREATE_TRANSIENT_BIT);
+        create_command_buffers(pool, VK_COMMAND_BUFFER_LEVEL_SECONDARY, { name });
+
+        frame.recordingPools.push_back(pool);
+        frame.recordingBuffers.push_back(get_command_buffer_handle(name));
+    }
+}
+
+Void Vulkan::create_present_semaphores()
+{
+    // Swapchain could be recreated with more images, semaphores of already existing ones are reused
+    const UInt64 imagesCount = swapchain.get_image_views().size();
+    for (UInt64 i = renderFinished.size(); i < imagesCount; ++i)
+    {
+        renderFinished.push_back(create_semaphore("ImageRenderFinished" + std::to_string(i)));
+    }
+}
+
+Void Vulkan::create_reflected_layouts(DescriptorPool& descriptorPool, const DynamicArray<Handle<Shader>>& shaderHandles, const DynamicArray<String>& layoutNames, VkDescriptorBindingFlags bindingFlags)
+{
+    // Stages are merged, so binding used by many stages is declared once with all of them
+    ShaderReflection reflection;
+    for (const Handle<Shader> shaderHandle : shaderHandles)
+    {
+        const Shader& shader = get_shader(shaderHandle);
+        if (!reflection.merge(shader.get_reflection()))
+        {
+            SPDLOG_ERROR("Reflection of shader {} does not match other stages.", shader.get_name());
+        }
+    }
+
+    descriptorPool.add_bindings(reflection, layoutNames, bindingFlags);
+    descriptorPool.create_layouts(logicalDevice, descriptorLayoutCache, nullptr);
+}
+
+Void Vulkan::register_texture(Handle<Image> imageHandle)
+{
+    if (textureDescriptors.size() >= DescriptorPool::UNBOUNDED_DESCRIPTORS_COUNT)
+    {
+        SPDLOG_ERROR("Textures set is full, image {} is drawn with default texture.", imageHandle.id);
+        return;
+    }
+
+    const Image& image = get_image(imageHandle);
+    const UInt32 slot = UInt32(textureDescriptors.size());
+    VkDescriptorImageInfo& imageInfo = textureDescriptors.emplace_back();
     imageInfo.imageLayout = image.get_current_layout();
     imageInfo.imageView   = image.get_view();
     imageInfo.sampler     = image.get_sampler();
+    textureSlots[imageHandle.id] = slot;
+
+    if (texturesSet.id == Handle<DescriptorSetData>::NONE.id)
+    {
+        return;
+    }
 
-    descriptorPool.add_set(descriptorPool.get_layout_data_handle("TextureData"),
-                           resources,
-                           "Texture");
+    // Slot was not used by any draw yet, so with update after bind it is written while frames are in flight
+    DescriptorResourceInfo resource;
+    resource.imageInfos.push_back(imageInfo);
+    get_default_descriptor_pool().update_set(logicalDevice, resource, texturesSet, slot, 0);
+}
+
+UInt32 Vulkan::get_texture_slot(Simulation<Vulkan>& simulation, UInt64 materialId) const
+{
+    ResourceManager<Vulkan>& resourceManager = simulation.resourceManager;
+    const Material<Vulkan>& material = resourceManager.get_material(Handle<Material<Vulkan>>{ materialId });
+    const Texture<Vulkan>& albedo = resourceManager.get_texture(material[ETextureType::Albedo]);
+
+    const auto iterator = textureSlots.find(albedo.imageHandle.id);
+    if (iterator == textureSlots.end())
+    {
+        return defaultTextureSlot;
+    }
+    return iterator->second;
+}
+
+Void Vulkan::assign_material_variant(Simulation<Vulkan>& simulation, Material<Vulkan>& material)
+{
+    if (material.shaderSetHandle.id != Handle<ShaderSet>::NONE.id)
+    {
+        return;
+    }
+
+    // Alpha test is compiled only for materials which albedo has texels it would discard
+    DynamicArray<String> keywords;
+    const Handle<Texture<Vulkan>> albedoHandle = material[ETextureType::Albedo];
+    if (albedoHandle.id != Handle<Texture<Vulkan>>::NONE.id
+        && simulation.resourceManager.get_texture(albedoHandle).hasCutoutTexels)
+    {
+        keywords.push_back(ALPHA_TEST_KEYWORD);
+    }
+
+    material.shaderSetHandle = get_shader_variant(simulation,
+                                                  defaultPermutations,
+                                                  get_variant_key(defaultPermutations, keywords));
+}
+
+Void Vulkan::setup_default_descriptors(Simulation<Vulkan>& simulation)
+{
+    DescriptorPool& descriptorPool = get_default_descriptor_pool();
+
+    for (const FrameResources& frame : frames)
+    {
+        DynamicArray<DescriptorResourceInfo> uniformResources;
+        VkDescriptorBufferInfo& uniformBufferInfo = uniformResources.emplace_back().bufferInfos.emplace_back();
+        uniformBufferInfo.buffer = get_buffer(frame.uniformBuffer).get_buffer();
+        uniformBufferInfo.offset = 0;
+        uniformBufferInfo.range = sizeof(UniformBufferObject);
+
+        VkDescriptorBufferInfo& instanceBufferInfo = uniformResources.emplace_back().bufferInfos.emplace_back();
+        instanceBufferInfo.buffer = get_buffer(frame.instanceBuffer).get_buffer();
+        instanceBufferInfo.offset = 0;
+        instanceBufferInfo.range = VK_WHOLE_SIZE;
+
+        descriptorPool.add_set(descriptorPool.get_layout_data_handle(FRAME_LAYOUT_NAME),
+                               uniformResources,
+                               frame.uniformSetName);
+    }
+
+    Handle<Texture<Vulkan>> textureHandle = simulation.resourceManager.get_default_material()[ETextureType::Albedo];
+    const Texture<Vulkan>& texture = simulation.resourceManager.get_texture(textureHandle);
+    const auto iterator = textureSlots.find(texture.imageHandle.id);
+    if (iterator != textureSlots.end())
+    {
+        defaultTextureSlot = iterator->second;
+    }
+
+    // Textures created later are written to their slots by register_texture
+    DynamicArray<DescriptorResourceInfo> resources;
+    resources.emplace_back().imageInfos = textureDescriptors;
+    const Handle<DescriptorSetData> textureSetHandle = descriptorPool.add_set(descriptorPool.get_layout_data_handle(TEXTURE_LAYOUT_NAME),
+                                                                              resources,
+                                                                              TEXTURES_SET_NAME);
 
     descriptorPool.create_sets(logicalDevice, nullptr);
+    texturesSet = textureSetHandle;
 }
 
 Void Vulkan::recreate_swapchain(Simulation<Vulkan>& simulation)
@@ -1147,70 +2255,225 @@ Void Vulkan::recreate_swapchain(Simulation<Vulkan>& simulation)
         glfwWaitEvents();
     }
     
-    logicalDevice.wait_idle();
+    // Attachments and swapchain images could be still used by submitted frames
+    queueTimeline.wait_submitted(logicalDevice);
     
     swapchain.clear(logicalDevice, nullptr);
     swapchain.create(logicalDevice, physicalDevice, surface, windowSize, nullptr);
+    create_present_semaphores();
     for (RenderPass& pass : renderPasses)
     {
         pass.clear_framebuffers(logicalDevice, nullptr);
-        pass.clear_images(logicalDevice, nullptr);
-        pass.create_attachments(physicalDevice, logicalDevice, swapchain, nullptr);
+        pass.clear_images(logicalDevice, memoryAllocator, nullptr);
+        pass.create_attachments(physicalDevice, logicalDevice, memoryAllocator, swapchain, nullptr);
         pass.create_framebuffers(logicalDevice, swapchain, nullptr);
     }
 }
 
-Void Vulkan::reload_shaders(ShaderSet& shaderSet)
+Void Vulkan::reload_shaders(Simulation<Vulkan>& simulation, Handle<ShaderSet> shaderSetHandle)
 {
-    Bool result = true;
-    DynamicArray<Shader> pipelineShaders;
-    pipelineShaders.reserve(shaderSet.shaderHandles.size());
-    for (const Handle<ShaderVK> shaderHandle : shaderSet.shaderHandles)
+    const ShaderSet& shaderSet = get_shader_set(shaderSetHandle);
+    DynamicArray<Shader> reloadedShaders;
+    reloadedShaders.reserve(shaderSet.shaderHandles.size());
+    for (const Handle<Shader> shaderHandle : shaderSet.shaderHandles)
+    {
+        reloadedShaders.push_back(get_shader(shaderHandle));
+    }
+
+    // Live shaders, pool and render pass could change before worker starts, so it gets copies
+    const Pipeline& pipeline = get_pipeline(shaderSet.pipelineHandle);
+    const Bool isCompute = pipeline.get_type() == EPipelineType::Compute;
+    const DescriptorPool& descriptorPool = get_descriptor_pool(shaderSet.descriptorPoolHandle);
+    RenderPass renderPass{};
+    if (!isCompute)
     {
-        Shader& shader = get_shader(shaderHandle);
-        result &= shader.recreate(logicalDevice, nullptr);
-        pipelineShaders.emplace_back(shader);
+        renderPass = get_render_pass(shaderSet.renderPassHandle);
     }
 
-    if (!result)
+    PendingReload& pendingReload = pendingReloads.emplace_back();
+    pendingReload.shaderSetHandle = shaderSetHandle;
+    // Recompilation and pipeline creation take milliseconds, so they do not run on threads frame waits for
+    pendingReload.future = simulation.threadPool.submit_background([this,
+                                                                    isCompute,
+                                                                    descriptorPool,
+                                                                    renderPass,
+                                                                    shaders = std::move(reloadedShaders)]() mutable
+    {
+        // Copies keep module of live shaders until new one is created
+        ReloadedShaderSet result;
+        Bool isValid = true;
+        for (Shader& shader : shaders)
+        {
+            isValid = isValid && shader.recompile(spirvCache) && shader.create_module(logicalDevice, nullptr);
+        }
+
+        if (isValid)
+        {
+            if (isCompute)
+            {
+                result.pipeline.create_compute_pipeline(descriptorPool, shaders[0], logicalDevice, pipelineCache, nullptr);
+            } else {
+                result.pipeline.create_graphics_pipeline(descriptorPool,
+                                                         renderPass,
+                                                         shaders,
+                                                         logicalDevice,
+                                                         pipelineCache,
+                                                         nullptr);
+            }
+            isValid = result.pipeline.is_ready();
+        }
+
+        result.isValid = isValid;
+        result.shaders = std::move(shaders);
+        return result;
+    });
+}
+
+Void Vulkan::reload_dependents(Simulation<Vulkan>& simulation, const String& filePath)
+{
+    const auto iterator = shaderDependents.find(ShaderIncludes::s_normalize_path(filePath));
+    if (iterator == shaderDependents.end())
     {
-        SPDLOG_ERROR("Failed to reload shaders.");
         return;
     }
 
-    logicalDevice.wait_idle();
+    const Set<UInt64>& dependents = iterator->second;
+    Set<UInt64> reloadedPipelines;
+    for (UInt64 i = 0; i < shaderSets.size(); ++i)
+    {
+        const ShaderSet& shaderSet = shaderSets[i];
+        // Sets with the same state share pipeline, reloading it once updates all of them
+        if (reloadedPipelines.contains(shaderSet.pipelineHandle.id))
+        {
+            continue;
+        }
 
-    const DescriptorPool& descriptorPool = get_descriptor_pool(shaderSet.descriptorPoolHandle);
-    const RenderPass& renderPass = get_render_pass(shaderSet.renderPassHandle);
+        for (const Handle<Shader> shaderHandle : shaderSet.shaderHandles)
+        {
+            if (dependents.contains(shaderHandle.id))
+            {
+                reloadedPipelines.insert(shaderSet.pipelineHandle.id);
+                reload_shaders(simulation, Handle<ShaderSet>{ i });
+                break;
+            }
+        }
+    }
+
+    SPDLOG_INFO("Reloading {} pipelines depending on {}", reloadedPipelines.size(), filePath);
+}
+
+Void Vulkan::update_pending_reloads()
+{
+    UInt64 pendingCount = 0;
+    for (UInt64 i = 0; i < pendingReloads.size(); ++i)
+    {
+        PendingReload& pendingReload = pendingReloads[i];
+        if (pendingReload.future.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        {
+            if (pendingCount != i)
+            {
+                pendingReloads[pendingCount] = std::move(pendingReload);
+            }
+            pendingCount++;
+            continue;
+        }
+
+        ReloadedShaderSet reloaded = pendingReload.future.get();
+        const ShaderSet& shaderSet = get_shader_set(pendingReload.shaderSetHandle);
+        if (!reloaded.isValid)
+        {
+            SPDLOG_ERROR("Failed to reload shaders.");
+            for (UInt64 j = 0; j < shaderSet.shaderHandles.size(); ++j)
+            {
+                // Shaders which failed before module creation still refer to live module
+                if (reloaded.shaders[j].get_module() != get_shader(shaderSet.shaderHandles[j]).get_module())
+                {
+                    reloaded.shaders[j].clear(logicalDevice, nullptr);
+                }
+            }
+            reloaded.pipeline.clear(logicalDevice, nullptr);
+            continue;
+        }
+
+        // Submits made so far could still use old objects, frames recorded from now use new ones
+        RetiredPipeline& retired = retiredPipelines.emplace_back();
+        retired.graphicsValue = queueTimeline.get_submitted_value(EQueueType::Graphics);
+        retired.computeValue  = queueTimeline.get_submitted_value(EQueueType::Compute);
+
+        for (UInt64 j = 0; j < shaderSet.shaderHandles.size(); ++j)
+        {
+            Shader& shader = get_shader(shaderSet.shaderHandles[j]);
+            retired.shaders.push_back(std::move(shader));
+            shader = std::move(reloaded.shaders[j]);
+            // Reloaded code could include other headers than before
+            register_dependencies(shaderSet.shaderHandles[j]);
+        }
+        Pipeline& pipeline = get_pipeline(shaderSet.pipelineHandle);
+        retired.pipeline = pipeline;
+        pipeline = reloaded.pipeline;
+    }
+    pendingReloads.resize(pendingCount);
+}
+
+Void Vulkan::register_dependencies(Handle<Shader> shaderHandle)
+{
+    const Shader& shader = get_shader(shaderHandle);
+    shaderDependents[ShaderIncludes::s_normalize_path(shader.get_file_path())].insert(shaderHandle.id);
+    for (const String& includedFile : shader.get_included_files())
+    {
+        shaderDependents[includedFile].insert(shaderHandle.id);
+    }
+}
+
+Void Vulkan::release_retired_pipelines()
+{
+    // Pipelines created on workers could still use retired modules
+    if (!pendingPipelines.empty())
+    {
+        return;
+    }
+
+    UInt64 keptCount = 0;
+    for (UInt64 i = 0; i < retiredPipelines.size(); ++i)
+    {
+        RetiredPipeline& retired = retiredPipelines[i];
+        if (queueTimeline.is_completed(logicalDevice, EQueueType::Graphics, retired.graphicsValue)
+            && queueTimeline.is_completed(logicalDevice, EQueueType::Compute, retired.computeValue))
+        {
+            retired.pipeline.clear(logicalDevice, nullptr);
+            for (Shader& shader : retired.shaders)
+            {
+                shader.clear(logicalDevice, nullptr);
+            }
+            continue;
+        }
 
-    Pipeline& pipeline = get_pipeline(shaderSet.pipelineHandle);
-    pipeline.create_graphics_pipeline(descriptorPool,
-                                      renderPass,
-                                      pipelineShaders,
-                                      logicalDevice,
-                                      nullptr);
+        if (keptCount != i)
+        {
+            retiredPipelines[keptCount] = std::move(retired);
+        }
+        keptCount++;
+    }
+    retiredPipelines.resize(keptCount);
 }
 
 Void Vulkan::resize_image(const UVector2& newSize, Handle<Image> image)
 {
-    get_image(image).resize(physicalDevice, logicalDevice, newSize, nullptr);
+    get_image(image).resize(physicalDevice, logicalDevice, memoryAllocator, newSize, nullptr);
 }
 
 Void Vulkan::transition_image_layout(Image& image, VkPipelineStageFlags sourceStage, VkPipelineStageFlags destinationStage, VkImageLayout newLayout)
 {
     CommandBuffer commandBuffer;
-    VkCommandBuffer buffer;
-    begin_quick_commands(buffer);
-    commandBuffer.set_buffer(buffer);
+    commandBuffer.set_buffer(immediateContext.begin_commands(logicalDevice, queueTimeline));
 
     commandBuffer.pipeline_image_barrier(image, sourceStage, destinationStage, newLayout);
-    end_quick_commands(buffer);
+    immediateContext.end_commands(logicalDevice, queueTimeline);
 }
 
 Void Vulkan::generate_mipmaps(Image& image)
 {
-    VkCommandBuffer commandBuffer;
-    begin_quick_commands(commandBuffer);
+    const VkCommandBuffer commandBuffer = immediateContext.begin_commands(logicalDevice, queueTimeline);
 
     VkImageMemoryBarrier barrier{};
     barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
@@ -1320,14 +2583,17 @@ Void Vulkan::generate_mipmaps(Image& image)
                          1,
                          &barrier);
 
-    end_quick_commands(commandBuffer);
+    immediateContext.end_commands(logicalDevice, queueTimeline);
 }
 
 Void Vulkan::copy_buffer_to_image(const Buffer& buffer, Image& image)
 {
-    VkCommandBuffer commandBuffer;
-    begin_quick_commands(commandBuffer);
+    copy_buffer_to_image(immediateContext.begin_commands(logicalDevice, queueTimeline), buffer, image);
+    immediateContext.end_commands(logicalDevice, queueTimeline);
+}
 
+Void Vulkan::copy_buffer_to_image(VkCommandBuffer commandBuffer, const Buffer& buffer, Image& image)
+{
     const UVector2& size = image.get_size();
     VkBufferImageCopy region{};
     region.bufferOffset = 0;
@@ -1346,14 +2612,11 @@ Void Vulkan::copy_buffer_to_image(const Buffer& buffer, Image& image)
                            image.get_current_layout(),
                            1,
                            &region);
-
-    end_quick_commands(commandBuffer);
 }
 
 Void Vulkan::copy_image_to_buffer(Buffer& buffer, Image& image)
 {
-    VkCommandBuffer commandBuffer;
-    begin_quick_commands(commandBuffer);
+    const VkCommandBuffer commandBuffer = immediateContext.begin_commands(logicalDevice, queueTimeline);
 
     CommandBuffer bufferCommand;
     bufferCommand.set_buffer(commandBuffer);
@@ -1389,13 +2652,12 @@ Void Vulkan::copy_image_to_buffer(Buffer& buffer, Image& image)
                                          VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
                                          layout);
 
-    end_quick_commands(commandBuffer);
+    immediateContext.end_commands(logicalDevice, queueTimeline);
 }
 
-Void Vulkan::copy_buffer(const Buffer& source, Buffer& destination)
+Void Vulkan::copy_buffer(const Buffer& source, const Buffer& destination)
 {
-    VkCommandBuffer commandBuffer;
-    begin_quick_commands(commandBuffer);
+    const VkCommandBuffer commandBuffer = immediateContext.begin_commands(logicalDevice, queueTimeline);
 
     VkBufferCopy copyRegion{};
     copyRegion.srcOffset = 0; // Optional
@@ -1403,57 +2665,40 @@ Void Vulkan::copy_buffer(const Buffer& source, Buffer& destination)
     copyRegion.size = source.get_size();
     vkCmdCopyBuffer(commandBuffer, source.get_buffer(), destination.get_buffer(), 1, &copyRegion);
 
-    end_quick_commands(commandBuffer);
-}
-
-Void Vulkan::begin_quick_commands(VkCommandBuffer& commandBuffer)
-{
-    VkCommandBufferAllocateInfo allocInfo{};
-    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-    allocInfo.commandPool = get_command_pool(graphicsPool);
-    allocInfo.commandBufferCount = 1;
-
-    vkAllocateCommandBuffers(logicalDevice.get_device(), &allocInfo, &commandBuffer);
-
-    VkCommandBufferBeginInfo beginInfo{};
-    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-
-    vkBeginCommandBuffer(commandBuffer, &beginInfo);
-}
-
-Void Vulkan::end_quick_commands(VkCommandBuffer commandBuffer)
-{
-    vkEndCommandBuffer(commandBuffer);
-
-    VkSubmitInfo submitInfo{};
-    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-    submitInfo.commandBufferCount = 1;
-    submitInfo.pCommandBuffers = &commandBuffer;
-
-    logicalDevice.submit_graphics_queue({ submitInfo }, VK_NULL_HANDLE);
-    logicalDevice.wait_graphics_queue_idle();
-
-    vkFreeCommandBuffers(logicalDevice.get_device(),
-                         get_command_pool(graphicsPool),
-                         1, &commandBuffer);
+    immediateContext.end_commands(logicalDevice, queueTimeline);
 }
 
 Void Vulkan::shutdown()
 {
+    flush_uploads();
+    wait_for_uploads();
+    immediateContext.wait_all(logicalDevice, queueTimeline);
+    wait_pending_pipelines();
+    for (PendingReload& pendingReload : pendingReloads)
+    {
+        pendingReload.future.wait();
+    }
+    update_pending_reloads();
     logicalDevice.wait_idle();
+    release_retired_pipelines();
     SPDLOG_INFO("Wait until frame end...");
+    SPDLOG_INFO("Pipelines: {} created on workers, render thread blocked for {:.3f} ms, longest block {:.3f} ms.",
+                asyncPipelinesCount,
+                Float64(pipelinesBlockingNanoseconds) / 1'000'000.0,
+                Float64(maxPipelineBlockingNanoseconds) / 1'000'000.0);
+
+    release_staging_buffers();
+    immediateContext.clear(logicalDevice, nullptr);
 
     for (Image& image : images)
     {
-        image.clear(logicalDevice, nullptr);
+        image.clear(logicalDevice, memoryAllocator, nullptr);
     }
     images.clear();
 
     for (Buffer& buffer : buffers)
     {
-        buffer.clear(logicalDevice, nullptr);
+        buffer.clear(logicalDevice, memoryAllocator, nullptr);
     }
     buffers.clear();
 
@@ -1468,19 +2713,31 @@ Void Vulkan::shutdown()
         descriptorPool.clear(logicalDevice, nullptr);
     }
     descriptorPools.clear();
+    descriptorLayoutCache.clear(logicalDevice, nullptr);
 
     for (Pipeline& pipeline : pipelines)
     {
         pipeline.clear(logicalDevice, nullptr);
     }
     pipelines.clear();
+    pipelineStateCache.clear();
+    pipelineCache.save(logicalDevice, PIPELINE_CACHE_PATH);
+    pipelineCache.clear(logicalDevice, nullptr);
 
     for (RenderPass& pass : renderPasses)
     {
-        pass.clear(logicalDevice, nullptr);
+        pass.clear(logicalDevice, memoryAllocator, nullptr);
     }
     renderPasses.clear();
 
+    const MemoryStatistics memoryStatistics = memoryAllocator.get_statistics();
+    SPDLOG_INFO("Device memory: {} blocks with {} bytes, {} dedicated allocations with {} bytes.",
+                memoryStatistics.blocksCount,
+                memoryStatistics.blocksBytes,
+                memoryStatistics.dedicatedAllocationsCount,
+                memoryStatistics.dedicatedBytes);
+    memoryAllocator.clear(logicalDevice, nullptr);
+
     swapchain.clear(logicalDevice, nullptr);
 
     for (const VkSemaphore semaphore : semaphores)
@@ -1494,19 +2751,26 @@ Void Vulkan::shutdown()
         vkDestroyFence(logicalDevice.get_device(), fence, nullptr);
     }
     fences.clear();
-
+    queueTimeline.clear(logicalDevice, nullptr);
+    frames.clear();
+    renderFinished.clear();
 
     for (Shader& shader : shaders)
     {
         shader.clear(logicalDevice, nullptr);
     }
     shaders.clear();
+    shaderDependents.clear();
 
     shaderSets.clear();
+    shaderPermutations.clear();
+    textureDescriptors.clear();
+    textureSlots.clear();
+    texturesSet = Handle<DescriptorSetData>::NONE;
 
     logicalDevice.clear(nullptr);
 
-    glslang::FinalizeProcess();
+    Shader::s_finalize_compiler();
 
     if constexpr (DebugMessenger::ENABLE_VALIDATION_LAYERS)
     {
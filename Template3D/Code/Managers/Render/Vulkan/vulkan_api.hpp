@@ -5,14 +5,23 @@
 #include "Common/swapchain.hpp"
 #include "Common/render_pass.hpp"
 #include "Common/descriptor_pool.hpp"
+#include "Common/descriptor_layout_cache.hpp"
 #include "Common/pipeline_vk.hpp"
 #include "Common/buffer_vk.hpp"
 #include "Common/command_buffer.hpp"
 #include "Common/shader_vk.hpp"
 #include "Common/shader_set_vk.hpp"
+#include "Common/shader_permutations_vk.hpp"
 #include "Common/image_vk.hpp"
+#include "Common/memory_allocator.hpp"
+#include "Common/immediate_context.hpp"
+#include "Common/queue_timeline.hpp"
+#include "Common/pipeline_cache.hpp"
+#include "Common/spirv_cache.hpp"
+#include "Render/Common/pipeline_state_cache.hpp"
 
 #include <vulkan/vulkan.hpp>
+#include <future>
 
 
 template<typename GraphicsAPI>
@@ -27,6 +36,10 @@ template<typename API>
 struct Texture;
 template<typename Type>
 struct Handle;
+class RenderQueue;
+class ThreadPool;
+struct DrawBatch;
+struct RenderQueueStatistics;
 
 enum class EShaderType : UInt8;
 
@@ -36,20 +49,93 @@ struct UniformBufferObject
     FMatrix4 viewProjection;
 };
 
-struct VertexConstants
+enum class EComputeQueue : UInt8
 {
-    FMatrix4 model;
+    // Ordered with draws by submission order
+    Graphics = 0U,
+    // Overlaps with rendering, next frame waits for its compute timeline value
+    Async,
+    Count
+};
+
+// Resources used by one frame recorded while previous ones could be still executed by GPU
+struct FrameResources
+{
+    Handle<CommandBuffer> commandBuffer;
+    // Graphics timeline value signaled by last submit of this frame
+    UInt64 submittedValue;
+    Handle<VkSemaphore> imageAvailable;
+    Handle<BufferVK> uniformBuffer;
+    // Storage buffer with transforms of all instances drawn in frame
+    Handle<BufferVK> instanceBuffer;
+    UInt32 instancesCount;
+    String uniformSetName;
+    // Secondary buffers, each one has own pool so slices of draws could be recorded on different threads
+    DynamicArray<Handle<VkCommandPool>> recordingPools;
+    DynamicArray<Handle<CommandBuffer>> recordingBuffers;
+    UInt32 usedRecordingBuffersCount;
+};
+
+// Pipeline created on worker thread, its handle points to placeholder until it is finished
+struct PendingPipeline
+{
+    Handle<PipelineVK> handle;
+    // Creation time is known after worker finishes, so state cache entry is updated then
+    DynamicArray<UInt64> state;
+    std::future<PipelineVK> future;
+};
+
+// Shaders and pipeline of shader set rebuilt on worker thread from current shader files
+struct ReloadedShaderSet
+{
+    Bool isValid = false;
+    // In order of shader handles of set, they have own modules
+    DynamicArray<ShaderVK> shaders;
+    PipelineVK pipeline;
+};
+
+struct PendingReload
+{
+    Handle<ShaderSetVK> shaderSetHandle;
+    std::future<ReloadedShaderSet> future;
+};
+
+// Objects replaced by reload, destroyed when every submit made before replacement is finished
+struct RetiredPipeline
+{
+    UInt64 graphicsValue;
+    UInt64 computeValue;
+    PipelineVK pipeline;
+    DynamicArray<ShaderVK> shaders;
 };
 
 class Vulkan
 {
 public:
     const String SHADERS_PATH = "Resources/Shaders/";
+    const String PIPELINE_CACHE_PATH = "Resources/Cache/pipeline_cache.bin";
+    const String SPIRV_CACHE_PATH = "Resources/Cache/Spirv/";
+    const String ALPHA_TEST_KEYWORD = "ALPHA_TEST";
+    const String FRAME_LAYOUT_NAME = "FrameData";
+    const String TEXTURE_LAYOUT_NAME = "TextureData";
+    const String TEXTURES_SET_NAME = "Textures";
     using Buffer = BufferVK;
     using Image = ImageVK;
     using Shader = ShaderVK;
     using Pipeline = PipelineVK;
     using ShaderSet = ShaderSetVK;
+    using ShaderPermutations = ShaderPermutationsVK;
+
+    static constexpr UInt32 DEFAULT_FRAMES_IN_FLIGHT = 2;
+    static constexpr UInt32 MAX_FRAMES_IN_FLIGHT = 3;
+    static constexpr UInt32 MAX_INSTANCES_COUNT = 16384;
+    // Smaller slices are not worth of recording on another thread
+    static constexpr UInt64 MIN_BATCHES_PER_SLICE = 64;
+    static constexpr UInt64 STAGING_BUFFER_SIZE = 32ULL * 1024ULL * 1024ULL;
+    // Satisfies optimalBufferCopyOffsetAlignment on common devices and alignment of every vertex type
+    static constexpr UInt64 STAGING_ALIGNMENT = 256;
+    // Variant key is bit mask of keywords
+    static constexpr UInt64 MAX_SHADER_KEYWORDS_COUNT = 64;
 
 private:
     VkInstance instance;
@@ -57,6 +143,7 @@ private:
 
     PhysicalDevice physicalDevice;
     LogicalDevice logicalDevice;
+    MemoryAllocator memoryAllocator;
 
     // TODO: think about make it more related with display manager
     VkSurfaceKHR surface;
@@ -64,14 +151,38 @@ private:
 
     DynamicArray<RenderPass> renderPasses;
     DynamicArray<DescriptorPool> descriptorPools;
+    DescriptorLayoutCache descriptorLayoutCache;
 
     DynamicArray<Shader> shaders;
     HashMap<String, Handle<Shader>> shadersNameMap;
+    // Shader ids by source file and headers they read, editing one file reloads only sets using its dependents
+    HashMap<String, Set<UInt64>> shaderDependents;
+    SpirvCache spirvCache;
     DynamicArray<Pipeline> pipelines;
+    PipelineStateCache<Pipeline> pipelineStateCache;
+    // Pipelines created on worker threads, they are moved to their handles when finished
+    DynamicArray<PendingPipeline> pendingPipelines;
+    UInt64 asyncPipelinesCount = 0;
+    DynamicArray<PendingReload> pendingReloads;
+    DynamicArray<RetiredPipeline> retiredPipelines;
+    // Time render thread spent creating or waiting for pipelines
+    UInt64 pipelinesBlockingNanoseconds = 0;
+    UInt64 maxPipelineBlockingNanoseconds = 0;
     DynamicArray<ShaderSet> shaderSets;
+    DynamicArray<ShaderPermutations> shaderPermutations;
+    // Materials without own shader set get its variant with only used features
+    Handle<ShaderPermutations> defaultPermutations;
+    PipelineCache pipelineCache;
+
+    // Every submit signals timeline of its queue, binary semaphores are left for swapchain only
+    QueueTimeline queueTimeline;
 
     Handle<VkCommandPool> graphicsPool;
     DynamicArray<VkCommandPool> commandPools;
+    // One time commands like layout transitions and texture copies, batched while uploads batch is open
+    ImmediateContext immediateContext;
+    // Staging buffers released when immediate submission with given value is completed
+    DynamicArray<Pair<UInt64, Buffer>> retiredStagingBuffers;
 
     DynamicArray<CommandBuffer> commandBuffers;
     HashMap<String, Handle<CommandBuffer>> commandBuffersNameMap;
@@ -80,21 +191,62 @@ private:
     HashMap<String, Handle<Buffer>> buffersNameMap;
     DynamicArray<Image> images;
 
-    Handle<VkFence> inFlightFence;
     DynamicArray<VkFence> fences;
     HashMap<String, Handle<VkFence>> fencesNameMap;
 
-    Handle<VkSemaphore> imageAvailable;
-    Handle<VkSemaphore> renderFinished;
     DynamicArray<VkSemaphore> semaphores;
     HashMap<String, Handle<VkSemaphore>> semaphoresNameMap;
 
-    Bool isFrameEven;
+    // Every texture image is written once to its slot of one bindless set, draws push slot of their material
+    DynamicArray<VkDescriptorImageInfo> textureDescriptors;
+    // Slots by image id
+    HashMap<UInt64, UInt32> textureSlots;
+    Handle<DescriptorSetData> texturesSet = Handle<DescriptorSetData>::NONE;
+    UInt32 defaultTextureSlot = 0;
+
+    DynamicArray<FrameResources> frames;
+    // Presentation waits on semaphore of acquired image, so it is not signaled again before present consumed it
+    DynamicArray<Handle<VkSemaphore>> renderFinished;
+    UInt32 framesInFlight = DEFAULT_FRAMES_IN_FLIGHT;
+    UInt32 frameIndex = 0;
+    Bool isFrameStarted = false;
+    Handle<RenderPass> frameRenderPass;
+
+    // Persistently mapped ring, uploads are copied in and recorded into one command buffer until flush
+    Handle<Buffer> stagingBuffer;
+    // Upload buffer belongs to transfer family, acquire buffer takes ownership back on graphics queue
+    Handle<VkCommandPool> transferPool;
+    Handle<CommandBuffer> uploadCommandBuffer;
+    Handle<CommandBuffer> acquireCommandBuffer;
+    // Destinations of recorded copies, they need ownership transfer barriers
+    DynamicArray<VkBuffer> uploadedBuffers;
+    DynamicArray<Handle<Image>> uploadedImages;
+    // Graphics timeline value of acquire submit with dedicated transfer family,
+    // otherwise uploads are recorded into immediate context and it is value of its batch
+    UInt64 uploadValue = 0;
+    UInt64 stagingOffset = 0;
+    UInt32 uploadsBatchDepth = 0;
+    Bool isUploadRecorded = false;
+    Bool isUploadPending = false;
+
+    // Compute work of each queue is recorded into own buffer, timeline value tells when buffer could be recorded again
+    Handle<VkCommandPool> computePool;
+    Array<Handle<CommandBuffer>, UInt64(EComputeQueue::Count)> computeCommandBuffers;
+    Array<UInt64, UInt64(EComputeQueue::Count)> computeValues;
+    EComputeQueue recordedComputeQueue = EComputeQueue::Count;
 
 public:
+    // Has to be called before startup, count is clamped to one to MAX_FRAMES_IN_FLIGHT range
+    Void set_frames_in_flight(UInt32 count);
     Void startup(Simulation<Vulkan>& simulation);
 
-    Void draw_model(Simulation<Vulkan>& simulation, const Model<Vulkan>& model);
+    // Acquires image and begins render pass, returns false when frame has to be skipped
+    Bool begin_frame(Simulation<Vulkan>& simulation);
+    // Records slices of sorted queue batches into secondary buffers on thread pool,
+    // could be called many times between begin_frame and end_frame
+    Void draw_queue(Simulation<Vulkan>& simulation, RenderQueue& queue);
+    // Executes recorded secondary buffers in order, submits frame once and presents it
+    Void end_frame(Simulation<Vulkan>& simulation);
 
 
     Handle<Shader> create_shader(const String& filePath, 
@@ -104,11 +256,49 @@ public:
                                  const String& shaderCode,
                                  EShaderType shaderType,
                                  const String& functionName = "main");
-
-    Handle<Pipeline> create_pipeline(const ShaderSet& shaderSet);
+    // Compiles all shaders on thread pool, modules are created afterwards on calling thread,
+    // handles are returned in order of descriptions
+    DynamicArray<Handle<Shader>> create_shaders(Simulation<Vulkan>& simulation,
+                                                const DynamicArray<ShaderDescription>& descriptions);
+
+    // With thread pool pipeline is created on worker and its handle is not ready until begin_frame
+    // after it finishes, draws of it use fallback of shader set meanwhile
+    Handle<Pipeline> create_pipeline(const ShaderSet& shaderSet, ThreadPool* threadPool = nullptr);
     Handle<ShaderSet> create_shader_set(const ShaderSet& shaderSet);
-
-
+    Handle<ShaderPermutations> create_shader_permutations(const ShaderPermutations& permutations);
+    // Undeclared keywords are skipped with warning
+    [[nodiscard]]
+    UInt64 get_variant_key(Handle<ShaderPermutations> handle, const DynamicArray<String>& enabledKeywords);
+    // Shaders and pipeline of variant are created on first request, later requests return the same set
+    Handle<ShaderSet> get_shader_variant(Simulation<Vulkan>& simulation,
+                                         Handle<ShaderPermutations> handle,
+                                         UInt64 variantKey);
+    // Compute set has own descriptor pool with one binding per given type in set 0,
+    // push constants are visible for compute stage when size is not zero
+    Handle<ShaderSet> create_compute_shader_set(Handle<Shader> shaderHandle,
+                                                const DynamicArray<VkDescriptorType>& bindings,
+                                                UInt32 constantsSize = 0);
+    // Resources are in bindings order
+    Handle<DescriptorSetData> create_compute_set(Handle<ShaderSet> shaderSetHandle,
+                                                 const DynamicArray<DescriptorResourceInfo>& resources,
+                                                 const String& name);
+    [[nodiscard]]
+    DescriptorResourceInfo get_storage_resource(Handle<Buffer> bufferHandle);
+    // Image is transitioned to general layout, storage images are accessed only in it
+    DescriptorResourceInfo get_storage_resource(Handle<Image> imageHandle);
+
+    // Dispatches between begin_compute and end_compute are recorded into one buffer and submitted once
+    Void begin_compute(EComputeQueue queue);
+    Void dispatch(Handle<ShaderSet> shaderSetHandle,
+                  Handle<DescriptorSetData> setHandle,
+                  const UVector3& groupCount,
+                  const Void* constants = nullptr);
+    Void end_compute();
+
+
+    // Uploads and texture commands between begin_uploads and end_uploads are submitted together without waiting, calls can be nested
+    Void begin_uploads();
+    Void end_uploads();
     Void create_model_render_data(Simulation<Vulkan>& simulation, Model<Vulkan>& model);
     Void create_mesh_buffers(Mesh<Vulkan>& mesh);
     Void create_material_images(Simulation<Vulkan>& simulation, Material<Vulkan>& material);
@@ -130,18 +320,12 @@ public:
         const Handle<Buffer> handle = { buffers.size() };
         Buffer& buffer = buffers.emplace_back();
 
-        buffer.create(physicalDevice,
-                      logicalDevice,
+        buffer.create(logicalDevice,
+                      memoryAllocator,
                       bufferSize,
                       usage,
                       properties,
                       nullptr);
-        vkMapMemory(logicalDevice.get_device(), 
-                    buffer.get_memory(), 
-                    0,
-                    bufferSize, 
-                    0, 
-                    buffer.get_mapped_memory());
 
         return handle;
     }
@@ -170,32 +354,19 @@ public:
     {
         const UInt64 bufferSize = sizeof(Type) * data.size();
 
-        Buffer stagingBuffer{};
-        stagingBuffer.create(physicalDevice,
-                             logicalDevice,
-                             bufferSize,
-                             VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                             VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                             nullptr);
-
-        Void* addressToGPU;
-        vkMapMemory(logicalDevice.get_device(), stagingBuffer.get_memory(), 0, bufferSize, 0, &addressToGPU);
-        memcpy(addressToGPU, data.data(), bufferSize);
-        vkUnmapMemory(logicalDevice.get_device(), stagingBuffer.get_memory());
-
         const Handle<Buffer> handle = { buffers.size() };
         Buffer& buffer = buffers.emplace_back();
 
-        buffer.create(physicalDevice,
-                      logicalDevice,
+        // Static buffers are only read by draws, so defragmentation can move them, handle is kept as user data
+        buffer.create(logicalDevice,
+                      memoryAllocator,
                       bufferSize,
                       VK_BUFFER_USAGE_TRANSFER_DST_BIT | usage,
                       properties,
-                      nullptr);
+                      nullptr,
+                      handle.id + 1);
 
-        copy_buffer(stagingBuffer, buffer);
-
-        stagingBuffer.clear(logicalDevice, nullptr);
+        upload_buffer(data.data(), bufferSize, buffer);
 
         return handle;
     }
@@ -224,6 +395,7 @@ public:
     Handle<DescriptorPool> create_descriptor_pool();
 
     Handle<VkCommandPool> create_command_pool(VkCommandPoolCreateFlagBits flags);
+    Handle<VkCommandPool> create_command_pool(VkCommandPoolCreateFlagBits flags, UInt32 queueFamilyIndex);
     Void create_command_buffers(Handle<VkCommandPool> handle, VkCommandBufferLevel level, const DynamicArray<String>& names);
     Void create_command_buffers(VkCommandPool pool, VkCommandBufferLevel level, const DynamicArray<String>& names);
 
@@ -232,7 +404,11 @@ public:
 
 
     Void recreate_swapchain(Simulation<Vulkan>& simulation);
-    Void reload_shaders(ShaderSet& shaderSet);
+    // Shaders are recompiled and pipeline is rebuilt on thread pool, the set keeps drawing with old ones
+    // until begin_frame after that finishes, failed reload keeps old ones
+    Void reload_shaders(Simulation<Vulkan>& simulation, Handle<ShaderSet> shaderSetHandle);
+    // Reloads shader sets with shader reading given file as source or header, shared pipelines are rebuilt once
+    Void reload_dependents(Simulation<Vulkan>& simulation, const String& filePath);
     Void resize_image(const UVector2& newSize, Handle<Image> image);
     Void transition_image_layout(Image& image,
                                  VkPipelineStageFlags sourceStage,
@@ -241,6 +417,12 @@ public:
 
     
 
+    [[nodiscard]]
+    UInt32 get_frames_in_flight() const;
+    [[nodiscard]]
+    UInt32 get_frame_index() const;
+    FrameResources& get_current_frame();
+
     [[nodiscard]]
     VkSurfaceKHR get_surface() const;
     [[nodiscard]]
@@ -255,6 +437,7 @@ public:
     Shader& get_shader(const Handle<Shader> handle);
     Pipeline& get_pipeline(const Handle<Pipeline> handle);
     ShaderSet& get_shader_set(const Handle<ShaderSet> handle);
+    ShaderPermutations& get_shader_permutations(const Handle<ShaderPermutations> handle);
 
     [[nodiscard]]
     const Handle<CommandBuffer>& get_command_buffer_handle(const String& name)  const;
@@ -285,10 +468,60 @@ public:
     DescriptorPool& get_descriptor_pool(const Handle<DescriptorPool> handle);
     DescriptorPool& get_default_descriptor_pool();
 
+    // Moves static buffers out of least used memory blocks and releases emptied blocks, waits for all submitted work
+    Void defragment_memory(UInt64 maxBytesToMove);
+    [[nodiscard]]
+    MemoryStatistics get_memory_statistics();
+    [[nodiscard]]
+    SpirvCacheStatistics get_spirv_cache_statistics() const;
+
     Void shutdown();
 
 private:
-    Void create_default_descriptors();
+    Void create_frames();
+    Void create_staging_buffer();
+    Void create_compute_resources();
+    // Copies data to staging ring and records copy, submits at once when no uploads batch is open
+    Void upload_buffer(const Void* data, UInt64 size, const Buffer& destination);
+    // Submits recorded uploads without waiting, graphics queue waits for them on transfer timeline
+    Void flush_uploads();
+    // Waits until staging ring and upload command buffers are not used by device
+    Void wait_for_uploads();
+    // Buffer is cleared after commands recorded now in immediate context are finished
+    Void retire_staging_buffer(const Buffer& buffer);
+    Void release_staging_buffers();
+    Void create_present_semaphores();
+    Void reserve_recording_buffers(FrameResources& frame, UInt32 count);
+    // Moves finished pipelines to their handles without waiting for the rest
+    Void update_pending_pipelines();
+    // Calling thread only waits, so it must not be called from task of thread pool
+    Void wait_pending_pipelines();
+    Void record_blocking_time(UInt64 nanoseconds);
+    // Swaps finished reloads in, replaced pipeline and shaders are retired
+    Void update_pending_reloads();
+    // Stale entries of removed headers are kept, they only cause extra reload
+    Void register_dependencies(Handle<Shader> shaderHandle);
+    Void release_retired_pipelines();
+    Void record_batches(Simulation<Vulkan>& simulation,
+                        const CommandBuffer& commandBuffer,
+                        const FrameResources& frame,
+                        const DynamicArray<DrawBatch>& batches,
+                        UInt64 beginBatch,
+                        UInt64 endBatch,
+                        UInt32 firstInstance,
+                        UInt32 instancesCount,
+                        RenderQueueStatistics& statistics);
+    // Layouts and push constants of pool are built from merged reflection of given shaders
+    Void create_reflected_layouts(DescriptorPool& descriptorPool,
+                                  const DynamicArray<Handle<Shader>>& shaderHandles,
+                                  const DynamicArray<String>& layoutNames,
+                                  VkDescriptorBindingFlags bindingFlags);
+    // Images registered before setup_default_descriptors are written when textures set is created
+    Void register_texture(Handle<Image> imageHandle);
+    // Slot of material albedo, default texture slot when it was not registered
+    [[nodiscard]]
+    UInt32 get_texture_slot(Simulation<Vulkan>& simulation, UInt64 materialId) const;
+    Void assign_material_variant(Simulation<Vulkan>& simulation, Material<Vulkan>& material);
     Void setup_default_descriptors(Simulation<Vulkan>& simulation);
     Void create_vulkan_instance();
     Void create_surface(Simulation<Vulkan>& simulation);
@@ -296,8 +529,7 @@ private:
 
     Void generate_mipmaps(Image& image);
     Void copy_buffer_to_image(const Buffer& buffer, Image& image);
+    Void copy_buffer_to_image(VkCommandBuffer commandBuffer, const Buffer& buffer, Image& image);
     Void copy_image_to_buffer(Buffer& buffer, Image& image);
-    Void copy_buffer(const Buffer& source, Buffer& destination);
-    Void begin_quick_commands(VkCommandBuffer& commandBuffer);
-    Void end_quick_commands(VkCommandBuffer commandBuffer);
+    Void copy_buffer(const Buffer& source, const Buffer& destination);
 };
\ No newline at end of file
@@ -1,22 +1,212 @@
 #pragma once
 #include "Common/graphics_api_concept.hpp"
+#include "Common/frustum_culler.hpp"
+#include "Common/occlusion_culler.hpp"
+#include "Common/render_queue.hpp"
+#include "Resource/Common/bvh.hpp"
+
+template <typename API>
+struct Mesh;
 
 template <GraphicsAPI API>
 class RenderManager
 {
+public:
+    //TODO: move it to camera when there will be one
+    static constexpr Float32 NEAR_PLANE = 0.001f;
+    static constexpr Float32 FAR_PLANE  = 5000.0f;
+
 private:
     API api;
+    FrustumCuller frustumCuller;
+    OcclusionCuller occlusionCuller;
+    // Occluder mesh id and mesh rasterized in its place, proxy has to fit inside of occluder
+    HashMap<UInt64, Handle<Mesh<API>>> occluders;
+    // Submitted draws waiting for culling, index in this array is id of their scene instance
+    DynamicArray<DrawItem> candidates;
+    // Scene instances of last submitted draws and those which passed hierarchy culling,
+    // index in visible instances is index of bounds in frustum culler
+    DynamicArray<Handle<BVHInstance>> sceneInstances;
+    DynamicArray<Handle<BVHInstance>> visibleInstances;
+    RenderQueue renderQueue;
+    FMatrix4 viewProjection{ 1.0f };
 
 public:
     Void startup(Simulation<API>& simulation)
     {
         SPDLOG_INFO("Render Manager startup.");
         api.startup(simulation);
+        occlusionCuller.set_resolution(OcclusionCuller::DEFAULT_WIDTH, OcclusionCuller::DEFAULT_HEIGHT);
     }
 
+    Void add_occluder(Handle<Mesh<API>> meshHandle, Handle<Mesh<API>> proxyHandle = Handle<Mesh<API>>::NONE)
+    {
+        occluders[meshHandle.id] = proxyHandle.id != Handle<Mesh<API>>::NONE.id ? proxyHandle : meshHandle;
+    }
+
+    Void clear_occluders()
+    {
+        occluders.clear();
+    }
+
+    // Only submits model, all submitted models are drawn together on render
     Void draw_model(Simulation<API>& simulation, Model<API> &model)
     {
-        api.draw_model(simulation, model);
+        static Float32 rot = 0.0f;
+        const FMatrix4 transform = glm::rotate(FMatrix4(1.0f), glm::radians(rot), { 0.0f, 1.0f, 0.0f });
+        rot += 0.01f;
+
+        submit(simulation, model, transform);
+    }
+
+    // Meshes of model are culled and queued on render
+    Void submit(Simulation<API>& simulation, const Model<API>& model, const FMatrix4& transform)
+    {
+        const UInt32 transformIndex = renderQueue.add_transform(transform);
+        for (UInt64 i = 0; i < model.meshes.size(); ++i)
+        {
+            DrawItem& candidate = candidates.emplace_back();
+            candidate.key            = 0;
+            candidate.meshId         = model.meshes[i].id;
+            candidate.materialId     = model.materials[i].id;
+            candidate.shaderSetId    = simulation.resourceManager.get_material(model.materials[i]).shaderSetHandle.id;
+            candidate.transformIndex = transformIndex;
+        }
+    }
+
+    // Culls all submitted draws and records them in one frame
+    Void render(Simulation<API>& simulation)
+    {
+        const FMatrix4 projection = glm::perspective(glm::radians(70.0f),
+                                                     simulation.displayManager.get_aspect_ratio(),
+                                                     NEAR_PLANE,
+                                                     FAR_PLANE);
+        const FMatrix4 view = glm::lookAt(FVector3{ 0.0f, 0.0f, -10.0f },
+                                          FVector3{ 0.0f, 0.0f, 0.0f },
+                                          FVector3{ 0.0f, 1.0f, 0.0f });
+        viewProjection = projection * view;
+
+        frustumCuller.set_frustum(viewProjection);
+        update_scene(simulation);
+
+        // Hierarchy rejects whole groups of instances, only remaining ones are tested one by one
+        visibleInstances.clear();
+        simulation.resourceManager.get_scene_bvh().cull(frustumCuller.get_planes(), visibleInstances);
+        for (const Handle<BVHInstance> instanceHandle : visibleInstances)
+        {
+            const DrawItem& candidate = candidates[instanceHandle.id];
+            const Mesh<API>& mesh = simulation.resourceManager.get_mesh(Handle<Mesh<API>>{ candidate.meshId });
+            frustumCuller.add_bounds(mesh.boundingBox,
+                                     mesh.boundingSphere,
+                                     renderQueue.get_transform(candidate.transformIndex));
+        }
+        frustumCuller.cull(&simulation.threadPool);
+
+        const Bool hasOccluders = !occluders.empty();
+        if (hasOccluders)
+        {
+            occlusionCuller.begin_frame(viewProjection);
+            for (UInt64 i = 0; i < visibleInstances.size(); ++i)
+            {
+                const DrawItem& candidate = candidates[visibleInstances[i].id];
+                const auto& iterator = occluders.find(candidate.meshId);
+                if (iterator == occluders.end() || !frustumCuller.is_visible(i))
+                {
+                    continue;
+                }
+
+                const Mesh<API>& mesh = simulation.resourceManager.get_mesh(iterator->second);
+                occlusionCuller.add_occluder(mesh.vertexes,
+                                             mesh.indexes,
+                                             renderQueue.get_transform(candidate.transformIndex));
+            }
+            occlusionCuller.rasterize(&simulation.threadPool);
+        }
+
+        for (UInt64 i = 0; i < visibleInstances.size(); ++i)
+        {
+            if (!frustumCuller.is_visible(i))
+            {
+                continue;
+            }
+
+            const DrawItem& candidate = candidates[visibleInstances[i].id];
+            const FMatrix4& transform = renderQueue.get_transform(candidate.transformIndex);
+            const Mesh<API>& mesh = simulation.resourceManager.get_mesh(Handle<Mesh<API>>{ candidate.meshId });
+            if (hasOccluders && !occlusionCuller.test_bounds(mesh.boundingBox, transform))
+            {
+                continue;
+            }
+
+            const FVector4 center = viewProjection * transform * FVector4(mesh.boundingBox.get_center(), 1.0f);
+            renderQueue.submit(EDrawPass::Opaque,
+                               candidate.shaderSetId,
+                               candidate.materialId,
+                               candidate.meshId,
+                               candidate.transformIndex,
+                               center.w / FAR_PLANE);
+        }
+
+        renderQueue.sort();
+        renderQueue.build_batches();
+        if (api.begin_frame(simulation))
+        {
+            api.draw_queue(simulation, renderQueue);
+            api.end_frame(simulation);
+        }
+
+        renderQueue.clear();
+        frustumCuller.clear();
+        candidates.clear();
+    }
+
+    // Casts ray from camera through position in window pixels against draws of last rendered frame,
+    // mesh of hit instance is in scene hierarchy of resource manager
+    Bool pick(Simulation<API>& simulation, const FVector2& position, RayHit& hit) const
+    {
+        const IVector2 windowSize = simulation.displayManager.get_window_size();
+        const FVector2 clipPosition{ 2.0f * position.x / Float32(windowSize.x) - 1.0f,
+                                     2.0f * position.y / Float32(windowSize.y) - 1.0f };
+        const FMatrix4 inverseViewProjection = glm::inverse(viewProjection);
+        FVector4 nearPoint = inverseViewProjection * FVector4(clipPosition.x, clipPosition.y, -1.0f, 1.0f);
+        FVector4 farPoint  = inverseViewProjection * FVector4(clipPosition.x, clipPosition.y, 1.0f, 1.0f);
+        nearPoint /= nearPoint.w;
+        farPoint  /= farPoint.w;
+
+        Ray ray;
+        ray.origin    = FVector3(nearPoint);
+        ray.direction = glm::normalize(FVector3(farPoint) - FVector3(nearPoint));
+        return simulation.resourceManager.ray_cast(ray, hit);
+    }
+
+    [[nodiscard]]
+    const FMatrix4& get_view_projection() const
+    {
+        return viewProjection;
+    }
+
+    [[nodiscard]]
+    const CullingStatistics& get_culling_statistics() const
+    {
+        return frustumCuller.get_statistics();
+    }
+
+    [[nodiscard]]
+    const CullingStatistics& get_occlusion_statistics() const
+    {
+        return occlusionCuller.get_statistics();
+    }
+
+    [[nodiscard]]
+    const RenderQueueStatistics& get_render_statistics() const
+    {
+        return renderQueue.get_statistics();
+    }
+
+    Void reset_culling_statistics()
+    {
+        frustumCuller.reset_statistics();
+        occlusionCuller.reset_statistics();
     }
 
     API& get_api()
@@ -26,7 +216,73 @@ public:
 
     Void shutdown()
     {
+        const CullingStatistics& statistics = frustumCuller.get_statistics();
+        SPDLOG_INFO("Frustum culling: tested {}, culled {}, drawn {}.",
+                    statistics.testedCount,
+                    statistics.culledCount,
+                    statistics.drawnCount);
+        const CullingStatistics& occlusionStatistics = occlusionCuller.get_statistics();
+        SPDLOG_INFO("Occlusion culling: tested {}, culled {}, drawn {}.",
+                    occlusionStatistics.testedCount,
+                    occlusionStatistics.culledCount,
+                    occlusionStatistics.drawnCount);
+        const RenderQueueStatistics& renderStatistics = renderQueue.get_statistics();
+        SPDLOG_INFO("Render queue: draws {}, instances {}, pipeline binds {} (saved {}), "
+                    "material binds {} (saved {}), mesh binds {} (saved {}), "
+                    "fallback draws {}, skipped draws {}.",
+                    renderStatistics.drawsCount,
+                    renderStatistics.instancesCount,
+                    renderStatistics.pipelineBindsCount,
+                    renderStatistics.pipelineBindsSaved,
+                    renderStatistics.materialBindsCount,
+                    renderStatistics.materialBindsSaved,
+                    renderStatistics.meshBindsCount,
+                    renderStatistics.meshBindsSaved,
+                    renderStatistics.fallbackDrawsCount,
+                    renderStatistics.skippedDrawsCount);
+        occluders.clear();
+        candidates.clear();
+        sceneInstances.clear();
+        visibleInstances.clear();
+        renderQueue.clear();
         SPDLOG_INFO("Render Manager shutdown.");
         api.shutdown();
     }
-};
\ No newline at end of file
+
+private:
+    // Instances are kept while the same meshes are submitted in the same order, then only moved ones are refitted
+    Void update_scene(Simulation<API>& simulation)
+    {
+        ResourceManager<API>& resourceManager = simulation.resourceManager;
+        const SceneBVH& sceneBVH = resourceManager.get_scene_bvh();
+
+        Bool isSceneChanged = sceneInstances.size() != candidates.size();
+        for (UInt64 i = 0; i < candidates.size() && !isSceneChanged; ++i)
+        {
+            isSceneChanged = sceneBVH.get_instance(sceneInstances[i]).meshId != candidates[i].meshId;
+        }
+
+        if (isSceneChanged)
+        {
+            // Instances are created in order of candidates, so id of instance is index of its candidate
+            resourceManager.clear_instances();
+            sceneInstances.clear();
+            for (const DrawItem& candidate : candidates)
+            {
+                sceneInstances.push_back(resourceManager.create_instance(Handle<Mesh<API>>{ candidate.meshId },
+                                                                         renderQueue.get_transform(candidate.transformIndex)));
+            }
+        } else {
+            for (UInt64 i = 0; i < candidates.size(); ++i)
+            {
+                const FMatrix4& transform = renderQueue.get_transform(candidates[i].transformIndex);
+                if (sceneBVH.get_instance(sceneInstances[i]).transform != transform)
+                {
+                    resourceManager.set_instance_transform(sceneInstances[i], transform);
+                }
+            }
+        }
+
+        resourceManager.update_scene_bvh(simulation.threadPool);
+    }
+};
@@ -0,0 +1,92 @@
+#pragma once
+
+struct BoundingBox
+{
+    FVector3 minimum;
+    FVector3 maximum;
+
+    BoundingBox()
+        : minimum(0.0f)
+        , maximum(0.0f)
+    {}
+
+    BoundingBox(const FVector3& minimum, const FVector3& maximum)
+        : minimum(minimum)
+        , maximum(maximum)
+    {}
+
+    Void grow(const FVector3& point)
+    {
+        minimum = glm::min(minimum, point);
+        maximum = glm::max(maximum, point);
+    }
+
+    Void grow(const BoundingBox& box)
+    {
+        minimum = glm::min(minimum, box.minimum);
+        maximum = glm::max(maximum, box.maximum);
+    }
+
+    [[nodiscard]]
+    FVector3 get_center() const
+    {
+        return (minimum + maximum) * 0.5f;
+    }
+
+    [[nodiscard]]
+    FVector3 get_extent() const
+    {
+        return (maximum - minimum) * 0.5f;
+    }
+
+    [[nodiscard]]
+    Float32 get_surface_area() const
+    {
+        const FVector3 size = maximum - minimum;
+        if (size.x < 0.0f || size.y < 0.0f || size.z < 0.0f)
+        {
+            return 0.0f;
+        }
+        return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+    }
+
+    [[nodiscard]]
+    Bool overlaps(const BoundingBox& box) const
+    {
+        return minimum.x <= box.maximum.x && maximum.x >= box.minimum.x
+            && minimum.y <= box.maximum.y && maximum.y >= box.minimum.y
+            && minimum.z <= box.maximum.z && maximum.z >= box.minimum.z;
+    }
+
+    // Box around transformed corners, computed from absolute matrix instead of all 8 corners
+    [[nodiscard]]
+    BoundingBox transformed(const FMatrix4& matrix) const
+    {
+        const FVector3 center = FVector3(matrix * FVector4(get_center(), 1.0f));
+        const FVector3 localExtent = get_extent();
+        FVector3 extent{ 0.0f };
+        for (Int32 column = 0; column < 3; ++column)
+        {
+            extent += FVector3(glm::abs(matrix[column])) * localExtent[column];
+        }
+
+        return { center - extent, center + extent };
+    }
+
+    // Inverted box, growing it by anything gives that thing bounds
+    static BoundingBox s_empty()
+    {
+        return { FVector3(Limits<Float32>::max()), FVector3(Limits<Float32>::lowest()) };
+    }
+};
+
+struct BoundingSphere
+{
+    FVector3 center;
+    Float32 radius;
+
+    BoundingSphere()
+        : center(0.0f)
+        , radius(0.0f)
+    {}
+};
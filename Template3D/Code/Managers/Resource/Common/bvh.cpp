@@ -0,0 +1,732 @@
+#include "bvh.hpp"
+
+#include "vertex.hpp"
+#include "Utilities/thread_pool.hpp"
+
+#include <atomic>
+
+
+struct BVH::BuildContext
+{
+    const DynamicArray<BoundingBox>& primitivesBounds;
+    DynamicArray<FVector3> centroids;
+    std::atomic<UInt32> nodesCount;
+    ThreadPool* threadPool;
+};
+
+struct BVHBin
+{
+    BoundingBox bounds = BoundingBox::s_empty();
+    UInt32 count = 0;
+};
+
+Void BVH::build(const DynamicArray<BoundingBox>& primitivesBounds, ThreadPool* threadPool)
+{
+    clear();
+    const UInt32 primitivesCount = UInt32(primitivesBounds.size());
+    if (primitivesCount == 0)
+    {
+        return;
+    }
+
+    BuildContext context{ primitivesBounds, {}, { 1U }, threadPool };
+    context.centroids.resize(primitivesCount);
+    primitiveIndexes.resize(primitivesCount);
+    for (UInt32 i = 0; i < primitivesCount; ++i)
+    {
+        context.centroids[i] = primitivesBounds[i].get_center();
+        primitiveIndexes[i] = i;
+    }
+
+    // Binary tree with one primitive per leaf is upper bound, so nodes never get reallocated while building
+    nodes.resize(2ULL * primitivesCount - 1ULL);
+    BVHNode& root = nodes[0];
+    root.leftOrFirst = 0;
+    root.count = primitivesCount;
+    update_node_bounds(root, primitivesBounds);
+    subdivide(0, 0, context);
+
+    nodes.resize(context.nodesCount.load());
+    nodes.shrink_to_fit();
+}
+
+Void BVH::refit(const DynamicArray<BoundingBox>& primitivesBounds)
+{
+    for (UInt64 i = nodes.size(); i > 0; --i)
+    {
+        BVHNode& node = nodes[i - 1];
+        if (node.is_leaf())
+        {
+            update_node_bounds(node, primitivesBounds);
+            continue;
+        }
+
+        const BVHNode& left  = nodes[node.leftOrFirst];
+        const BVHNode& right = nodes[node.leftOrFirst + 1];
+        node.minimum = glm::min(left.minimum, right.minimum);
+        node.maximum = glm::max(left.maximum, right.maximum);
+    }
+}
+
+Void BVH::clear()
+{
+    nodes.clear();
+    primitiveIndexes.clear();
+}
+
+Bool BVH::is_empty() const
+{
+    return nodes.empty();
+}
+
+const DynamicArray<BVHNode>& BVH::get_nodes() const
+{
+    return nodes;
+}
+
+const DynamicArray<UInt32>& BVH::get_primitive_indexes() const
+{
+    return primitiveIndexes;
+}
+
+Float32 BVH::s_intersect_box(const BVHNode& node,
+                             const FVector3& origin,
+                             const FVector3& inverseDirection,
+                             Float32 maxDistance)
+{
+    const FVector3 first  = (node.minimum - origin) * inverseDirection;
+    const FVector3 second = (node.maximum - origin) * inverseDirection;
+    const FVector3 nearest  = glm::min(first, second);
+    const FVector3 farthest = glm::max(first, second);
+    const Float32 entry = std::max({ nearest.x, nearest.y, nearest.z, 0.0f });
+    const Float32 exit  = std::min({ farthest.x, farthest.y, farthest.z, maxDistance });
+
+    return entry <= exit ? entry : Limits<Float32>::max();
+}
+
+Void BVH::subdivide(UInt32 nodeIndex, UInt32 depth, BuildContext& context)
+{
+    BVHNode& node = nodes[nodeIndex];
+    if (node.count <= 2 || depth >= MAX_DEPTH)
+    {
+        return;
+    }
+
+    const UInt32 first = node.leftOrFirst;
+    const UInt32 count = node.count;
+
+    BoundingBox centroidsBounds = BoundingBox::s_empty();
+    for (UInt32 i = first; i < first + count; ++i)
+    {
+        centroidsBounds.grow(context.centroids[primitiveIndexes[i]]);
+    }
+
+    // Binned SAH, cost of split is area of child multiplied by its primitives count
+    Float32 bestCost = Limits<Float32>::max();
+    Int32 bestAxis = -1;
+    UInt32 bestSplit = 0;
+    for (Int32 axis = 0; axis < 3; ++axis)
+    {
+        const Float32 axisMinimum = centroidsBounds.minimum[axis];
+        const Float32 axisMaximum = centroidsBounds.maximum[axis];
+        if (axisMinimum >= axisMaximum)
+        {
+            continue;
+        }
+
+        Array<BVHBin, BINS_COUNT> bins{};
+        const Float32 scale = Float32(BINS_COUNT) / (axisMaximum - axisMinimum);
+        for (UInt32 i = first; i < first + count; ++i)
+        {
+            const UInt32 primitive = primitiveIndexes[i];
+            const UInt32 binIndex = std::min(BINS_COUNT - 1,
+                                             UInt32((context.centroids[primitive][axis] - axisMinimum) * scale));
+            bins[binIndex].count++;
+            bins[binIndex].bounds.grow(context.primitivesBounds[primitive]);
+        }
+
+        Array<Float32, BINS_COUNT - 1> leftAreas, rightAreas;
+        Array<UInt32, BINS_COUNT - 1> leftCounts, rightCounts;
+        BoundingBox leftBox = BoundingBox::s_empty();
+        BoundingBox rightBox = BoundingBox::s_empty();
+        UInt32 leftSum = 0, rightSum = 0;
+        for (UInt32 i = 0; i < BINS_COUNT - 1; ++i)
+        {
+            leftSum += bins[i].count;
+            leftCounts[i] = leftSum;
+            leftBox.grow(bins[i].bounds);
+            leftAreas[i] = leftBox.get_surface_area();
+
+            rightSum += bins[BINS_COUNT - 1 - i].count;
+            rightCounts[BINS_COUNT - 2 - i] = rightSum;
+            rightBox.grow(bins[BINS_COUNT - 1 - i].bounds);
+            rightAreas[BINS_COUNT - 2 - i] = rightBox.get_surface_area();
+        }
+
+        for (UInt32 i = 0; i < BINS_COUNT - 1; ++i)
+        {
+            if (leftCounts[i] == 0 || rightCounts[i] == 0)
+            {
+                continue;
+            }
+
+            const Float32 cost = Float32(leftCounts[i]) * leftAreas[i] + Float32(rightCounts[i]) * rightAreas[i];
+            if (cost < bestCost)
+            {
+                bestCost = cost;
+                bestAxis = axis;
+                bestSplit = i;
+            }
+        }
+    }
+
+    const BoundingBox nodeBounds{ node.minimum, node.maximum };
+    const Float32 leafCost = Float32(count) * nodeBounds.get_surface_area();
+    if (bestAxis < 0 || (count <= MAX_LEAF_SIZE && bestCost >= leafCost))
+    {
+        return;
+    }
+
+    const Float32 axisMinimum = centroidsBounds.minimum[bestAxis];
+    const Float32 scale = Float32(BINS_COUNT) / (centroidsBounds.maximum[bestAxis] - axisMinimum);
+    const auto isLeft = [&](UInt32 primitive)
+    {
+        const UInt32 binIndex = std::min(BINS_COUNT - 1,
+                                         UInt32((context.centroids[primitive][bestAxis] - axisMinimum) * scale));
+        return binIndex <= bestSplit;
+    };
+    const UInt32 middle = UInt32(std::partition(primitiveIndexes.begin() + first,
+                                                primitiveIndexes.begin() + first + count,
+                                                isLeft) - primitiveIndexes.begin());
+    const UInt32 leftCount = middle - first;
+    if (leftCount == 0 || leftCount == count)
+    {
+        return;
+    }
+
+    const UInt32 leftIndex = context.nodesCount.fetch_add(2);
+    BVHNode& left  = nodes[leftIndex];
+    BVHNode& right = nodes[leftIndex + 1];
+    left.leftOrFirst  = first;
+    left.count        = leftCount;
+    right.leftOrFirst = middle;
+    right.count       = count - leftCount;
+    update_node_bounds(left, context.primitivesBounds);
+    update_node_bounds(right, context.primitivesBounds);
+
+    node.leftOrFirst = leftIndex;
+    node.count = 0;
+
+    if (context.threadPool && count > PARALLEL_THRESHOLD)
+    {
+        std::future<Void> leftTask = context.threadPool->submit([this, leftIndex, depth, &context]()
+        {
+            subdivide(leftIndex, depth + 1, context);
+        });
+        subdivide(leftIndex + 1, depth + 1, context);
+        context.threadPool->wait(leftTask);
+    } else {
+        subdivide(leftIndex, depth + 1, context);
+        subdivide(leftIndex + 1, depth + 1, context);
+    }
+}
+
+Void BVH::update_node_bounds(BVHNode& node, const DynamicArray<BoundingBox>& primitivesBounds) const
+{
+    BoundingBox bounds = BoundingBox::s_empty();
+    for (UInt32 i = node.leftOrFirst; i < node.leftOrFirst + node.count; ++i)
+    {
+        bounds.grow(primitivesBounds[primitiveIndexes[i]]);
+    }
+    node.minimum = bounds.minimum;
+    node.maximum = bounds.maximum;
+}
+
+
+Void MeshBVH::build(const DynamicArray<Vertex>& vertexes,
+                    const DynamicArray<UInt32>& indexes,
+                    ThreadPool* threadPool)
+{
+    const DynamicArray<BoundingBox> trianglesBounds = s_compute_triangles_bounds(vertexes, indexes, threadPool);
+    bvh.build(trianglesBounds, threadPool);
+    gather_corners(vertexes, indexes);
+}
+
+Void MeshBVH::refit(const DynamicArray<Vertex>& vertexes, const DynamicArray<UInt32>& indexes)
+{
+    if (bvh.get_primitive_indexes().size() * 3 != indexes.size())
+    {
+        SPDLOG_ERROR("Mesh BVH refit failed, triangles count changed from {} to {}.",
+                     bvh.get_primitive_indexes().size(), indexes.size() / 3);
+        return;
+    }
+
+    bvh.refit(s_compute_triangles_bounds(vertexes, indexes, nullptr));
+    gather_corners(vertexes, indexes);
+}
+
+Bool MeshBVH::intersect(const Ray& ray, RayHit& hit) const
+{
+    if (bvh.is_empty())
+    {
+        return false;
+    }
+
+    constexpr Float32 EPSILON = 1e-8f;
+    const DynamicArray<BVHNode>& nodes = bvh.get_nodes();
+    const DynamicArray<UInt32>& primitiveIndexes = bvh.get_primitive_indexes();
+    const FVector3 inverseDirection = 1.0f / ray.direction;
+    Float32 closest = std::min(ray.maxDistance, hit.distance);
+    Bool isHit = false;
+
+    Array<UInt32, BVH::TRAVERSAL_STACK_SIZE> stack;
+    UInt32 stackSize = 0;
+    if (BVH::s_intersect_box(nodes[0], ray.origin, inverseDirection, closest) == Limits<Float32>::max())
+    {
+        return false;
+    }
+    stack[stackSize++] = 0;
+
+    while (stackSize > 0)
+    {
+        const BVHNode& node = nodes[stack[--stackSize]];
+        if (node.is_leaf())
+        {
+            for (UInt32 i = node.leftOrFirst; i < node.leftOrFirst + node.count; ++i)
+            {
+                // Moller-Trumbore
+                const FVector3& vertex0 = corners[3ULL * i];
+                const FVector3 edge1 = corners[3ULL * i + 1] - vertex0;
+                const FVector3 edge2 = corners[3ULL * i + 2] - vertex0;
+                const FVector3 p = glm::cross(ray.direction, edge2);
+                const Float32 determinant = glm::dot(edge1, p);
+                if (std::abs(determinant) < EPSILON)
+                {
+                    continue;
+                }
+
+                const Float32 inverseDeterminant = 1.0f / determinant;
+                const FVector3 t = ray.origin - vertex0;
+                const Float32 u = glm::dot(t, p) * inverseDeterminant;
+                if (u < 0.0f || u > 1.0f)
+                {
+                    continue;
+                }
+
+                const FVector3 q = glm::cross(t, edge1);
+                const Float32 v = glm::dot(ray.direction, q) * inverseDeterminant;
+                if (v < 0.0f || u + v > 1.0f)
+                {
+                    continue;
+                }
+
+                const Float32 distance = glm::dot(edge2, q) * inverseDeterminant;
+                if (distance > 0.0f && distance < closest)
+                {
+                    closest = distance;
+                    hit.distance = distance;
+                    hit.triangleIndex = primitiveIndexes[i];
+                    hit.barycentric = { u, v };
+                    isHit = true;
+                }
+            }
+            continue;
+        }
+
+        // Nearer child is pushed last, so it's visited first and shrinks search for the other one
+        UInt32 nearIndex = node.leftOrFirst;
+        UInt32 farIndex  = node.leftOrFirst + 1;
+        Float32 nearDistance = BVH::s_intersect_box(nodes[nearIndex], ray.origin, inverseDirection, closest);
+        Float32 farDistance  = BVH::s_intersect_box(nodes[farIndex], ray.origin, inverseDirection, closest);
+        if (farDistance < nearDistance)
+        {
+            std::swap(nearIndex, farIndex);
+            std::swap(nearDistance, farDistance);
+        }
+
+        if (farDistance != Limits<Float32>::max())
+        {
+            stack[stackSize++] = farIndex;
+        }
+        if (nearDistance != Limits<Float32>::max())
+        {
+            stack[stackSize++] = nearIndex;
+        }
+    }
+
+    return isHit;
+}
+
+Void MeshBVH::overlap(const BoundingBox& box, DynamicArray<UInt32>& triangles) const
+{
+    if (bvh.is_empty())
+    {
+        return;
+    }
+
+    const DynamicArray<BVHNode>& nodes = bvh.get_nodes();
+    const DynamicArray<UInt32>& primitiveIndexes = bvh.get_primitive_indexes();
+    Array<UInt32, BVH::TRAVERSAL_STACK_SIZE> stack;
+    UInt32 stackSize = 0;
+    stack[stackSize++] = 0;
+
+    while (stackSize > 0)
+    {
+        const BVHNode& node = nodes[stack[--stackSize]];
+        if (!box.overlaps({ node.minimum, node.maximum }))
+        {
+            continue;
+        }
+
+        if (!node.is_leaf())
+        {
+            stack[stackSize++] = node.leftOrFirst;
+            stack[stackSize++] = node.leftOrFirst + 1;
+            continue;
+        }
+
+        for (UInt32 i = node.leftOrFirst; i < node.leftOrFirst + node.count; ++i)
+        {
+            BoundingBox triangleBox = BoundingBox::s_empty();
+            triangleBox.grow(corners[3ULL * i]);
+            triangleBox.grow(corners[3ULL * i + 1]);
+            triangleBox.grow(corners[3ULL * i + 2]);
+            if (box.overlaps(triangleBox))
+            {
+                triangles.push_back(primitiveIndexes[i]);
+            }
+        }
+    }
+}
+
+Bool MeshBVH::is_empty() const
+{
+    return bvh.is_empty();
+}
+
+const BVH& MeshBVH::get_bvh() const
+{
+    return bvh;
+}
+
+DynamicArray<BoundingBox> MeshBVH::s_compute_triangles_bounds(const DynamicArray<Vertex>& vertexes,
+                                                              const DynamicArray<UInt32>& indexes,
+                                                              ThreadPool* threadPool)
+{
+    DynamicArray<BoundingBox> trianglesBounds(indexes.size() / 3);
+    const auto computeRange = [&](UInt64 begin, UInt64 end)
+    {
+        for (UInt64 i = begin; i < end; ++i)
+        {
+            BoundingBox& bounds = trianglesBounds[i];
+            bounds = BoundingBox::s_empty();
+            bounds.grow(vertexes[indexes[3 * i]].position);
+            bounds.grow(vertexes[indexes[3 * i + 1]].position);
+            bounds.grow(vertexes[indexes[3 * i + 2]].position);
+        }
+    };
+
+    if (threadPool)
+    {
+        threadPool->parallel_for(trianglesBounds.size(), BVH::PARALLEL_THRESHOLD, computeRange);
+    } else {
+        computeRange(0, trianglesBounds.size());
+    }
+
+    return trianglesBounds;
+}
+
+Void MeshBVH::gather_corners(const DynamicArray<Vertex>& vertexes, const DynamicArray<UInt32>& indexes)
+{
+    const DynamicArray<UInt32>& primitiveIndexes = bvh.get_primitive_indexes();
+    corners.resize(primitiveIndexes.size() * 3);
+    for (UInt64 i = 0; i < primitiveIndexes.size(); ++i)
+    {
+        const UInt64 triangle = primitiveIndexes[i];
+        corners[3 * i]     = vertexes[indexes[3 * triangle]].position;
+        corners[3 * i + 1] = vertexes[indexes[3 * triangle + 1]].position;
+        corners[3 * i + 2] = vertexes[indexes[3 * triangle + 2]].position;
+    }
+}
+
+
+Handle<BVHInstance> SceneBVH::add_instance(UInt64 meshId, const BoundingBox& localBounds, const FMatrix4& transform)
+{
+    const Handle<BVHInstance> handle{ instances.size() };
+    BVHInstance& instance = instances.emplace_back();
+    instance.transform = transform;
+    instance.inverseTransform = glm::inverse(transform);
+    instance.localBounds = localBounds;
+    instance.bounds = localBounds.transformed(transform);
+    instance.meshId = meshId;
+    instancesBounds.push_back(instance.bounds);
+    isBuilt = false;
+
+    return handle;
+}
+
+Void SceneBVH::set_transform(Handle<BVHInstance> handle, const FMatrix4& transform)
+{
+    if (handle.id >= instances.size())
+    {
+        SPDLOG_ERROR("Failed to set transform of instance with handle {}.", handle.id);
+        return;
+    }
+
+    BVHInstance& instance = instances[handle.id];
+    instance.transform = transform;
+    instance.inverseTransform = glm::inverse(transform);
+    instance.bounds = instance.localBounds.transformed(transform);
+    instancesBounds[handle.id] = instance.bounds;
+    hasMoved = true;
+}
+
+Void SceneBVH::update(ThreadPool* threadPool)
+{
+    if (!isBuilt)
+    {
+        build(threadPool);
+        return;
+    }
+
+    if (!hasMoved)
+    {
+        return;
+    }
+
+    refit();
+    // Refitted tree degrades when instances move far apart, then it's cheaper to rebuild it
+    const BVHNode& root = bvh.get_nodes()[0];
+    if (BoundingBox(root.minimum, root.maximum).get_surface_area() > builtRootArea * REBUILD_AREA_RATIO)
+    {
+        build(threadPool);
+    }
+}
+
+Void SceneBVH::build(ThreadPool* threadPool)
+{
+    bvh.build(instancesBounds, threadPool);
+    builtRootArea = 0.0f;
+    if (!bvh.is_empty())
+    {
+        const BVHNode& root = bvh.get_nodes()[0];
+        builtRootArea = BoundingBox(root.minimum, root.maximum).get_surface_area();
+    }
+    isBuilt = true;
+    hasMoved = false;
+}
+
+Void SceneBVH::refit()
+{
+    bvh.refit(instancesBounds);
+    hasMoved = false;
+}
+
+Bool SceneBVH::intersect(const Ray& ray, const DynamicArray<MeshBVH>& meshesBVH, RayHit& hit) const
+{
+    if (bvh.is_empty())
+    {
+        return false;
+    }
+
+    const DynamicArray<BVHNode>& nodes = bvh.get_nodes();
+    const DynamicArray<UInt32>& primitiveIndexes = bvh.get_primitive_indexes();
+    const FVector3 inverseDirection = 1.0f / ray.direction;
+    Bool isHit = false;
+
+    Array<UInt32, BVH::TRAVERSAL_STACK_SIZE> stack;
+    UInt32 stackSize = 0;
+    stack[stackSize++] = 0;
+
+    while (stackSize > 0)
+    {
+        const BVHNode& node = nodes[stack[--stackSize]];
+        const Float32 closest = std::min(ray.maxDistance, hit.distance);
+        if (BVH::s_intersect_box(node, ray.origin, inverseDirection, closest) == Limits<Float32>::max())
+        {
+            continue;
+        }
+
+        if (!node.is_leaf())
+        {
+            stack[stackSize++] = node.leftOrFirst;
+            stack[stackSize++] = node.leftOrFirst + 1;
+            continue;
+        }
+
+        for (UInt32 i = node.leftOrFirst; i < node.leftOrFirst + node.count; ++i)
+        {
+            const UInt32 instanceIndex = primitiveIndexes[i];
+            const BVHInstance& instance = instances[instanceIndex];
+            if (instance.meshId >= meshesBVH.size())
+            {
+                continue;
+            }
+
+            // Direction is not normalized, so distance in local space stays the same as in world space
+            Ray localRay;
+            localRay.origin = FVector3(instance.inverseTransform * FVector4(ray.origin, 1.0f));
+            localRay.direction = FVector3(instance.inverseTransform * FVector4(ray.direction, 0.0f));
+            localRay.maxDistance = closest;
+            if (meshesBVH[instance.meshId].intersect(localRay, hit))
+            {
+                hit.instanceHandle = { instanceIndex };
+                isHit = true;
+            }
+        }
+    }
+
+    return isHit;
+}
+
+Void SceneBVH::overlap(const BoundingBox& box, DynamicArray<Handle<BVHInstance>>& result) const
+{
+    if (bvh.is_empty())
+    {
+        return;
+    }
+
+    const DynamicArray<BVHNode>& nodes = bvh.get_nodes();
+    const DynamicArray<UInt32>& primitiveIndexes = bvh.get_primitive_indexes();
+    Array<UInt32, BVH::TRAVERSAL_STACK_SIZE> stack;
+    UInt32 stackSize = 0;
+    stack[stackSize++] = 0;
+
+    while (stackSize > 0)
+    {
+        const BVHNode& node = nodes[stack[--stackSize]];
+        if (!box.overlaps({ node.minimum, node.maximum }))
+        {
+            continue;
+        }
+
+        if (!node.is_leaf())
+        {
+            stack[stackSize++] = node.leftOrFirst;
+            stack[stackSize++] = node.leftOrFirst + 1;
+            continue;
+        }
+
+        for (UInt32 i = node.leftOrFirst; i < node.leftOrFirst + node.count; ++i)
+        {
+            if (box.overlaps(instances[primitiveIndexes[i]].bounds))
+            {
+                result.push_back({ primitiveIndexes[i] });
+            }
+        }
+    }
+}
+
+Void SceneBVH::cull(const Array<FVector4, 6>& planes, DynamicArray<Handle<BVHInstance>>& result) const
+{
+    if (bvh.is_empty())
+    {
+        return;
+    }
+
+    const DynamicArray<BVHNode>& nodes = bvh.get_nodes();
+    const DynamicArray<UInt32>& primitiveIndexes = bvh.get_primitive_indexes();
+    Array<UInt32, BVH::TRAVERSAL_STACK_SIZE> stack;
+    UInt32 stackSize = 0;
+    stack[stackSize++] = 0;
+
+    while (stackSize > 0)
+    {
+        const UInt32 nodeIndex = stack[--stackSize];
+        const BVHNode& node = nodes[nodeIndex];
+
+        const EFrustumTest test = s_test_frustum(planes, { node.minimum, node.maximum });
+        if (test == EFrustumTest::Outside)
+        {
+            continue;
+        }
+
+        // Whole subtree is visible, so there is no need to test its nodes
+        if (test == EFrustumTest::Inside)
+        {
+            collect_subtree(nodeIndex, result);
+            continue;
+        }
+
+        if (!node.is_leaf())
+        {
+            stack[stackSize++] = node.leftOrFirst;
+            stack[stackSize++] = node.leftOrFirst + 1;
+            continue;
+        }
+
+        for (UInt32 i = node.leftOrFirst; i < node.leftOrFirst + node.count; ++i)
+        {
+            if (s_test_frustum(planes, instances[primitiveIndexes[i]].bounds) != EFrustumTest::Outside)
+            {
+                result.push_back({ primitiveIndexes[i] });
+            }
+        }
+    }
+}
+
+Void SceneBVH::clear()
+{
+    bvh.clear();
+    instances.clear();
+    instancesBounds.clear();
+    builtRootArea = 0.0f;
+    isBuilt = false;
+    hasMoved = false;
+}
+
+const BVHInstance& SceneBVH::get_instance(Handle<BVHInstance> handle) const
+{
+    return instances[handle.id];
+}
+
+const DynamicArray<BVHInstance>& SceneBVH::get_instances() const
+{
+    return instances;
+}
+
+Void SceneBVH::collect_subtree(UInt32 nodeIndex, DynamicArray<Handle<BVHInstance>>& result) const
+{
+    // Leaves of subtree hold continuous range of primitives
+    const DynamicArray<BVHNode>& nodes = bvh.get_nodes();
+    UInt32 firstNode = nodeIndex;
+    UInt32 lastNode = nodeIndex;
+    while (!nodes[firstNode].is_leaf())
+    {
+        firstNode = nodes[firstNode].leftOrFirst;
+    }
+    while (!nodes[lastNode].is_leaf())
+    {
+        lastNode = nodes[lastNode].leftOrFirst + 1;
+    }
+
+    const DynamicArray<UInt32>& primitiveIndexes = bvh.get_primitive_indexes();
+    const UInt32 end = nodes[lastNode].leftOrFirst + nodes[lastNode].count;
+    for (UInt32 i = nodes[firstNode].leftOrFirst; i < end; ++i)
+    {
+        result.push_back({ primitiveIndexes[i] });
+    }
+}
+
+SceneBVH::EFrustumTest SceneBVH::s_test_frustum(const Array<FVector4, 6>& planes, const BoundingBox& box)
+{
+    const FVector3 center = box.get_center();
+    const FVector3 extent = box.get_extent();
+    EFrustumTest result = EFrustumTest::Inside;
+    for (const FVector4& plane : planes)
+    {
+        const Float32 distance = glm::dot(FVector3(plane), center) + plane.w;
+        const Float32 radius = glm::dot(glm::abs(FVector3(plane)), extent);
+        if (distance + radius < 0.0f)
+        {
+            return EFrustumTest::Outside;
+        }
+
+        if (distance - radius < 0.0f)
+        {
+            result = EFrustumTest::Intersect;
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,167 @@
+#pragma once
+#include "bounds.hpp"
+
+class ThreadPool;
+struct Vertex;
+
+struct Ray
+{
+    FVector3 origin;
+    FVector3 direction;
+    Float32 maxDistance = Limits<Float32>::max();
+};
+
+struct BVHInstance
+{
+    FMatrix4 transform;
+    FMatrix4 inverseTransform;
+    BoundingBox localBounds;
+    BoundingBox bounds;
+    UInt64 meshId;
+};
+
+struct RayHit
+{
+    Float32 distance = Limits<Float32>::max();
+    UInt32 triangleIndex = Limits<UInt32>::max();
+    Handle<BVHInstance> instanceHandle = Handle<BVHInstance>::NONE;
+    FVector2 barycentric{ 0.0f };
+};
+
+/** 32 bytes, so two nodes fit in cache line. Children are always stored next to each other */
+struct BVHNode
+{
+    FVector3 minimum;
+    UInt32 leftOrFirst; // Left child for inner node, first primitive for leaf
+    FVector3 maximum;
+    UInt32 count;       // Primitives count, 0 for inner node
+
+    [[nodiscard]]
+    Bool is_leaf() const
+    {
+        return count > 0;
+    }
+};
+static_assert(sizeof(BVHNode) == 32);
+
+/** Binned SAH hierarchy over primitive bounds, shared by mesh and scene levels */
+class BVH
+{
+public:
+    static constexpr UInt32 BINS_COUNT = 16;
+    static constexpr UInt32 MAX_LEAF_SIZE = 8;
+    // Primitives count above which children are built on different threads
+    static constexpr UInt32 PARALLEL_THRESHOLD = 4096;
+    // Depth first traversal keeps at most one sibling per level, so stack of depth plus root never overflows
+    static constexpr UInt32 MAX_DEPTH = 63;
+    static constexpr UInt32 TRAVERSAL_STACK_SIZE = MAX_DEPTH + 1;
+
+private:
+    struct BuildContext;
+
+    DynamicArray<BVHNode> nodes;
+    DynamicArray<UInt32> primitiveIndexes;
+
+public:
+    Void build(const DynamicArray<BoundingBox>& primitivesBounds, ThreadPool* threadPool = nullptr);
+    // Keeps topology and only recomputes bounds, children always have bigger index than parent
+    Void refit(const DynamicArray<BoundingBox>& primitivesBounds);
+
+    Void clear();
+
+    [[nodiscard]]
+    Bool is_empty() const;
+    [[nodiscard]]
+    const DynamicArray<BVHNode>& get_nodes() const;
+    [[nodiscard]]
+    const DynamicArray<UInt32>& get_primitive_indexes() const;
+
+    // Returns distance to box or max float if ray misses it
+    static Float32 s_intersect_box(const BVHNode& node,
+                                   const FVector3& origin,
+                                   const FVector3& inverseDirection,
+                                   Float32 maxDistance);
+
+private:
+    // Nodes at max depth stay leaves, skewed splits could otherwise nest deeper than traversal stack
+    Void subdivide(UInt32 nodeIndex, UInt32 depth, BuildContext& context);
+    Void update_node_bounds(BVHNode& node, const DynamicArray<BoundingBox>& primitivesBounds) const;
+};
+
+/** Bottom level hierarchy over triangles of single mesh, in mesh local space */
+class MeshBVH
+{
+private:
+    BVH bvh;
+    // Triangle corners in leaf order, 3 per triangle
+    DynamicArray<FVector3> corners;
+
+public:
+    Void build(const DynamicArray<Vertex>& vertexes,
+               const DynamicArray<UInt32>& indexes,
+               ThreadPool* threadPool = nullptr);
+    // For deformed vertexes with the same indexes
+    Void refit(const DynamicArray<Vertex>& vertexes, const DynamicArray<UInt32>& indexes);
+
+    Bool intersect(const Ray& ray, RayHit& hit) const;
+    Void overlap(const BoundingBox& box, DynamicArray<UInt32>& triangles) const;
+
+    [[nodiscard]]
+    Bool is_empty() const;
+    [[nodiscard]]
+    const BVH& get_bvh() const;
+
+private:
+    static DynamicArray<BoundingBox> s_compute_triangles_bounds(const DynamicArray<Vertex>& vertexes,
+                                                                const DynamicArray<UInt32>& indexes,
+                                                                ThreadPool* threadPool);
+    Void gather_corners(const DynamicArray<Vertex>& vertexes, const DynamicArray<UInt32>& indexes);
+};
+
+/** Top level hierarchy over mesh instances in world space */
+class SceneBVH
+{
+public:
+    // Refit is replaced by rebuild when tree got this much bigger than after build
+    static constexpr Float32 REBUILD_AREA_RATIO = 2.0f;
+
+private:
+    enum class EFrustumTest : UInt8
+    {
+        Outside = 0U,
+        Intersect,
+        Inside,
+    };
+
+    BVH bvh;
+    DynamicArray<BVHInstance> instances;
+    DynamicArray<BoundingBox> instancesBounds;
+    Float32 builtRootArea = 0.0f;
+    Bool isBuilt = false;
+    Bool hasMoved = false;
+
+public:
+    Handle<BVHInstance> add_instance(UInt64 meshId, const BoundingBox& localBounds, const FMatrix4& transform);
+    Void set_transform(Handle<BVHInstance> handle, const FMatrix4& transform);
+
+    // Builds after instances were added, refits after instances were moved
+    Void update(ThreadPool* threadPool = nullptr);
+    Void build(ThreadPool* threadPool = nullptr);
+    Void refit();
+
+    Bool intersect(const Ray& ray, const DynamicArray<MeshBVH>& meshesBVH, RayHit& hit) const;
+    Void overlap(const BoundingBox& box, DynamicArray<Handle<BVHInstance>>& result) const;
+    // Planes in format returned by FrustumCuller::s_extract_planes
+    Void cull(const Array<FVector4, 6>& planes, DynamicArray<Handle<BVHInstance>>& result) const;
+
+    Void clear();
+
+    [[nodiscard]]
+    const BVHInstance& get_instance(Handle<BVHInstance> handle) const;
+    [[nodiscard]]
+    const DynamicArray<BVHInstance>& get_instances() const;
+
+private:
+    Void collect_subtree(UInt32 nodeIndex, DynamicArray<Handle<BVHInstance>>& result) const;
+    static EFrustumTest s_test_frustum(const Array<FVector4, 6>& planes, const BoundingBox& box);
+};
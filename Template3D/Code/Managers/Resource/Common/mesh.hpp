@@ -1,5 +1,6 @@
 #pragma once
 #include "vertex.hpp"
+#include "bounds.hpp"
 
 template<typename API>
 struct Mesh 
@@ -7,6 +8,8 @@ struct Mesh
     DynamicArray<Vertex> vertexes;
     DynamicArray<UInt32> indexes;
     String name;
+    BoundingBox boundingBox;
+    BoundingSphere boundingSphere;
     Handle<typename API::Buffer> vertexesHandle;
     Handle<typename API::Buffer> indexesHandle;
 
@@ -20,6 +20,9 @@ enum class ETextureType : Int16
     Count,
 };
 
+// Matches discard threshold of default fragment shaders
+inline constexpr Float32 ALPHA_TEST_THRESHOLD = 0.1f;
+
 template<typename API>
 struct Texture 
 {
@@ -28,6 +31,8 @@ struct Texture
     UInt8* data; //TODO: change it to DynamicArray after changing image loading library
     Int32 channels; //TODO: change it to UInt8 after changing image loading library
     ETextureType type;
+    // Some texel has alpha below ALPHA_TEST_THRESHOLD, only then materials need alpha test variant
+    Bool hasCutoutTexels;
     Handle<typename API::Image> imageHandle;
 
     Texture()
@@ -35,5 +40,6 @@ struct Texture
         , data(nullptr)
         , channels(0)
         , type(ETextureType::None)
+        , hasCutoutTexels(false)
     {}
 };
\ No newline at end of file
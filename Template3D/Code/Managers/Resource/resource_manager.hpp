@@ -1,5 +1,6 @@
 #pragma once
 #include "Common/vertex.hpp"
+#include "Common/bvh.hpp"
 #include "Render/Common/graphics_api_concept.hpp"
 
 
@@ -28,6 +29,7 @@ struct Model;
 template<typename API>
 struct Mesh;
 enum class ETextureType : Int16;
+class ThreadPool;
 
 template <GraphicsAPI API>
 class ResourceManager
@@ -49,6 +51,9 @@ private:
     HashMap<String, Handle<Texture<API>>> texturesNameMap;
     DynamicArray<Texture<API>> textures;
 
+    DynamicArray<MeshBVH> meshesBVH;
+    SceneBVH sceneBVH;
+
 public:
     Void startup();
 
@@ -81,6 +86,14 @@ public:
     Texture<API>  &get_texture(const String &name);
     Texture<API>  &get_texture(const Handle<Texture<API>> handle);
 
+    // Builds hierarchies of meshes added since last call
+    Void build_meshes_bvh(ThreadPool& threadPool);
+    Handle<BVHInstance> create_instance(const Handle<Mesh<API>> meshHandle, const FMatrix4& transform);
+    Void set_instance_transform(const Handle<BVHInstance> handle, const FMatrix4& transform);
+    Void update_scene_bvh(ThreadPool& threadPool);
+    Void clear_instances();
+    Bool ray_cast(const Ray& ray, RayHit& hit) const;
+
     [[nodiscard]]
     const Handle<Model<API>>    &get_model_handle(const String &name)	 const;
     [[nodiscard]]
@@ -98,10 +111,18 @@ public:
     const DynamicArray<Material<API>> &get_materials() const;
     [[nodiscard]]
     const DynamicArray<Texture<API>>  &get_textures()  const;
+    [[nodiscard]]
+    const MeshBVH &get_mesh_bvh(const Handle<Mesh<API>> handle) const;
+    [[nodiscard]]
+    const SceneBVH &get_scene_bvh() const;
 
     Void shutdown();
 
 private:
+    static Void compute_bounds(Mesh<API>& mesh);
+    // Scanned once at load, so variant selection does not read texels
+    static Void compute_cutout(Texture<API>& texture);
+
     template<typename DataType, typename ArrayType>
     static Void process_accessor(tinygltf::Model& gltfModel,
                                  const tinygltf::Accessor& accessor,
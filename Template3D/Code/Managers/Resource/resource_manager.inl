@@ -316,6 +316,8 @@ Handle<Mesh<API>> ResourceManager<API>::load_mesh(const String& meshName, tinygl
 
     process_accessor<FVector2>(gltfModel, positionsAccessor, mesh.vertexes, offsetof(Vertex, uv));
 
+    compute_bounds(mesh);
+
     const Handle<Mesh<API>> meshHandle{ meshId };
     meshesNameMap[meshName] = meshHandle;
     mesh.name = meshName;
@@ -448,6 +450,8 @@ Handle<Texture<API>> ResourceManager<API>::load_texture(const String& filePath,
         return Handle<Texture<API>>::NONE;
     }
 
+    compute_cutout(texture);
+
     const Handle<Texture<API>> textureHandle{ textureId };
     texturesNameMap[textureName] = textureHandle;
     texture.name = textureName;
@@ -488,7 +492,7 @@ Handle<Mesh<API>> ResourceManager<API>::create_mesh(const Mesh<API>& mesh)
     const UInt64 meshId = meshes.size();
     const Handle<Mesh<API>> meshHandle{ meshId };
     meshesNameMap[mesh.name] = meshHandle;
-    meshes.push_back(mesh);
+    compute_bounds(meshes.emplace_back(mesh));
     return meshHandle;
 }
 
@@ -528,6 +532,7 @@ Handle<Texture<API>> ResourceManager<API>::create_texture(const UVector2& size,
     {
         texture.data[i] = fillColor[i & (4 - 1)]; // Faster modulo 4
     }
+    compute_cutout(texture);
     texture.name = name;
     return textureHandle;
 }
@@ -640,6 +645,54 @@ Texture<API>& ResourceManager<API>::get_texture(const Handle<Texture<API>> handl
     return textures[handle.id];
 }
 
+template <GraphicsAPI API>
+Void ResourceManager<API>::build_meshes_bvh(ThreadPool& threadPool)
+{
+    const UInt64 builtCount = meshesBVH.size();
+    meshesBVH.resize(meshes.size());
+    for (UInt64 i = builtCount; i < meshes.size(); ++i)
+    {
+        meshesBVH[i].build(meshes[i].vertexes, meshes[i].indexes, &threadPool);
+    }
+}
+
+template <GraphicsAPI API>
+Handle<BVHInstance> ResourceManager<API>::create_instance(const Handle<Mesh<API>> meshHandle, const FMatrix4& transform)
+{
+    if (meshHandle.id >= meshes.size())
+    {
+        SPDLOG_ERROR("Failed to create instance, mesh {} not found.", meshHandle.id);
+        return Handle<BVHInstance>::NONE;
+    }
+
+    return sceneBVH.add_instance(meshHandle.id, meshes[meshHandle.id].boundingBox, transform);
+}
+
+template <GraphicsAPI API>
+Void ResourceManager<API>::set_instance_transform(const Handle<BVHInstance> handle, const FMatrix4& transform)
+{
+    sceneBVH.set_transform(handle, transform);
+}
+
+template <GraphicsAPI API>
+Void ResourceManager<API>::update_scene_bvh(ThreadPool& threadPool)
+{
+    build_meshes_bvh(threadPool);
+    sceneBVH.update(&threadPool);
+}
+
+template <GraphicsAPI API>
+Void ResourceManager<API>::clear_instances()
+{
+    sceneBVH.clear();
+}
+
+template <GraphicsAPI API>
+Bool ResourceManager<API>::ray_cast(const Ray& ray, RayHit& hit) const
+{
+    return sceneBVH.intersect(ray, meshesBVH, hit);
+}
+
 template <GraphicsAPI API>
 const Handle<Model<API>>& ResourceManager<API>::get_model_handle(const String& name) const
 {
@@ -712,6 +765,24 @@ const DynamicArray<Texture<API>>& ResourceManager<API>::get_textures() const
     return textures;
 }
 
+template <GraphicsAPI API>
+const MeshBVH& ResourceManager<API>::get_mesh_bvh(const Handle<Mesh<API>> handle) const
+{
+    if (handle.id >= meshesBVH.size())
+    {
+        static const MeshBVH EMPTY_BVH;
+        SPDLOG_WARN("BVH of mesh {} not found, returned empty.", handle.id);
+        return EMPTY_BVH;
+    }
+    return meshesBVH[handle.id];
+}
+
+template <GraphicsAPI API>
+const SceneBVH& ResourceManager<API>::get_scene_bvh() const
+{
+    return sceneBVH;
+}
+
 template <GraphicsAPI API>
 Void ResourceManager<API>::shutdown()
 {
@@ -726,6 +797,9 @@ Void ResourceManager<API>::shutdown()
     materialsNameMap.clear();
     materials.clear();
 
+    sceneBVH.clear();
+    meshesBVH.clear();
+
     meshesNameMap.clear();
     meshes.clear();
 
@@ -733,6 +807,63 @@ Void ResourceManager<API>::shutdown()
     models.clear();
 }
 
+template <GraphicsAPI API>
+Void ResourceManager<API>::compute_cutout(Texture<API>& texture)
+{
+    texture.hasCutoutTexels = false;
+    // Only 8 bit RGBA textures are uploaded with alpha
+    if (texture.data == nullptr || texture.type == ETextureType::HDR || texture.channels != 4)
+    {
+        return;
+    }
+
+    // Texel is discarded when alpha / 255 < threshold
+    const UInt32 threshold = UInt32(std::ceil(ALPHA_TEST_THRESHOLD * 255.0f));
+    const UInt64 texelsCount = UInt64(texture.size.x) * UInt64(texture.size.y);
+    for (UInt64 i = 0; i < texelsCount; ++i)
+    {
+        if (texture.data[i * 4 + 3] < threshold)
+        {
+            texture.hasCutoutTexels = true;
+            return;
+        }
+    }
+}
+
+template <GraphicsAPI API>
+Void ResourceManager<API>::compute_bounds(Mesh<API>& mesh)
+{
+    if (mesh.vertexes.empty())
+    {
+        mesh.boundingBox = {};
+        mesh.boundingSphere = {};
+        return;
+    }
+
+    FVector3 minimum(Limits<Float32>::max());
+    FVector3 maximum(Limits<Float32>::lowest());
+    for (const Vertex& vertex : mesh.vertexes)
+    {
+        minimum = glm::min(minimum, vertex.position);
+        maximum = glm::max(maximum, vertex.position);
+    }
+
+    mesh.boundingBox.minimum = minimum;
+    mesh.boundingBox.maximum = maximum;
+
+    // Sphere shares center with box, so culling can test both volumes with one distance
+    const FVector3 center = (minimum + maximum) * 0.5f;
+    Float32 radiusSquared = 0.0f;
+    for (const Vertex& vertex : mesh.vertexes)
+    {
+        const FVector3 offset = vertex.position - center;
+        radiusSquared = std::max(radiusSquared, glm::dot(offset, offset));
+    }
+
+    mesh.boundingSphere.center = center;
+    mesh.boundingSphere.radius = std::sqrt(radiusSquared);
+}
+
 template <GraphicsAPI API>
 template <typename DataType, typename ArrayType>
 Void ResourceManager<API>::process_accessor(tinygltf::Model& gltfModel, const tinygltf::Accessor& accessor, DynamicArray<ArrayType>& outputData)
@@ -9,6 +9,7 @@ Int32 main()
 {
     Simulation<Vulkan> simulation;
     // simulation.startup();
+    simulation.threadPool.startup();
     simulation.displayManager.startup();
     DisplayManager& displayManager = simulation.displayManager;
     simulation.resourceManager.startup();
@@ -22,6 +23,7 @@ Int32 main()
     {
         displayManager.poll_events();
         simulation.renderManager.draw_model(simulation, simulation.resourceManager.get_default_model());
+        simulation.renderManager.render(simulation);
         displayManager.swap_buffers();
     }
 